@@ -0,0 +1,114 @@
+/*
+        Recursive basic_parser against basic_iterative_parser, ie
+                ./gjson_bench [megabytes]
+        prints MB/s for a wide document and a deep one, and for the wide
+        one skipping every array and with size_hints, with and without
+        use_structural_index. The maker only counts, so it's the parsers
+        being timed and not building a tree. gjson_bench_no_index is the
+        same built with GJSON_NO_STRUCTURAL_INDEX
+ */
+#include "gjson/basic_parser.h"
+#include "gjson/iterative_parser.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace gjson;
+
+namespace{
+        struct counting_maker{
+                void begin_map(){ ++count; }
+                void end_map(){ ++count; }
+                void begin_array(){ ++count; }
+                void end_array(){ ++count; }
+                void make_string(std::string const& value){ count += value.size(); }
+                void make_int(std::int64_t value){ count += static_cast<std::size_t>(value & 1); }
+                void make_float(double value){ ++count; }
+                void make_null(){ ++count; }
+                void make_true(){ ++count; }
+                void make_false(){ ++count; }
+                std::size_t count{0};
+        };
+        struct skipping_maker : counting_maker{
+                maker_ctrl begin_array(){ ++count; return maker_ctrl::skip; }
+        };
+        struct hinted_maker : counting_maker{
+                using counting_maker::begin_map;
+                using counting_maker::begin_array;
+                void begin_map(std::size_t n){ count += n; }
+                void begin_array(std::size_t n){ count += n; }
+        };
+
+        std::string wide(std::size_t bytes){
+                std::string s = "[";
+                for(std::size_t i=0;s.size() < bytes;++i){
+                        if( i != 0 )
+                                s += ",";
+                        s += "{\"id\":" + std::to_string(i) + ",\"name\":\"record " + std::to_string(i) +
+                             "\",\"score\":" + std::to_string(i % 1000) + ".25,\"tags\":[\"a\",\"b\",[1,2,{\"c\":null}]],\"ok\":true}";
+                }
+                return s + "]";
+        }
+        std::string deep(std::size_t bytes){
+                std::string s;
+                std::size_t n = bytes / 16;
+                for(std::size_t i=0;i!=n;++i)
+                        s += "{\"a\":[1,";
+                s += "2";
+                for(std::size_t i=0;i!=n;++i)
+                        s += "]}";
+                return s;
+        }
+
+        template<template<class, class, class> class Parser, class Maker = counting_maker>
+        double run(std::string const& text, unsigned reps, parse_options const& opts = parse_options{}){
+                std::size_t total = 0;
+                auto start = std::chrono::steady_clock::now();
+                for(unsigned i=0;i!=reps;++i){
+                        Maker m;
+                        Parser<Maker, char const*, relaxed_dialect> p(m, text.data(), text.data() + text.size(), opts);
+                        parse_error err;
+                        if( ! p.parse(err) ){
+                                std::printf("failed: %s at %zu\n", to_string(err.code), err.offset);
+                                std::exit(1);
+                        }
+                        total += m.count;
+                }
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                if( total == 0 )
+                        std::printf("nothing parsed\n");
+                return static_cast<double>(text.size()) * reps / elapsed.count() / ( 1024 * 1024 );
+        }
+
+        template<class Maker = counting_maker>
+        void compare(char const* name, std::string const& text, unsigned reps, parse_options const& opts = parse_options{}){
+                double recursive = run<basic_parser, Maker>(text, reps, opts);
+                double iterative = run<basic_iterative_parser, Maker>(text, reps, opts);
+                std::printf("%-7s %8zu bytes  recursive %8.1f MB/s  iterative %8.1f MB/s\n",
+                            name, text.size(), recursive, iterative);
+        }
+}
+
+int main(int argc, char** argv){
+        std::size_t mb = argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1])) : 16;
+        #ifdef GJSON_NO_STRUCTURAL_INDEX
+        std::printf("without the structural index\n");
+        #else
+        std::printf("with the structural index\n");
+        #endif
+        auto text = wide(mb * 1024 * 1024);
+        compare("wide", text, 5);
+        parse_options indexed;
+        indexed.use_structural_index = true;
+        compare<skipping_maker>("skip", text, 5);
+        compare<skipping_maker>("skip+i", text, 5, indexed);
+        parse_options hints;
+        hints.size_hints = true;
+        compare<hinted_maker>("hints", text, 5, hints);
+        hints.use_structural_index = true;
+        compare<hinted_maker>("hints+i", text, 5, hints);
+        // kept shallow enough that the recursive one doesn't run out of stack
+        compare("deep", deep(16 * 1024), 200);
+}
@@ -4,16 +4,26 @@
 #include <cassert>
 #include <string>
 #include <list>
+#include <memory>
 #include <sstream>
-#include <map>
 #include <iostream>
 #include <vector>
 #include <iterator>
+#include <algorithm>
 
 #include <boost/lexical_cast.hpp>
+#include <boost/utility/string_view.hpp>
+
+#include "error.h"
+#include "arena.h"
+#include "adaptive_map.h"
 
 namespace gjson{
 
+struct parallel_options;
+struct string_pool;
+struct parse_options;
+
 namespace tt{
         template< bool B, class T, class F >
         using conditional_t = typename std::conditional<B,T,F>::type;
@@ -81,8 +91,23 @@ enum VisitorCtrl{
 
 
 struct JsonObject{
-        using array_type = std::vector<JsonObject>;
-        using map_type = std::map<JsonObject, JsonObject>;
+        // for map keys, only what operator< tells apart hashes differently
+        struct KeyHash{
+                std::uint64_t operator()(JsonObject const& key, std::uint64_t seed)const{
+                        return key.Hash_(seed);
+                }
+        };
+        struct KeyEqual{
+                bool operator()(JsonObject const& left, JsonObject const& right)const{
+                        return left.KeyEqual_(right);
+                }
+        };
+        // these are on the heap unless made with an arena, see arena_document
+        using array_type = std::vector<JsonObject, arena_allocator<JsonObject> >;
+        using map_type = adaptive_map<JsonObject, JsonObject, KeyHash, KeyEqual, std::less<JsonObject>,
+                                      arena_allocator<std::pair<JsonObject, JsonObject> > >;
+        // a string from a string_pool
+        using shared_string_type = std::shared_ptr<std::string const>;
 
         /*
                 The point of these are to allow construction of the
@@ -231,12 +256,29 @@ struct JsonObject{
         template<class Arg>
         void DoAssign(Tag_String, Arg&& arg){
                 type_ = Type_String;
+                string_kind_ = StringKind_Owned;
                 new (&as_string_) std::string{arg};
         }
+        void DoAssign(Tag_String, shared_string_type s){
+                type_ = Type_String;
+                string_kind_ = StringKind_Shared;
+                new (&as_shared_string_) shared_string_type{std::move(s)};
+        }
+        void DoAssign(Tag_String, arena& a, boost::string_view s){
+                type_ = Type_String;
+                string_kind_ = StringKind_Arena;
+                char* p = static_cast<char*>(a.allocate(s.size(), 1));
+                std::copy(s.begin(), s.end(), p);
+                new (&as_arena_string_) boost::string_view{p, s.size()};
+        }
         void DoAssign(Tag_Array){
                 type_ = Type_Array;
                 new (&as_array_) array_type{};
         }
+        void DoAssign(Tag_Array, arena& a){
+                type_ = Type_Array;
+                new (&as_array_) array_type(array_type::allocator_type(&a));
+        }
         template<class ArrayTypeParam>
         void DoAssign(Tag_Array, ArrayTypeParam&& val){
                 type_ = Type_Array;
@@ -246,6 +288,14 @@ struct JsonObject{
                 type_ = Type_Map;
                 new (&as_map_) map_type{};
         }
+        void DoAssign(Tag_Map, key_order order){
+                type_ = Type_Map;
+                new (&as_map_) map_type(order);
+        }
+        void DoAssign(Tag_Map, arena& a, key_order order = key_order::sorted){
+                type_ = Type_Map;
+                new (&as_map_) map_type(map_type::allocator_type(&a), order);
+        }
         template<class MapTypeParam>
         void DoAssign(Tag_Map, MapTypeParam&& val){
                 type_ = Type_Map;
@@ -262,6 +312,11 @@ struct JsonObject{
         }
         #endif
         template<class Value>
+        tt::enable_if_t< std::is_same<tt::decay_t<Value>, Tag_Nil >::value > 
+        AssignImpl( Detail::precedence_device<2>, Value&& val){
+                DoAssign(Tag_Nil{});
+        }
+        template<class Value>
         tt::enable_if_t< std::is_same<tt::decay_t<Value>, Tag_Array >::value > 
         AssignImpl( Detail::precedence_device<3>, Value&& val){
                 DoAssign(Tag_Array{});
@@ -336,17 +391,36 @@ struct JsonObject{
                         new (&as_float_) double(that.as_float_);
                         break;
                 case Type_String:
-                        new (&as_string_) std::string{that.as_string_};
+                        string_kind_ = that.string_kind_;
+                        if( string_kind_ == StringKind_Shared ){
+                                if( ! std::is_lvalue_reference<Value>::value ){
+                                        new (&as_shared_string_) shared_string_type(std::move(that.as_shared_string_));
+                                } else{
+                                        new (&as_shared_string_) shared_string_type(that.as_shared_string_);
+                                }
+                        } else if( string_kind_ == StringKind_Arena ){
+                                // a copy is on the heap, like the containers
+                                if( ! std::is_lvalue_reference<Value>::value ){
+                                        new (&as_arena_string_) boost::string_view(that.as_arena_string_);
+                                } else{
+                                        string_kind_ = StringKind_Owned;
+                                        new (&as_string_) std::string(that.as_arena_string_.begin(), that.as_arena_string_.end());
+                                }
+                        } else if( ! std::is_lvalue_reference<Value>::value ){
+                                new (&as_string_) std::string(std::move(that.as_string_));
+                        } else{
+                                new (&as_string_) std::string(that.as_string_);
+                        }
                         break;
                 case Type_Array:
-                        if( std::is_rvalue_reference<Value>::value ){
+                        if( ! std::is_lvalue_reference<Value>::value ){
                                 new (&as_array_) array_type(std::move(that.as_array_));
                         } else{
                                 new (&as_array_) array_type(that.as_array_);
                         }
                         break;
                 case Type_Map:
-                        if( std::is_rvalue_reference<Value>::value ){
+                        if( ! std::is_lvalue_reference<Value>::value ){
                                 new (&as_map_) map_type(std::move(that.as_map_));
                         } else{
                                 new (&as_map_) map_type(that.as_map_);
@@ -364,32 +438,57 @@ struct JsonObject{
         JsonObject(JsonObject const& that){
                 Assign(that);
         }
-        JsonObject(JsonObject&& that){
-                Assign(that);
+        JsonObject(JsonObject&& that)noexcept{
+                Assign(std::move(that));
         }
         template<class Arg>
         JsonObject(Arg&& arg)
         {
                 Assign(std::forward<Arg>(arg));
         }
+        // shares the string rather than copying it
+        JsonObject(Tag_String, shared_string_type s){
+                DoAssign(Tag_String{}, std::move(s));
+        }
+        // made in the arena, see arena_document
+        JsonObject(Tag_String, arena& a, boost::string_view s){
+                DoAssign(Tag_String{}, a, s);
+        }
+        JsonObject(Tag_Array, arena& a){
+                DoAssign(Tag_Array{}, a);
+        }
+        JsonObject(Tag_Map, arena& a, key_order order = key_order::sorted){
+                DoAssign(Tag_Map{}, a, order);
+        }
+        // keys in the order they're added, rather than sorted
+        JsonObject(Tag_Map, key_order order){
+                DoAssign(Tag_Map{}, order);
+        }
         ~JsonObject(){
-                using std::string;
-                switch(type_){
-                case Type_String:
-                        as_string_.~string();
-                        break;
-                case Type_Array:
-                        as_array_.~array_type();
-                        break;
-                case Type_Map:
-                        as_map_.~map_type();
-                        break;
-                }
+                Destroy_();
         }
         
+        // the map sorts by moving pairs about, so this one is kept cheap
+        JsonObject& operator=(JsonObject&& that)noexcept{
+                if( this == &that )
+                        return *this;
+                // only an array or map can have that inside of it
+                if( type_ != Type_Array && type_ != Type_Map ){
+                        Destroy_();
+                        Assign(std::move(that));
+                        return *this;
+                }
+                JsonObject tmp(std::move(that));
+                Destroy_();
+                Assign(std::move(tmp));
+                return *this;
+        }
         template<class Value>
         JsonObject& operator=(Value&& value){
-                Assign(std::forward<Value>(value));
+                // made first, as value might be inside of us
+                JsonObject tmp(std::forward<Value>(value));
+                Destroy_();
+                Assign(std::move(tmp));
                 return *this;
         }
 
@@ -406,7 +505,10 @@ struct JsonObject{
                 case Type_Float:
                         return static_cast<std::int64_t>(as_float_);
                 case Type_String:
-                        return boost::lexical_cast<std::int64_t>(as_string_);
+                {
+                        auto s = StringView_();
+                        return boost::lexical_cast<std::int64_t>(s.data(), s.size());
+                }
                 case Type_Bool:
                         return static_cast<std::int64_t>( as_bool_ != 0 ? 1 : 0 );
                 default:
@@ -422,7 +524,7 @@ struct JsonObject{
                 case Type_String:
                         {
                                 std::stringstream sstr;
-                                sstr << as_string_;
+                                sstr << StringView_();
                                 double result;
                                 sstr >> result;
                                 if( sstr.eof() && sstr ){
@@ -457,7 +559,7 @@ struct JsonObject{
                 #endif
                 switch(type_){
                 case Type_String:
-                        return as_string_;
+                        return StringView_().to_string();
                 case Type_Float:
                         return boost::lexical_cast<std::string>(as_float_);
                 case Type_Integer:
@@ -482,7 +584,7 @@ struct JsonObject{
         }
         template<class Value>
         void push_back_unchecked(Value&& val){
-                as_array_.emplace_back( val );
+                as_array_.emplace_back( std::forward<Value>(val) );
         }
         template<class Key, class Value>
         void emplace(Key&& key, Value&& val){
@@ -494,6 +596,25 @@ struct JsonObject{
         void emplace_unchecked(Key&& key, Value&& val){
                 as_map_.emplace(std::forward<Key>(key), std::forward<Value>(val));
         }
+        /*
+                For building a map, adds the pair on the end without
+                looking at the key, and finish_unchecked() sorts it and
+                drops any duplicates once they're all in
+         */
+        template<class Key, class Value>
+        void append_unchecked(Key&& key, Value&& val){
+                as_map_.append(std::forward<Key>(key), std::forward<Value>(val));
+        }
+        void finish_unchecked(){
+                as_map_.finish();
+        }
+        // room for n elements or pairs
+        void reserve(size_t n){
+                if( type_ == Type_Array )
+                        as_array_.reserve(n);
+                else if( type_ == Type_Map )
+                        as_map_.reserve(n);
+        }
         size_t size()const{
                 switch(type_){
                 case Type_Array:
@@ -506,6 +627,24 @@ struct JsonObject{
         }
 
 private:
+        void Destroy_(){
+                using std::string;
+                switch(type_){
+                case Type_String:
+                        if( string_kind_ == StringKind_Shared )
+                                as_shared_string_.~shared_string_type();
+                        else if( string_kind_ == StringKind_Owned )
+                                as_string_.~string();
+                        break;
+                case Type_Array:
+                        as_array_.~array_type();
+                        break;
+                case Type_Map:
+                        as_map_.~map_type();
+                        break;
+                }
+        }
+
         struct HasKeyPolicy{
                 using return_type = bool;
                 // this is called then the key isn't found
@@ -635,7 +774,7 @@ public:
                         sstr << as_float_;
                         break;
                 case Type_String:
-                        sstr << as_string_;
+                        sstr << StringView_();
                         break;
                 case Type_Array:
                         break;
@@ -657,7 +796,7 @@ public:
                 case Type_Float:
                         return this->as_float_ < that.as_float_;
                 case Type_String:
-                        return this->as_string_ < that.as_string_;
+                        return this->StringView_() < that.StringView_();
                 case Type_Array:
                 case Type_Map:
                         // we don't compare aggregates
@@ -722,7 +861,10 @@ public:
                         v.on_float(as_float_);
                         return VisitorCtrl_Nop;
                 case Type_String:
-                        v.on_string(as_string_);
+                        if( string_kind_ == StringKind_Arena )
+                                v.on_string(as_arena_string_.to_string());
+                        else
+                                v.on_string(String_());
                         return VisitorCtrl_Nop;
                 case Type_Array:
                         return v.begin_array( this->size() );
@@ -866,14 +1008,108 @@ public:
                 }
         }
 
+        // throws parse_exception on bad input
         void Parse(std::string const& s);
+        // doesn't throw on bad input, *this is left alone
+        bool TryParse(std::string const& s, parse_error& error);
+        bool TryParse(std::string const& s){
+                parse_error error;
+                return TryParse(s, error);
+        }
+        // strings which come up again are shared through pool
+        void Parse(std::string const& s, string_pool& pool);
+        bool TryParse(std::string const& s, parse_error& error, string_pool& pool);
+        // ie with size_hints arrays are reserved up front, order is how maps keep their keys
+        void Parse(std::string const& s, parse_options const& opts, key_order order = key_order::sorted);
+        bool TryParse(std::string const& s, parse_error& error, parse_options const& opts,
+                      key_order order = key_order::sorted);
+        // reads the stream a window at a time, rather than all of it first
+        void Parse(std::istream& istr);
+        bool TryParse(std::istream& istr, parse_error& error);
+        // parses the file in place through mmap
+        void ParseFile(std::string const& path);
+        bool TryParseFile(std::string const& path, parse_error& error);
+        /*
+                A big top level array is cut on element boundaries and the
+                pieces are built on a thread pool. Anything too small, not
+                an array or bad goes through Parse, so the result and the
+                errors are always the same as Parse
+         */
+        void ParseParallel(std::string const& s, parallel_options const& opts);
+        void ParseParallel(std::string const& s, unsigned threads = 0);
+        bool TryParseParallel(std::string const& s, parse_error& error, parallel_options const& opts);
 private:
+        bool ParseParallel_(std::string const& s, parallel_options const& opts);
+
+        enum StringKind{
+                StringKind_Owned,
+                StringKind_Shared,
+                StringKind_Arena,
+        };
+
+        // not for StringKind_Arena
+        std::string const& String_()const{
+                return string_kind_ == StringKind_Shared ? *as_shared_string_ : as_string_;
+        }
+        boost::string_view StringView_()const{
+                if( string_kind_ == StringKind_Arena )
+                        return as_arena_string_;
+                return String_();
+        }
+        std::uint64_t Hash_(std::uint64_t seed)const{
+                seed ^= static_cast<std::uint64_t>(type_) * 0x9E3779B97F4A7C15ull;
+                switch(type_){
+                case Type_Bool:
+                case Type_Integer:
+                {
+                        std::int64_t value = type_ == Type_Bool ? as_bool_ : as_int_;
+                        return detail::hash_bytes(&value, sizeof(value), seed);
+                }
+                case Type_Float:
+                {
+                        // -0.0 is the same key as 0.0
+                        double value = as_float_ == 0 ? 0.0 : as_float_;
+                        return detail::hash_bytes(&value, sizeof(value), seed);
+                }
+                case Type_String:
+                {
+                        auto s = StringView_();
+                        return detail::hash_bytes(s.data(), s.size(), seed);
+                }
+                default:
+                        // nil, arrays and maps only differ by type
+                        return detail::hash_bytes("", 0, seed);
+                }
+        }
+        // the same as neither being less than the other, but quicker
+        bool KeyEqual_(JsonObject const& that)const{
+                if( type_ != that.type_ )
+                        return false;
+                switch(type_){
+                case Type_Bool:
+                        return as_bool_ == that.as_bool_;
+                case Type_Integer:
+                        return as_int_ == that.as_int_;
+                case Type_Float:
+                        return ! ( as_float_ < that.as_float_ ) && ! ( that.as_float_ < as_float_ );
+                case Type_String:
+                        return StringView_() == that.StringView_();
+                default:
+                        return true;
+                }
+        }
+
         Type type_;
+        // which of the strings we have, only for Type_String
+        StringKind string_kind_;
         union {
                 bool as_bool_;
                 std::int64_t as_int_;
                 double as_float_;
                 std::string as_string_;
+                shared_string_type as_shared_string_;
+                // the bytes are in the arena
+                boost::string_view as_arena_string_;
                 array_type as_array_;
                 map_type as_map_;
         };
@@ -1,43 +1,88 @@
 #ifndef JSON_PARSER_JSONOBJECTMAKER_H
 #define JSON_PARSER_JSONOBJECTMAKER_H
 
+#include "string_pool.h"
+
 namespace gjson{
         struct JsonObjectMaker{
+                JsonObjectMaker() = default;
+                /*
+                        With key_order::insertion maps keep their keys in the
+                        order they're in the text, rather than sorted. It's
+                        the Maker's to say, so it's the same whichever parser
+                        or stream is driving it
+                 */
+                explicit JsonObjectMaker(key_order order)
+                        : order_(order)
+                {}
+                // the strings the pool takes are shared, rather than each object having a copy
+                explicit JsonObjectMaker(string_pool& pool, key_order order = key_order::sorted)
+                        : pool_(&pool), order_(order)
+                {}
+                // everything is made in the arena, see arena_document
+                explicit JsonObjectMaker(arena& a, key_order order = key_order::sorted)
+                        : arena_(&a), order_(order)
+                {}
 
                 struct StackFrame{
                         JsonObject object;
                         // only for when we have a map, get need to save the key first
-                        std::vector<JsonObject> param_stack_;
+                        JsonObject key;
+                        bool has_key{false};
                 };
 
 
                 void begin_map(){
                         StackFrame frame;
-                        frame.object = JsonObject{JsonObject::Tag_Map{}};
+                        frame.object = arena_ ? JsonObject{JsonObject::Tag_Map{}, *arena_, order_}
+                                              : JsonObject{JsonObject::Tag_Map{}, order_};
                         stack_.emplace_back(std::move(frame));
                 } 
+                // with size_hints, n is how many pairs are in it
+                void begin_map(std::size_t n){
+                        begin_map();
+                        stack_.back().object.reserve(n);
+                }
                 void end_map(){
+                        stack_.back().object.finish_unchecked();
                         end_any_();
                 }
                 void begin_array(){
                         StackFrame frame;
-                        frame.object = JsonObject{JsonObject::Tag_Array{}};
+                        frame.object = arena_ ? JsonObject{JsonObject::Tag_Array{}, *arena_}
+                                              : JsonObject{JsonObject::Tag_Array{}};
                         stack_.emplace_back(std::move(frame));
                 } 
+                // with size_hints, n is how many are in it
+                void begin_array(std::size_t n){
+                        begin_array();
+                        stack_.back().object.reserve(n);
+                }
                 void end_array(){
                         end_any_();
                 } 
-                void make_string(std::string const& value){
-                        add_any_( JsonObject{value});
+                // a view into the text where it can be, so the only copy is the one we keep
+                void make_string(boost::string_view value){
+                        if( arena_ ){
+                                add_any_( JsonObject{JsonObject::Tag_String{}, *arena_, value} );
+                                return;
+                        }
+                        if( pool_ ){
+                                if( auto shared = pool_->intern(value) ){
+                                        add_any_( JsonObject{JsonObject::Tag_String{}, std::move(shared)} );
+                                        return;
+                                }
+                        }
+                        add_any_( JsonObject{std::string(value.data(), value.size())});
                 }
                 void make_int(std::int64_t value){
                         add_any_( JsonObject{value});
                 }
-                void make_float(long double value){
+                void make_float(double value){
                         add_any_( JsonObject{value});
                 }
                 void make_null(){
-                        //add_any_( JsonObject{JsonObject::Tag_Nil{}});
+                        add_any_( JsonObject{JsonObject::Tag_Nil{}});
                 }
                 void make_true(){
                         add_any_( JsonObject{true} );
@@ -50,27 +95,38 @@ namespace gjson{
                         out_.pop_back();
                         return tmp;
                 } 
+                // ready for another document, keeps the memory we have
+                void reset(){
+                        stack_.clear();
+                        out_.clear();
+                }
         private:
                 void add_any_(JsonObject&& obj){
+                        // a scalar on it's own
+                        if( stack_.empty() ){
+                                out_.push_back(std::move(obj));
+                                return;
+                        }
                         if( stack_.back().object.GetType() == Type_Array ){
-                                stack_.back().object.push_back_unchecked( obj );
+                                stack_.back().object.push_back_unchecked( std::move(obj) );
                         } else if( stack_.back().object.GetType() == Type_Map ){
-                                if( stack_.back().param_stack_.empty() ){
+                                if( ! stack_.back().has_key ){
                                         // this must be the key, save it because we 
                                         // need to add key/value pair atomically
-                                        stack_.back().param_stack_.push_back(obj);
+                                        stack_.back().key = std::move(obj);
+                                        stack_.back().has_key = true;
                                 } else{
-                                        stack_.back().object.emplace_unchecked( 
-                                                std::move( stack_.back().param_stack_.back()),
+                                        stack_.back().object.append_unchecked( 
+                                                std::move( stack_.back().key),
                                                 std::move( obj ) );
-                                        stack_.back().param_stack_.pop_back();
+                                        stack_.back().has_key = false;
                                 }
                         } else{
                                 throw std::domain_error("unexpcted");
                         }
                 }
                 void end_any_(){
-                        if( stack_.back().param_stack_.size() != 0 )
+                        if( stack_.back().has_key )
                                 throw std::domain_error("not an even number of args");
                         auto last = std::move(stack_.back());
                         stack_.pop_back();
@@ -83,6 +139,9 @@ namespace gjson{
                 } 
                 std::vector<StackFrame> stack_;
                 std::vector<JsonObject> out_;
+                string_pool* pool_{nullptr};
+                arena* arena_{nullptr};
+                key_order order_{key_order::sorted};
         };
         
 } // gjson
@@ -0,0 +1,303 @@
+#ifndef JSON_PARSER_ADAPTIVE_MAP_H
+#define JSON_PARSER_ADAPTIVE_MAP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace gjson{
+
+        // how a map's keys are ordered when you go through it
+        enum class key_order{
+                sorted,
+                insertion,
+        };
+
+namespace detail{
+
+        inline std::uint64_t mix_(std::uint64_t a, std::uint64_t b){
+                __uint128_t r = static_cast<__uint128_t>(a) * b;
+                return static_cast<std::uint64_t>(r) ^ static_cast<std::uint64_t>(r >> 64);
+        }
+        /*
+                Eight bytes at a time through a 128 bit multiply, seeded so
+                which keys collide can't be worked out ahead of time
+         */
+        inline std::uint64_t hash_bytes(void const* ptr, std::size_t n, std::uint64_t seed){
+                auto p = static_cast<unsigned char const*>(ptr);
+                std::uint64_t h = seed ^ mix_(n, 0x9E3779B97F4A7C15ull);
+                for(; n >= 8; p += 8, n -= 8){
+                        std::uint64_t w;
+                        std::memcpy(&w, p, 8);
+                        h = mix_(w ^ 0xa0761d6478bd642full, h ^ 0xe7037ed1a0b428dbull);
+                }
+                std::uint64_t w = 0;
+                // an empty string_view can have a null data()
+                if( n != 0 )
+                        std::memcpy(&w, p, n);
+                return mix_(w ^ 0x8ebc6af09c88c6e3ull, h ^ 0x589965cc75374cc3ull);
+        }
+        // once per process
+        inline std::uint64_t map_hash_seed(){
+                static std::uint64_t const seed = [](){
+                        std::random_device rd;
+                        return ( static_cast<std::uint64_t>(rd()) << 32 ) ^ rd();
+                }();
+                return seed;
+        }
+
+} // detail
+
+        /*
+                What JsonObject has for a map. The pairs are kept in a
+                vector, in key order, or the order they went in with
+                key_order::insertion. Most maps are small, so up to
+                small_size keys a lookup just goes along the vector, after
+                that there's an open addressing hash index alongside it,
+                keyed with a hash seeded per process.
+
+                Inserting into the middle means the index is built again,
+                so to make a big map append() everything and then finish(),
+                which is what JsonObjectMaker does.
+
+                Hash is hash(key, seed), Equal and Less are the usual. Key
+                and Value can be incomplete until it's used
+         */
+        template<class Key, class Value, class Hash, class Equal, class Less = std::less<Key>,
+                 class Alloc = std::allocator<std::pair<Key, Value> > >
+        struct adaptive_map{
+                using key_type = Key;
+                using mapped_type = Value;
+                using value_type = std::pair<Key, Value>;
+                using allocator_type = Alloc;
+                using size_type = std::size_t;
+        private:
+                using vector_type = std::vector<value_type, Alloc>;
+                using index_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<std::uint64_t>;
+        public:
+                using iterator = typename vector_type::iterator;
+                using const_iterator = typename vector_type::const_iterator;
+
+                enum : std::size_t{ small_size = 16 };
+
+                adaptive_map() = default;
+                explicit adaptive_map(Alloc const& alloc, key_order order = key_order::sorted)
+                        : entries_(alloc), index_(index_alloc(alloc)), order_(order)
+                {}
+                explicit adaptive_map(key_order order)
+                        : order_(order)
+                {}
+                // the allocator does what the vectors do
+                adaptive_map(adaptive_map const&) = default;
+                adaptive_map(adaptive_map&&) = default;
+                adaptive_map& operator=(adaptive_map const&) = default;
+                adaptive_map& operator=(adaptive_map&&) = default;
+
+                iterator begin(){ return entries_.begin(); }
+                iterator end(){ return entries_.end(); }
+                const_iterator begin()const{ return entries_.begin(); }
+                const_iterator end()const{ return entries_.end(); }
+                size_type size()const{ return entries_.size(); }
+                bool empty()const{ return entries_.empty(); }
+                key_order order()const{ return order_; }
+                allocator_type get_allocator()const{ return entries_.get_allocator(); }
+                void reserve(size_type n){ entries_.reserve(n); }
+
+                iterator find(Key const& key){
+                        return begin() + static_cast<std::ptrdiff_t>(find_(key));
+                }
+                const_iterator find(Key const& key)const{
+                        return begin() + static_cast<std::ptrdiff_t>(find_(key));
+                }
+                // like std::map, if it's already there nothing changes
+                template<class K, class V>
+                std::pair<iterator, bool> emplace(K&& key, V&& value){
+                        value_type entry(std::forward<K>(key), std::forward<V>(value));
+                        std::size_t pos = find_(entry.first);
+                        if( pos != entries_.size() )
+                                return std::make_pair(begin() + static_cast<std::ptrdiff_t>(pos), false);
+                        if( order_ == key_order::sorted ){
+                                pos = static_cast<std::size_t>( std::lower_bound(entries_.begin(), entries_.end(), entry,
+                                        [](value_type const& l, value_type const& r){ return Less{}(l.first, r.first); }) - entries_.begin() );
+                        }
+                        entries_.insert(entries_.begin() + static_cast<std::ptrdiff_t>(pos), std::move(entry));
+                        if( pos + 1 == entries_.size() && ! index_.empty() && entries_.size() * 2 <= index_.size() )
+                                index_insert_(pos);
+                        else
+                                build_index_();
+                        return std::make_pair(begin() + static_cast<std::ptrdiff_t>(pos), true);
+                }
+                Value& operator[](Key const& key){
+                        std::size_t pos = find_(key);
+                        if( pos != entries_.size() )
+                                return entries_[pos].second;
+                        return emplace(key, Value{}).first->second;
+                }
+
+                /*
+                        For building, adds the pair at the end without looking
+                        for the key or keeping the order. finish() then puts it
+                        right, keeping the first of any duplicate keys
+                 */
+                template<class K, class V>
+                void append(K&& key, V&& value){
+                        entries_.emplace_back(std::forward<K>(key), std::forward<V>(value));
+                }
+                void finish(){
+                        if( order_ == key_order::sorted ){
+                                auto less = [](value_type const& l, value_type const& r){
+                                        return Less{}(l.first, r.first);
+                                };
+                                // stable_sort always wants a buffer, which small maps don't need
+                                if( entries_.size() <= small_size ){
+                                        for(auto iter = entries_.begin(); iter != entries_.end(); ++iter){
+                                                auto pos = std::upper_bound(entries_.begin(), iter, *iter, less);
+                                                if( pos == iter )
+                                                        continue;
+                                                value_type tmp(std::move(*iter));
+                                                std::move_backward(pos, iter, iter + 1);
+                                                *pos = std::move(tmp);
+                                        }
+                                } else {
+                                        sort_big_(less);
+                                }
+                                auto last = std::unique(entries_.begin(), entries_.end(), [](value_type const& l, value_type const& r){
+                                        return Equal{}(l.first, r.first);
+                                });
+                                entries_.erase(last, entries_.end());
+                                build_index_();
+                        } else {
+                                dedup_in_order_();
+                        }
+                }
+        private:
+                // where key is, or size() if it isn't
+                std::size_t find_(Key const& key)const{
+                        if( index_.empty() ){
+                                for(std::size_t i = 0; i != entries_.size(); ++i){
+                                        if( Equal{}(entries_[i].first, key) )
+                                                return i;
+                                }
+                                return entries_.size();
+                        }
+                        std::size_t pos = index_find_(key);
+                        return pos == npos_ ? entries_.size() : pos;
+                }
+                std::size_t index_find_(Key const& key)const{
+                        std::uint64_t h = Hash{}(key, detail::map_hash_seed());
+                        std::size_t mask = index_.size() - 1;
+                        for(std::size_t slot = static_cast<std::size_t>(h) & mask;; slot = ( slot + 1 ) & mask){
+                                std::uint64_t e = index_[slot];
+                                if( e == 0 )
+                                        return npos_;
+                                if( ( e >> 32 ) == ( h >> 32 ) && Equal{}(entries_[( e & 0xFFFFFFFF ) - 1].first, key) )
+                                        return static_cast<std::size_t>( ( e & 0xFFFFFFFF ) - 1 );
+                        }
+                }
+                /*
+                        Each slot is the top of the hash and one past the
+                        position, so 0 is empty. It's kept at most half full
+                 */
+                static std::size_t index_size_(std::size_t n){
+                        std::size_t cap = 64;
+                        for(; cap < n * 2; cap *= 2);
+                        return cap;
+                }
+                void build_index_(){
+                        index_.clear();
+                        if( entries_.size() <= small_size )
+                                return;
+                        index_.assign(index_size_(entries_.size()), 0);
+                        for(std::size_t i = 0; i != entries_.size(); ++i)
+                                index_insert_(i);
+                }
+                /*
+                        stable_sort gets it's buffer from the heap, whatever
+                        our allocator is, so this sorts positions in index_
+                        instead, with the position breaking ties, and then
+                        moves the entries round a cycle at a time. index_ is
+                        made big enough for build_index_ after
+                 */
+                template<class L>
+                void sort_big_(L less){
+                        std::size_t n = entries_.size();
+                        index_.clear();
+                        index_.reserve(index_size_(n));
+                        for(std::size_t i = 0; i != n; ++i)
+                                index_.push_back(i);
+                        std::sort(index_.begin(), index_.end(), [&](std::uint64_t l, std::uint64_t r){
+                                if( less(entries_[l], entries_[r]) )
+                                        return true;
+                                if( less(entries_[r], entries_[l]) )
+                                        return false;
+                                return l < r;
+                        });
+                        // entries_[i] is to be what's at entries_[index_[i]]
+                        std::uint64_t const done = static_cast<std::uint64_t>(1) << 63;
+                        for(std::size_t start = 0; start != n; ++start){
+                                if( index_[start] & done )
+                                        continue;
+                                value_type tmp(std::move(entries_[start]));
+                                for(std::size_t i = start;;){
+                                        std::size_t from = static_cast<std::size_t>(index_[i]);
+                                        index_[i] |= done;
+                                        if( from == start ){
+                                                entries_[i] = std::move(tmp);
+                                                break;
+                                        }
+                                        entries_[i] = std::move(entries_[from]);
+                                        i = from;
+                                }
+                        }
+                }
+                void index_insert_(std::size_t pos){
+                        std::uint64_t h = Hash{}(entries_[pos].first, detail::map_hash_seed());
+                        std::size_t mask = index_.size() - 1;
+                        std::size_t slot = static_cast<std::size_t>(h) & mask;
+                        for(; index_[slot] != 0; slot = ( slot + 1 ) & mask);
+                        index_[slot] = ( h & 0xFFFFFFFF00000000ull ) | ( pos + 1 );
+                }
+                // keeps the first of each key where it is
+                void dedup_in_order_(){
+                        if( entries_.size() <= small_size ){
+                                std::size_t out = 0;
+                                for(std::size_t i = 0; i != entries_.size(); ++i){
+                                        std::size_t j = 0;
+                                        for(; j != out && ! Equal{}(entries_[j].first, entries_[i].first); ++j);
+                                        if( j != out )
+                                                continue;
+                                        if( out != i )
+                                                entries_[out] = std::move(entries_[i]);
+                                        ++out;
+                                }
+                                entries_.erase(entries_.begin() + static_cast<std::ptrdiff_t>(out), entries_.end());
+                                index_.clear();
+                                return;
+                        }
+                        // the index is filled in as we go, so it only has what we've kept
+                        index_.assign(index_size_(entries_.size()), 0);
+                        std::size_t out = 0;
+                        for(std::size_t i = 0; i != entries_.size(); ++i){
+                                if( index_find_(entries_[i].first) != npos_ )
+                                        continue;
+                                if( out != i )
+                                        entries_[out] = std::move(entries_[i]);
+                                index_insert_(out);
+                                ++out;
+                        }
+                        entries_.erase(entries_.begin() + static_cast<std::ptrdiff_t>(out), entries_.end());
+                }
+                static constexpr std::size_t npos_ = static_cast<std::size_t>(-1);
+
+                vector_type entries_;
+                std::vector<std::uint64_t, index_alloc> index_;
+                key_order order_{key_order::sorted};
+        };
+
+} // gjson
+#endif // JSON_PARSER_ADAPTIVE_MAP_H
@@ -0,0 +1,173 @@
+#ifndef JSON_PARSER_ARENA_H
+#define JSON_PARSER_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace gjson{
+
+        /*
+                Memory handed out by bumping a pointer, and never given
+                back one piece at a time, it all goes at once when the
+                arena is reset or destroyed. Blocks come from operator new,
+                each twice the size of the last, or with a buffer of our
+                own it's fixed capacity, nothing is ever malloc'd and
+                std::bad_alloc is thrown when it's full.
+
+                Not locked, one thread at a time
+         */
+        struct arena{
+                enum : std::size_t{ default_block_size = 64 * 1024 };
+
+                explicit arena(std::size_t block_size = default_block_size)
+                        : block_size_(block_size ? block_size : default_block_size)
+                {}
+                // everything comes out of [buffer, buffer + size)
+                arena(void* buffer, std::size_t size)
+                        : begin_(static_cast<char*>(buffer))
+                        , ptr_(begin_)
+                        , end_(static_cast<char*>(buffer) + size)
+                        , fixed_(true)
+                {}
+                arena(arena const&) = delete;
+                arena& operator=(arena const&) = delete;
+                ~arena(){
+                        for(auto& b : blocks_)
+                                ::operator delete(b.first);
+                }
+
+                void* allocate(std::size_t n, std::size_t align = alignof(std::max_align_t)){
+                        for(;;){
+                                if( void* p = bump_(n, align) )
+                                        return p;
+                                if( ! next_block_(n + align) )
+                                        throw std::bad_alloc{};
+                        }
+                }
+                // nothing, it goes when the arena does
+                void deallocate(void*, std::size_t)noexcept{}
+
+                // forget everything handed out, the blocks are kept for next time
+                void reset()noexcept{
+                        used_ = 0;
+                        if( fixed_ ){
+                                ptr_ = begin_;
+                                return;
+                        }
+                        current_ = 0;
+                        ptr_ = end_ = nullptr;
+                        if( ! blocks_.empty() ){
+                                ptr_ = blocks_[0].first;
+                                end_ = ptr_ + blocks_[0].second;
+                        }
+                }
+
+                // bytes handed out since the last reset, including padding
+                std::size_t used()const{ return used_; }
+                bool fixed()const{ return fixed_; }
+        private:
+                void* bump_(std::size_t n, std::size_t align){
+                        if( ! ptr_ )
+                                return nullptr;
+                        std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(ptr_);
+                        std::size_t pad = static_cast<std::size_t>( ( align - addr % align ) % align );
+                        if( static_cast<std::size_t>(end_ - ptr_) < pad || static_cast<std::size_t>(end_ - ptr_) - pad < n )
+                                return nullptr;
+                        char* p = ptr_ + pad;
+                        ptr_ = p + n;
+                        used_ += pad + n;
+                        return p;
+                }
+                // moves on to a block with at least n, false if there can't be one
+                bool next_block_(std::size_t n){
+                        if( fixed_ )
+                                return false;
+                        // reuse what we kept from before a reset
+                        for(; current_ + 1 < blocks_.size();){
+                                ++current_;
+                                ptr_ = blocks_[current_].first;
+                                end_ = ptr_ + blocks_[current_].second;
+                                if( blocks_[current_].second >= n )
+                                        return true;
+                        }
+                        std::size_t size = blocks_.empty() ? block_size_ : blocks_.back().second * 2;
+                        if( size < n )
+                                size = n;
+                        char* p = static_cast<char*>(::operator new(size));
+                        blocks_.emplace_back(p, size);
+                        current_ = blocks_.size() - 1;
+                        ptr_ = p;
+                        end_ = p + size;
+                        return true;
+                }
+
+                std::size_t block_size_{default_block_size};
+                std::vector<std::pair<char*, std::size_t> > blocks_;
+                std::size_t current_{0};
+                // only for a fixed buffer
+                char* begin_{nullptr};
+                char* ptr_{nullptr};
+                char* end_{nullptr};
+                std::size_t used_{0};
+                bool fixed_{false};
+        };
+
+        /*
+                An allocator for the containers inside a JsonObject, with
+                an arena it allocates from it, without one it's the same as
+                std::allocator. It goes with the container when it's
+                moved, but a copy is back on the heap, so a copy can
+                outlive the arena
+         */
+        template<class T>
+        struct arena_allocator{
+                using value_type = T;
+                using propagate_on_container_move_assignment = std::true_type;
+                using propagate_on_container_swap = std::true_type;
+
+                arena_allocator()noexcept = default;
+                explicit arena_allocator(arena* a)noexcept
+                        : arena_(a)
+                {}
+                template<class U>
+                arena_allocator(arena_allocator<U> const& that)noexcept
+                        : arena_(that.get_arena())
+                {}
+
+                T* allocate(std::size_t n){
+                        if( n > std::numeric_limits<std::size_t>::max() / sizeof(T) )
+                                throw std::bad_alloc{};
+                        if( arena_ )
+                                return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+                        return static_cast<T*>(::operator new(n * sizeof(T)));
+                }
+                void deallocate(T* p, std::size_t n)noexcept{
+                        if( arena_ )
+                                arena_->deallocate(p, n * sizeof(T));
+                        else
+                                ::operator delete(p);
+                }
+                arena_allocator select_on_container_copy_construction()const{
+                        return arena_allocator{};
+                }
+                arena* get_arena()const noexcept{ return arena_; }
+
+                template<class U>
+                friend bool operator==(arena_allocator const& left, arena_allocator<U> const& right)noexcept{
+                        return left.get_arena() == right.get_arena();
+                }
+                template<class U>
+                friend bool operator!=(arena_allocator const& left, arena_allocator<U> const& right)noexcept{
+                        return left.get_arena() != right.get_arena();
+                }
+        private:
+                arena* arena_{nullptr};
+        };
+
+} // gjson
+#endif // JSON_PARSER_ARENA_H
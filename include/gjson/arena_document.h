@@ -0,0 +1,119 @@
+#ifndef JSON_PARSER_ARENA_DOCUMENT_H
+#define JSON_PARSER_ARENA_DOCUMENT_H
+
+#include <new>
+#include <string>
+#include <type_traits>
+
+#include <boost/exception/all.hpp>
+
+#include "arena.h"
+#include "JsonObject.h"
+#include "JsonObjectMaker.h"
+#include "basic_parser.h"
+#include "error.h"
+
+namespace gjson{
+
+        /*
+                A JsonObject tree made in an arena, ie
+
+                        arena_document doc;
+                        doc.parse(text);
+                        auto id = doc.root()["id"].AsInteger();
+
+                so parsing bumps a pointer rather than calling malloc for
+                every array, map and string, and throwing the tree away is
+                just rewinding the arena, nothing is freed node by node.
+                size_hints is worth having on, as a vector that grows
+                leaves the old copies in the arena.
+
+                The tree is only handed out const, anything put into it
+                would be on the heap and it's never destroyed. A copy is on
+                the heap, so it can outlive the document, but one moved out
+                still points into the arena.
+
+                Given a buffer, the tree never mallocs, and running out is
+                out_of_memory. What the parse needs on the side, the index,
+                the Maker's stack and so on, is kept from one parse to the
+                next, so once a document has parsed something as big and as
+                deep, parsing again doesn't call malloc at all. One
+                document can be kept per thread
+         */
+        struct arena_document{
+                explicit arena_document(std::size_t block_size = arena::default_block_size,
+                                        key_order order = key_order::sorted)
+                        : arena_(block_size), maker_(arena_, order)
+                {}
+                // fixed capacity, the tree has to fit in [buffer, buffer + size)
+                arena_document(void* buffer, std::size_t size, key_order order = key_order::sorted)
+                        : arena_(buffer, size), maker_(arena_, order)
+                {}
+                arena_document(arena_document const&) = delete;
+                arena_document& operator=(arena_document const&) = delete;
+                // the tree isn't destroyed, it all goes with the arena
+                ~arena_document() = default;
+
+                // doesn't throw on bad input, the document is left empty
+                bool parse(char const* first, char const* last, parse_error& err,
+                           parse_options const& opts = parse_options{})
+                {
+                        clear();
+                        maker_.reset();
+                        try{
+                                basic_parser<JsonObjectMaker, char const*> p(maker_, first, last, opts, buffers_);
+                                if( ! p.parse(err) ){
+                                        maker_.reset();
+                                        arena_.reset();
+                                        return false;
+                                }
+                                new (&storage_) JsonObject(maker_.make());
+                                has_root_ = true;
+                        } catch(std::bad_alloc const&){
+                                maker_.reset();
+                                arena_.reset();
+                                if( ! arena_.fixed() )
+                                        throw;
+                                // we don't know where we'd got to
+                                err = parse_error{error_code::out_of_memory, 0};
+                                return false;
+                        }
+                        return true;
+                }
+                bool parse(std::string const& s, parse_error& err, parse_options const& opts = parse_options{}){
+                        return parse(s.data(), s.data() + s.size(), err, opts);
+                }
+                // throws parse_exception on bad input
+                void parse(std::string const& s, parse_options const& opts = parse_options{}){
+                        parse_error err;
+                        if( ! parse(s, err, opts) ){
+                                std::string what = err.code == error_code::out_of_memory
+                                        ? std::string("error: out_of_memory")
+                                        : describe(s.data(), s.data() + s.size(), err);
+                                BOOST_THROW_EXCEPTION(parse_exception(err, what));
+                        }
+                }
+
+                bool empty()const{ return ! has_root_; }
+                JsonObject const& root()const{
+                        if( ! has_root_ )
+                                throw std::domain_error("nothing parsed");
+                        return *reinterpret_cast<JsonObject const*>(&storage_);
+                }
+                // drops the tree, keeping the memory
+                void clear(){
+                        has_root_ = false;
+                        arena_.reset();
+                }
+                // how much of the arena the tree takes
+                std::size_t bytes_used()const{ return arena_.used(); }
+        private:
+                arena arena_;
+                JsonObjectMaker maker_;
+                parse_buffers buffers_;
+                typename std::aligned_storage<sizeof(JsonObject), alignof(JsonObject)>::type storage_;
+                bool has_root_{false};
+        };
+
+} // gjson
+#endif // JSON_PARSER_ARENA_DOCUMENT_H
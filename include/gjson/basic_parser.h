@@ -2,66 +2,223 @@
 #define JSON_PARSER_BASIC_PARSER_H
 
 #include <boost/exception/all.hpp>
-#include <boost/lexical_cast.hpp>
 #include "tokenizer.h"
 #include <iostream>
+#include <type_traits>
 
 namespace gjson {
 
-        template <class Maker, class Iter>
+        /*
+                A Maker's begin_map, begin_array and make_* can return this
+                rather than void, skip means it doesn't want
+                        after begin_map/begin_array     what's inside, end_map/end_array is next
+                        after a key                     the value, and that's the end of the pair
+                and we jump over it looking at nothing but brackets and
+                quotes. Skip from anything else is ignored. It's the same
+                with basic_iterative_parser and basic_push_parser
+         */
+        enum class maker_ctrl{
+                keep,
+                skip,
+        };
+
+namespace detail{
+
+        // whether the Maker has begin_map(n), begin_array(n) as well
+        template<class Maker, class = void>
+        struct takes_map_count : std::false_type{};
+        template<class Maker>
+        struct takes_map_count<Maker, decltype( std::declval<Maker&>().begin_map(std::size_t{}), void() )> : std::true_type{};
+        template<class Maker, class = void>
+        struct takes_array_count : std::false_type{};
+        template<class Maker>
+        struct takes_array_count<Maker, decltype( std::declval<Maker&>().begin_array(std::size_t{}), void() )> : std::true_type{};
+
+        // whether the Maker has make_string(boost::string_view), so we needn't make a std::string
+        template<class Maker, class = void>
+        struct takes_string_view : std::false_type{};
+        template<class Maker>
+        struct takes_string_view<Maker, decltype( std::declval<Maker&>().make_string(boost::string_view{}), void() )> : std::true_type{};
+
+        // make_string(value) for the string token t, scratch is for when it has to be decoded
+        template<class Maker, class Tokenizer>
+        auto make_string(Maker& maker, Tokenizer const& tok, token const& t, std::string& scratch){
+                return make_string_(maker, tok, t, scratch, takes_string_view<Maker>{});
+        }
+        template<class Maker, class Tokenizer>
+        auto make_string_(Maker& maker, Tokenizer const& tok, token const& t, std::string& scratch, std::true_type){
+                return maker.make_string(tok.value(t, scratch));
+        }
+        template<class Maker, class Tokenizer>
+        auto make_string_(Maker& maker, Tokenizer const& tok, token const& t, std::string&, std::false_type){
+                return maker.make_string(tok.value(t));
+        }
+
+        // true if f() said maker_ctrl::skip, which it can't if it returns void
+        template<class F>
+        bool maker_skips(F f, std::true_type){
+                return f() == maker_ctrl::skip;
+        }
+        template<class F>
+        bool maker_skips(F f, std::false_type){
+                f();
+                return false;
+        }
+        template<class F>
+        bool maker_skips(F f){
+                return maker_skips(f, std::is_same<decltype(f()), maker_ctrl>{});
+        }
+
+} // detail
+
+        /*
+                With parse_options::size_hints the counts are worked out
+                first, and a Maker which has
+                        begin_map(std::size_t pairs)
+                        begin_array(std::size_t values)
+                as well as the usual ones is given them, so it can reserve
+                rather than grow. They're hints, for bad json they can be
+                wrong
+         */
+
+        template <class Maker, class Iter, class Dialect = relaxed_dialect>
         struct basic_parser {
 
 
 
-                basic_parser( Maker& maker, Iter first, Iter last  )
-                      : tok_( first, last )
-                      , not_a_token_( token_type::dummy, "(dummy)" )
+                basic_parser( Maker& maker, Iter first, Iter last, parse_options const& opts = parse_options{} )
+                      : tok_( first, last, opts )
+                      , maker_(maker)
+                      , max_depth_(opts.max_depth)
+                {
+                        if( opts.size_hints && ( detail::takes_map_count<Maker>::value || detail::takes_array_count<Maker>::value ) ){
+                                tok_.count_containers(counts_);
+                                counted_ = true;
+                        }
+                }
+                /*
+                        Borrows the memory in buffers rather than allocating
+                        it's own, and gives it back when it's destroyed
+                 */
+                basic_parser( Maker& maker, Iter first, Iter last, parse_options const& opts, parse_buffers& buffers )
+                      : tok_( first, last, opts, std::move(buffers.index) )
                       , maker_(maker)
-                {}
+                      , max_depth_(opts.max_depth)
+                      , scratch_(std::move(buffers.scratch))
+                      , counts_(std::move(buffers.counts))
+                      , buffers_(&buffers)
+                {
+                        if( opts.size_hints && ( detail::takes_map_count<Maker>::value || detail::takes_array_count<Maker>::value ) ){
+                                tok_.count_containers(counts_, buffers.count_stack);
+                                counted_ = true;
+                        }
+                }
+                basic_parser(basic_parser const&) = default;
+                basic_parser(basic_parser&&) = default;
+                ~basic_parser(){
+                        if( ! buffers_ )
+                                return;
+                        buffers_->index = tok_.release_index();
+                        buffers_->scratch = std::move(scratch_);
+                        buffers_->counts = std::move(counts_);
+                }
 
                 void debug_(){
-                        for(;;){
-                                auto opt = tok_.peak();
-                                if( ! opt )
-                                        break;
-                                std::cout << opt.get() << "\n";
-                                tok_.next();
+                        for(; ! tok_.eos(); tok_.next()){
+                                std::cout << tok_.peak() << "\n";
                         }
                 }
-                void parse(){
-                        bool ret = obj_();
-                        if( ! ret )
-                               tok_.return_errror_("expected a map");
+                /*
+                        Doesn't throw, returns false and fills in err on bad
+                        input. The maker will have seen whatever was parsed
+                        before the error
+                 */
+                bool parse(parse_error& err){
+                        if( ! root_() )
+                               tok_.fail(Dialect::scalar_root ? error_code::expected_value
+                                                              : error_code::expected_map_or_array);
                         if( ! eos())
-                               tok_.return_errror_("unable to parse all the input");
+                               tok_.fail(error_code::trailing_input);
+                        err = tok_.error();
+                        return ! err;
+                }
+                /*
+                        The inside of an array without the brackets, ie
+                                1, "two", [3]
+                        the maker sees the values one after the other. This
+                        is how each piece of a split up array is parsed
+                 */
+                bool parse_elements(parse_error& err){
+                        if( ! comma_seperated_( [&](){ return prim_or_obj_(); } ) )
+                               tok_.fail(error_code::expected_value);
+                        if( ! eos())
+                               tok_.fail(error_code::trailing_input);
+                        err = tok_.error();
+                        return ! err;
+                }
+                /*
+                        For back to back documents, ie {..}{..}[..], parses
+                        the next one and leaves the tokenizer just after it.
+                        Returns false at the end or on bad input, err tells
+                        them apart
+                 */
+                bool parse_next(parse_error& err){
+                        err = tok_.error();
+                        if( eos() )
+                                return false;
+                        if( ! root_() )
+                               tok_.fail(Dialect::scalar_root ? error_code::expected_value
+                                                              : error_code::expected_map_or_array);
+                        err = tok_.error();
+                        return ! err;
+                }
+                // throws parse_exception on bad input
+                void parse(){
+                        parse_error err;
+                        if( ! parse(err) )
+                                BOOST_THROW_EXCEPTION(parse_exception(err, tok_.get_error()));
                 }
                 auto eos()const{return tok_.eos();}
+                parse_error const& error()const{ return tok_.error(); }
+                error_location location()const{ return tok_.location(); }
         private:
                 bool map_(){
-                        if( eat_( token_type::left_curl ) ){
-                                maker_.begin_map();
-
-                                comma_seperated_( [&](){ return pair_(); } );
+                        auto open = tok_.peak().offset();
+                        if( open_( token_type::left_curl ) ){
+                                if( begin_map_(open, detail::takes_map_count<Maker>{}) ){
+                                        tok_.skip_container(open);
+                                } else {
+                                        bool first = true;
+                                        comma_seperated_( [&](){
+                                                bool ret = pair_(first);
+                                                first = false;
+                                                return ret;
+                                        });
+                                }
 
                                 if( eat_( token_type::right_curl)){
+                                        --depth_;
                                         maker_.end_map();
                                         return true;
                                 }
-                                tok_.return_errror_("expected a '}'");
+                                tok_.fail(error_code::expected_right_curl);
                         }
                         return false;
                 }
                 bool array_(){
-                        if( eat_( token_type::left_br ) ){
-                                maker_.begin_array();
-
-                                comma_seperated_( [&](){ return prim_or_obj_(); } );
+                        auto open = tok_.peak().offset();
+                        if( open_( token_type::left_br ) ){
+                                if( begin_array_(open, detail::takes_array_count<Maker>{}) )
+                                        tok_.skip_container(open);
+                                else
+                                        comma_seperated_( [&](){ return prim_or_obj_(); } );
 
                                 if( eat_( token_type::right_br)){
+                                        --depth_;
                                         maker_.end_array();
                                         return true;
                                 }
-                                tok_.return_errror_("expected a ']'");
+                                tok_.fail(error_code::expected_right_br);
                         }
                         return false;
                 }
@@ -76,6 +233,11 @@ namespace gjson {
                                 return false;
                         }
                 }
+                bool root_(){
+                        if( Dialect::scalar_root )
+                                return prim_or_obj_();
+                        return obj_();
+                }
                 bool obj_(){
                         if( map_() ){
                                 return true;
@@ -91,7 +253,7 @@ namespace gjson {
                                 for(;;){
                                         if( eat_( token_type::comma) ){
                                                if( ! f() ){
-                                                        tok_.return_errror_("expected a pair");
+                                                        tok_.fail(error_code::expected_value);
                                                }
                                         } else {
                                                 break;
@@ -101,36 +263,50 @@ namespace gjson {
                         }
                         return false;
                 }
-                bool pair_(){
-                        if( prim_() && eat_( token_type::colon) && prim_or_obj_() ){
+                bool pair_(bool first){
+                        if( ! key_() )
+                                return false;
+                        bool skip = skipped_;
+                        if( eat_( token_type::colon) && ( skip ? tok_.skip_value() : prim_or_obj_() ) )
                                 return true;
-                        }
+                        // the maker has the key, so this can't be the end of the map
+                        tok_.fail(first ? error_code::expected_right_curl : error_code::expected_value);
                         return false;
                 }
+                bool key_(){
+                        if( ! Dialect::non_string_keys && tok_.peak().type() != token_type::string_ )
+                                return false;
+                        return prim_();
+                }
                 bool prim_(){
-                        switch( boost::get_optional_value_or(tok_.peak(), not_a_token_ ).type()){
+                        token const& tok = tok_.peak();
+                        switch( tok.type()){
                                 case token_type::int_:
-                                        maker_.make_int( boost::lexical_cast<std::int64_t>(tok_.peak()->value()));
+                                        skipped_ = skips_( [&](){ return maker_.make_int( tok.int_value() ); } );
                                         tok_.next();
                                         return true;
                                 case token_type::float_:
-                                        maker_.make_float( boost::lexical_cast<long double>(tok_.peak()->value()));
+                                        if( ! tok.convertible() ){
+                                                tok_.fail(error_code::invalid_number);
+                                                return false;
+                                        }
+                                        skipped_ = skips_( [&](){ return maker_.make_float( tok.float_value() ); } );
                                         tok_.next();
                                         return true;
                                 case token_type::string_:
-                                        maker_.make_string( tok_.peak()->value() );
+                                        skipped_ = skips_( [&](){ return detail::make_string(maker_, tok_, tok, scratch_); } );
                                         tok_.next();
                                         return true;
                                 case token_type::true_:
-                                        maker_.make_true();
+                                        skipped_ = skips_( [&](){ return maker_.make_true(); } );
                                         tok_.next();
                                         return true;
                                 case token_type::false_:
-                                        maker_.make_false();
+                                        skipped_ = skips_( [&](){ return maker_.make_false(); } );
                                         tok_.next();
                                         return true;
                                 case token_type::null_:
-                                        maker_.make_null();
+                                        skipped_ = skips_( [&](){ return maker_.make_null(); } );
                                         tok_.next();
                                         return true;
                                 default:
@@ -138,17 +314,68 @@ namespace gjson {
                         }
                         __builtin_unreachable();
                 }
+                // begin_map(n) when we counted and the maker wants it, true if it skips
+                bool begin_map_(std::size_t open, std::true_type){
+                        if( counted_ )
+                                return skips_( [&](){ return maker_.begin_map(count_(open)); } );
+                        return begin_map_(open, std::false_type{});
+                }
+                bool begin_map_(std::size_t, std::false_type){
+                        return skips_( [&](){ return maker_.begin_map(); } );
+                }
+                bool begin_array_(std::size_t open, std::true_type){
+                        if( counted_ )
+                                return skips_( [&](){ return maker_.begin_array(count_(open)); } );
+                        return begin_array_(open, std::false_type{});
+                }
+                bool begin_array_(std::size_t, std::false_type){
+                        return skips_( [&](){ return maker_.begin_array(); } );
+                }
+                // containers come in the order they were counted, less any we skipped
+                std::size_t count_(std::size_t open){
+                        for(; count_cursor_ != counts_.size() && counts_[count_cursor_].offset < open; ++count_cursor_);
+                        if( count_cursor_ != counts_.size() && counts_[count_cursor_].offset == open )
+                                return counts_[count_cursor_].count;
+                        return 0;
+                }
+                template<class F>
+                static bool skips_(F f){
+                        return detail::maker_skips(f);
+                }
+                // eat_ for a { or [, which fails if it's one too many deep
+                bool open_(token_type type){
+                        if( tok_.peak().type() != type )
+                                return false;
+                        if( max_depth_ != 0 && depth_ >= max_depth_ ){
+                                tok_.fail(error_code::too_deep);
+                                return false;
+                        }
+                        ++depth_;
+                        tok_.next();
+                        return true;
+                }
                 bool eat_(token_type type){
-                        if( boost::get_optional_value_or(tok_.peak(), not_a_token_ ).type() == type ){
+                        if( tok_.peak().type() == type ){
                                 tok_.next();
                                 return true;
                         }
                         return false;
                 }
 
-                basic_tokenizer<Iter> tok_;
-                token not_a_token_;
+                basic_tokenizer<Iter, Dialect> tok_;
                 Maker& maker_;
+                std::size_t max_depth_;
+                std::size_t depth_{0};
+                // what the maker said about the last scalar, for keys
+                bool skipped_{false};
+                // strings with escapes are decoded into this, for a Maker which takes a string_view
+                std::string scratch_;
+                // for size_hints
+                bool counted_{false};
+                std::vector<container_count> counts_;
+                std::size_t count_cursor_{0};
+                // where the memory came from, if it's borrowed
+                parse_buffers* buffers_{nullptr};
         };
 
 
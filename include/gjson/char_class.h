@@ -0,0 +1,125 @@
+#ifndef JSON_PARSER_CHAR_CLASS_H
+#define JSON_PARSER_CHAR_CLASS_H
+
+#include <cstdint>
+#include <cstring>
+
+namespace gjson{
+namespace detail{
+
+        /*
+                Replacement for std::isspace etc, which are locale
+                dependent and a function call per byte. The classes
+                are what the tokenizer means, not what the C locale
+                means, ie ident is [a-zA-Z0-9_]
+         */
+        enum char_class_bits : unsigned char{
+                char_class_space      = 1 << 0,
+                char_class_digit      = 1 << 1,
+                char_class_alpha      = 1 << 2,
+                char_class_ident      = 1 << 3,
+                char_class_structural = 1 << 4,
+                // the first character of a number, [0-9+-.]
+                char_class_number     = 1 << 5,
+        };
+
+        struct char_class_table{
+                unsigned char data[256];
+        };
+
+        constexpr char_class_table make_char_class_table(){
+                char_class_table t{};
+                for(unsigned c = 0; c != 256; ++c){
+                        unsigned char bits = 0;
+                        if( c == ' ' || ( '\t' <= c && c <= '\r' ) )
+                                bits |= char_class_space;
+                        if( '0' <= c && c <= '9' )
+                                bits |= char_class_digit | char_class_ident | char_class_number;
+                        if( ( 'a' <= c && c <= 'z' ) || ( 'A' <= c && c <= 'Z' ) )
+                                bits |= char_class_alpha | char_class_ident;
+                        if( c == '_' )
+                                bits |= char_class_ident;
+                        if( c == '+' || c == '-' || c == '.' )
+                                bits |= char_class_number;
+                        if( c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',' )
+                                bits |= char_class_structural;
+                        t.data[c] = bits;
+                }
+                return t;
+        }
+
+        // template so the definition can live in the header
+        template<class = void>
+        struct char_class_holder{
+                static constexpr char_class_table table = make_char_class_table();
+        };
+        template<class T>
+        constexpr char_class_table char_class_holder<T>::table;
+
+        inline unsigned char char_class(char c){
+                return char_class_holder<>::table.data[static_cast<unsigned char>(c)];
+        }
+        inline bool is_space(char c){ return ( char_class(c) & char_class_space ) != 0; }
+        inline bool is_digit(char c){ return ( char_class(c) & char_class_digit ) != 0; }
+        inline bool is_alpha(char c){ return ( char_class(c) & char_class_alpha ) != 0; }
+        inline bool is_ident(char c){ return ( char_class(c) & char_class_ident ) != 0; }
+        inline bool is_number_start(char c){ return ( char_class(c) & char_class_number ) != 0; }
+
+        /*
+                SWAR helpers, these look at 8 bytes at once and return
+                0x80 in each byte where the predicate holds
+         */
+        inline std::uint64_t swar_load_(char const* ptr){
+                std::uint64_t val;
+                std::memcpy(&val, ptr, sizeof(val));
+                #if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+                val = __builtin_bswap64(val);
+                #endif
+                return val;
+        }
+        inline std::uint64_t swar_broadcast_(unsigned char c){
+                return 0x0101010101010101ULL * c;
+        }
+        // bytes of x which are in [lo,hi], for hi < 128
+        inline std::uint64_t swar_in_range_(std::uint64_t x, unsigned char lo, unsigned char hi){
+                const std::uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+                const std::uint64_t high = 0x8080808080808080ULL;
+                std::uint64_t y = x & low7;
+                std::uint64_t ge = y + swar_broadcast_(static_cast<unsigned char>(128 - lo));
+                std::uint64_t gt = y + swar_broadcast_(static_cast<unsigned char>(127 - hi));
+                return ge & ~gt & ~x & high;
+        }
+        inline std::uint64_t swar_space_(std::uint64_t x){
+                return swar_in_range_(x, ' ', ' ') | swar_in_range_(x, '\t', '\r');
+        }
+        inline std::uint64_t swar_digit_(std::uint64_t x){
+                return swar_in_range_(x, '0', '9');
+        }
+        inline unsigned swar_first_(std::uint64_t mask){
+                return static_cast<unsigned>(__builtin_ctzll(mask)) / 8;
+        }
+
+        // first non-whitespace character in [first,last)
+        inline char const* skip_space(char const* first, char const* last){
+                for(; last - first >= 8; first += 8){
+                        std::uint64_t other = ~swar_space_(swar_load_(first)) & 0x8080808080808080ULL;
+                        if( other )
+                                return first + swar_first_(other);
+                }
+                for(; first != last && is_space(*first); ++first);
+                return first;
+        }
+        // first non-digit in [first,last)
+        inline char const* skip_digits(char const* first, char const* last){
+                for(; last - first >= 8; first += 8){
+                        std::uint64_t other = ~swar_digit_(swar_load_(first)) & 0x8080808080808080ULL;
+                        if( other )
+                                return first + swar_first_(other);
+                }
+                for(; first != last && is_digit(*first); ++first);
+                return first;
+        }
+
+} // detail
+} // gjson
+#endif // JSON_PARSER_CHAR_CLASS_H
@@ -0,0 +1,291 @@
+#ifndef JSON_PARSER_CODEGEN_H
+#define JSON_PARSER_CODEGEN_H
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <boost/exception/all.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "tokenizer.h"
+#include "string_scanner.h"
+#include "error.h"
+
+namespace gjson{
+namespace codegen{
+
+        /*
+                What the code from gjson_codegen leans on. The generated
+                structs each get
+                        template<class Tok> bool read(Tok& tok, T& out);
+                        void write(std::string& out, T const& value);
+                in their own namespace, and read/write here are the same for
+                the field types, found by ADL when one calls the other. The
+                reads go straight off the tokenizer, with no Maker or tree in
+                between, and fail with unexpected_type when the json is there
+                but not what the schema says. null is only allowed for an
+                optional field, where it's the same as the field not being
+                there
+         */
+
+        /*
+                What parse() reads with, strict json so a bare word isn't
+                taken for a string, and how deep we are, so opts.max_depth
+                holds for a type which holds itself
+         */
+        struct tokenizer : basic_tokenizer<char const*, strict_dialect>{
+                tokenizer(char const* first, char const* last, parse_options const& opts = parse_options{})
+                        : basic_tokenizer<char const*, strict_dialect>(first, last, opts)
+                        , max_depth(opts.max_depth)
+                {}
+                std::size_t depth{0};
+                // 0 is no limit
+                std::size_t max_depth;
+        };
+
+        // FNV-1a mixed with a seed, gjson_codegen searches for a seed which
+        // gives each key of a struct it's own slot
+        inline std::uint32_t key_hash(char const* s, std::size_t n, std::uint32_t seed){
+                std::uint32_t h = 2166136261u ^ seed;
+                for(std::size_t i=0;i!=n;++i){
+                        h ^= static_cast<unsigned char>(s[i]);
+                        h *= 16777619u;
+                }
+                return h ^ ( h >> 15 );
+        }
+        inline std::uint32_t key_hash(std::string const& s, std::uint32_t seed){
+                return key_hash(s.data(), s.size(), seed);
+        }
+
+        // there's a value of the wrong type, or no value at all
+        template<class Tok>
+        bool expected_(Tok& tok){
+                switch(tok.peak().type()){
+                case token_type::left_curl:
+                case token_type::left_br:
+                case token_type::string_:
+                case token_type::int_:
+                case token_type::float_:
+                case token_type::true_:
+                case token_type::false_:
+                case token_type::null_:
+                        tok.fail(error_code::unexpected_type);
+                        break;
+                default:
+                        tok.fail(error_code::expected_value);
+                        break;
+                }
+                return false;
+        }
+
+        // into a map or array, false with too_deep if it's one too many
+        template<class Tok>
+        bool enter_(Tok&){
+                return true;
+        }
+        inline bool enter_(tokenizer& tok){
+                if( tok.max_depth != 0 && tok.depth >= tok.max_depth ){
+                        tok.fail(error_code::too_deep);
+                        return false;
+                }
+                ++tok.depth;
+                return true;
+        }
+        template<class Tok>
+        void leave_(Tok&){}
+        inline void leave_(tokenizer& tok){
+                --tok.depth;
+        }
+
+        // null for an optional field, which is the same as it not being there
+        template<class Tok>
+        bool read_null(Tok& tok){
+                if( tok.peak().type() != token_type::null_ )
+                        return false;
+                tok.next();
+                return true;
+        }
+
+        template<class Tok>
+        bool read(Tok& tok, std::int64_t& out){
+                if( tok.peak().type() != token_type::int_ )
+                        return expected_(tok);
+                out = tok.peak().int_value();
+                tok.next();
+                return true;
+        }
+        template<class Tok>
+        bool read(Tok& tok, double& out){
+                token const& t = tok.peak();
+                if( t.type() == token_type::int_ ){
+                        out = static_cast<double>(t.int_value());
+                } else if( t.type() == token_type::float_ ){
+                        if( ! t.convertible() ){
+                                tok.fail(error_code::invalid_number);
+                                return false;
+                        }
+                        out = t.float_value();
+                } else {
+                        return expected_(tok);
+                }
+                tok.next();
+                return true;
+        }
+        template<class Tok>
+        bool read(Tok& tok, bool& out){
+                if( tok.peak().type() == token_type::true_ )
+                        out = true;
+                else if( tok.peak().type() == token_type::false_ )
+                        out = false;
+                else
+                        return expected_(tok);
+                tok.next();
+                return true;
+        }
+        template<class Tok>
+        bool read(Tok& tok, std::string& out){
+                if( tok.peak().type() != token_type::string_ )
+                        return expected_(tok);
+                out = tok.value(tok.peak());
+                tok.next();
+                return true;
+        }
+        template<class Tok, class T>
+        bool read(Tok& tok, std::vector<T>& out){
+                if( tok.peak().type() != token_type::left_br )
+                        return expected_(tok);
+                if( ! enter_(tok) )
+                        return false;
+                tok.next();
+                out.clear();
+                if( tok.peak().type() == token_type::right_br ){
+                        tok.next();
+                        leave_(tok);
+                        return true;
+                }
+                for(;;){
+                        out.emplace_back();
+                        if( ! read(tok, out.back()) )
+                                return false;
+                        if( tok.peak().type() == token_type::comma ){
+                                tok.next();
+                        } else if( tok.peak().type() == token_type::right_br ){
+                                tok.next();
+                                leave_(tok);
+                                return true;
+                        } else {
+                                tok.fail(error_code::expected_right_br);
+                                return false;
+                        }
+                }
+        }
+        /*
+                { key : value, ... } calling
+                        on_key(key)
+                with peak() at the value, which it has to read or skip. Gives
+                the same errors as basic_parser for a broken map
+         */
+        template<class Tok, class F>
+        bool read_map(Tok& tok, F on_key){
+                if( tok.peak().type() != token_type::left_curl )
+                        return expected_(tok);
+                if( ! enter_(tok) )
+                        return false;
+                tok.next();
+                for(bool first = true;; first = false){
+                        if( first && tok.peak().type() == token_type::right_curl )
+                                break;
+                        if( tok.peak().type() != token_type::string_ ){
+                                tok.fail(first ? error_code::expected_right_curl : error_code::expected_value);
+                                return false;
+                        }
+                        auto key = tok.value(tok.peak());
+                        tok.next();
+                        if( tok.peak().type() != token_type::colon ){
+                                tok.fail(first ? error_code::expected_right_curl : error_code::expected_value);
+                                return false;
+                        }
+                        tok.next();
+                        if( ! on_key(key) )
+                                return false;
+                        if( tok.peak().type() != token_type::comma )
+                                break;
+                        tok.next();
+                }
+                if( tok.peak().type() != token_type::right_curl ){
+                        tok.fail(error_code::expected_right_curl);
+                        return false;
+                }
+                tok.next();
+                leave_(tok);
+                return true;
+        }
+        // for keys the schema doesn't know about
+        template<class Tok>
+        bool skip(Tok& tok){
+                if( tok.skip_value() )
+                        return true;
+                tok.fail(error_code::expected_value);
+                return false;
+        }
+
+        inline void write(std::string& out, std::int64_t value){
+                out += std::to_string(value);
+        }
+        // json has no nan or inf, so they're null, which only reads back into an optional field
+        inline void write(std::string& out, double value){
+                if( ! std::isfinite(value) ){
+                        out += "null";
+                        return;
+                }
+                out += boost::lexical_cast<std::string>(value);
+        }
+        inline void write(std::string& out, bool value){
+                out += value ? "true" : "false";
+        }
+        inline void write(std::string& out, std::string const& value){
+                out += '"';
+                escape_string(value, out);
+                out += '"';
+        }
+        template<class T>
+        void write(std::string& out, std::vector<T> const& value){
+                out += '[';
+                for(std::size_t i=0;i!=value.size();++i){
+                        if( i != 0 )
+                                out += ',';
+                        write(out, value[i]);
+                }
+                out += ']';
+        }
+
+        // doesn't throw, returns false and fills in err on bad input
+        template<class T>
+        bool parse(std::string const& s, T& out, parse_error& err, parse_options const& opts = parse_options{}){
+                tokenizer tok(s.data(), s.data() + s.size(), opts);
+                if( read(tok, out) && ! tok.eos() )
+                        tok.fail(error_code::trailing_input);
+                err = tok.error();
+                return ! err;
+        }
+        // throws parse_exception on bad input
+        template<class T>
+        void parse(std::string const& s, T& out, parse_options const& opts = parse_options{}){
+                tokenizer tok(s.data(), s.data() + s.size(), opts);
+                if( read(tok, out) && ! tok.eos() )
+                        tok.fail(error_code::trailing_input);
+                if( tok.failed() )
+                        BOOST_THROW_EXCEPTION(parse_exception(tok.error(), tok.get_error()));
+        }
+        template<class T>
+        std::string to_json(T const& value){
+                std::string out;
+                write(out, value);
+                return out;
+        }
+
+} // codegen
+} // gjson
+#endif // JSON_PARSER_CODEGEN_H
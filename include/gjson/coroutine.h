@@ -0,0 +1,232 @@
+#ifndef JSON_PARSER_COROUTINE_H
+#define JSON_PARSER_COROUTINE_H
+
+#if ! defined(__cpp_impl_coroutine)
+#error "gjson/coroutine.h needs C++20 coroutines, see GJSON_COROUTINES"
+#endif
+
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <boost/exception/all.hpp>
+
+#include "push_parser.h"
+#include "stream.h"
+#include "error.h"
+
+namespace gjson{
+
+        /*
+                A coroutine which co_yields T's and can co_await in between,
+                from another coroutine it's
+
+                        auto gen = async_documents<JsonObjectMaker>(conn);
+                        while( auto* obj = co_await gen.next() )
+                                ...
+
+                next() gives nullptr at the end, and rethrows whatever the
+                generator threw. The generator runs on whichever thread
+                resumes it, there's no locking
+         */
+        template<class T>
+        struct async_generator{
+                struct promise_type;
+                using handle_type = std::coroutine_handle<promise_type>;
+
+                struct promise_type{
+                        // goes back to whoever is waiting in next()
+                        struct yield_awaiter{
+                                bool await_ready()noexcept{ return false; }
+                                std::coroutine_handle<> await_suspend(handle_type h)noexcept{
+                                        return h.promise().consumer_;
+                                }
+                                void await_resume()noexcept{}
+                        };
+
+                        async_generator get_return_object(){ return async_generator{handle_type::from_promise(*this)}; }
+                        std::suspend_always initial_suspend()noexcept{ return {}; }
+                        yield_awaiter final_suspend()noexcept{
+                                value_ = nullptr;
+                                return {};
+                        }
+                        // a temporary lives until we're resumed
+                        yield_awaiter yield_value(T& value)noexcept{
+                                value_ = std::addressof(value);
+                                return {};
+                        }
+                        yield_awaiter yield_value(T&& value)noexcept{
+                                value_ = std::addressof(value);
+                                return {};
+                        }
+                        void return_void(){}
+                        void unhandled_exception(){ exception_ = std::current_exception(); }
+
+                        T* value_{nullptr};
+                        std::exception_ptr exception_;
+                        std::coroutine_handle<> consumer_;
+                };
+
+                struct next_awaiter{
+                        bool await_ready()noexcept{ return gen_.done(); }
+                        std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer)noexcept{
+                                gen_.promise().consumer_ = consumer;
+                                return gen_;
+                        }
+                        T* await_resume(){
+                                if( auto e = std::exchange(gen_.promise().exception_, nullptr) )
+                                        std::rethrow_exception(e);
+                                return gen_.done() ? nullptr : gen_.promise().value_;
+                        }
+                        handle_type gen_;
+                };
+
+                async_generator(async_generator&& that)noexcept
+                        : handle_(std::exchange(that.handle_, nullptr))
+                {}
+                async_generator& operator=(async_generator&& that)noexcept{
+                        std::swap(handle_, that.handle_);
+                        return *this;
+                }
+                ~async_generator(){
+                        if( handle_ )
+                                handle_.destroy();
+                }
+
+                // the next value, or nullptr at the end
+                next_awaiter next(){ return next_awaiter{handle_}; }
+        private:
+                explicit async_generator(handle_type h)
+                        : handle_(h)
+                {}
+                handle_type handle_;
+        };
+
+        enum class event_type{
+                begin_map,
+                end_map,
+                begin_array,
+                end_array,
+                string_,
+                int_,
+                float_,
+                null_,
+                true_,
+                false_,
+                // a whole document, more might come after it
+                end_document,
+        };
+        struct event{
+                event_type type;
+                std::string string_value;
+                std::int64_t int_value{0};
+                double float_value{0};
+        };
+
+namespace detail{
+
+        struct event_maker_{
+                void begin_map(){ add_(event_type::begin_map); }
+                void end_map(){ add_(event_type::end_map); }
+                void begin_array(){ add_(event_type::begin_array); }
+                void end_array(){ add_(event_type::end_array); }
+                void make_string(std::string const& value){ add_(event_type::string_).string_value = value; }
+                void make_int(std::int64_t value){ add_(event_type::int_).int_value = value; }
+                void make_float(double value){ add_(event_type::float_).float_value = value; }
+                void make_null(){ add_(event_type::null_); }
+                void make_true(){ add_(event_type::true_); }
+                void make_false(){ add_(event_type::false_); }
+
+                event& add_(event_type type){
+                        events.push_back(event{type, std::string{}});
+                        return events.back();
+                }
+                std::vector<event> events;
+        };
+
+        [[noreturn]] inline void throw_parse_error_(parse_error const& err){
+                std::stringstream sstr;
+                sstr << "error: " << err.code << " at offset " << err.offset;
+                BOOST_THROW_EXCEPTION(parse_exception(err, sstr.str()));
+        }
+
+} // detail
+
+        /*
+                Sources for these are like the ones for parse_source(), but
+                read() is awaited, ie
+                        // 0 at the end, -1 if something went wrong
+                        awaitable<std::ptrdiff_t> read(char* buf, std::size_t n);
+                so the parse is suspended while there's nothing to read, and
+                one thread can have any number of them going. The source is
+                held by reference, so it has to outlive the generator
+
+                Each window is fed through basic_push_parser, with back to
+                back documents allowed like basic_document_reader. Bad input
+                or a failed read throws parse_exception from next()
+         */
+
+        // the events for each window as they're parsed, with end_document after each document
+        template<class Dialect = relaxed_dialect, class Source>
+        async_generator<event> async_events(Source& source, std::size_t window = default_stream_window,
+                                            parse_options opts = parse_options{})
+        {
+                detail::event_maker_ maker;
+                basic_push_parser<detail::event_maker_, Dialect> parser(maker, opts);
+                parser.on_document([&](){ maker.add_(event_type::end_document); });
+                std::vector<char> buf(window);
+                for(;;){
+                        std::ptrdiff_t n = co_await source.read(buf.data(), buf.size());
+                        if( n < 0 )
+                                detail::throw_parse_error_(parse_error{error_code::io_error, parser.consumed()});
+                        bool ok = n == 0 ? parser.finish()
+                                         : parser.feed(buf.data(), static_cast<std::size_t>(n));
+                        // whatever came before an error still comes out
+                        for(auto& e : maker.events)
+                                co_yield e;
+                        maker.events.clear();
+                        if( ! ok )
+                                detail::throw_parse_error_(parser.error());
+                        if( n == 0 )
+                                co_return;
+                }
+        }
+
+        // each document built with Maker, which is reset() between them
+        template<class Maker, class Dialect = relaxed_dialect, class Source>
+        async_generator<typename std::decay<decltype(std::declval<Maker&>().make())>::type>
+        async_documents(Source& source, std::size_t window = default_stream_window,
+                        parse_options opts = parse_options{}, Maker maker = Maker{})
+        {
+                using value_type = typename std::decay<decltype(std::declval<Maker&>().make())>::type;
+                basic_push_parser<Maker, Dialect> parser(maker, opts);
+                std::deque<value_type> ready;
+                parser.on_document([&](){
+                        ready.push_back(maker.make());
+                        maker.reset();
+                });
+                std::vector<char> buf(window);
+                for(;;){
+                        std::ptrdiff_t n = co_await source.read(buf.data(), buf.size());
+                        if( n < 0 )
+                                detail::throw_parse_error_(parse_error{error_code::io_error, parser.consumed()});
+                        bool ok = n == 0 ? parser.finish()
+                                         : parser.feed(buf.data(), static_cast<std::size_t>(n));
+                        for(; ! ready.empty(); ready.pop_front())
+                                co_yield ready.front();
+                        if( ! ok )
+                                detail::throw_parse_error_(parser.error());
+                        if( n == 0 )
+                                co_return;
+                }
+        }
+
+} // gjson
+#endif // JSON_PARSER_COROUTINE_H
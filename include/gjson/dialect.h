@@ -0,0 +1,53 @@
+#ifndef JSON_PARSER_DIALECT_H
+#define JSON_PARSER_DIALECT_H
+
+namespace gjson{
+
+        /*
+                Which grammar the tokenizer and parser accept, this is a
+                template parameter so each rule is a compile time constant
+                and the branches for the rules that are off go away.
+
+                relaxed_dialect is what we've always accepted, ie
+                        { 'a' : abc, 1 : +.5, b : 1e2.3 }
+                strict_dialect is RFC 8259
+         */
+        struct relaxed_dialect{
+                enum : bool{
+                        // 'abc'
+                        single_quotes     = true,
+                        // abc, and null is the string "null"
+                        bare_identifiers  = true,
+                        // +1
+                        leading_plus      = true,
+                        // .5 and 5.
+                        lax_fraction      = true,
+                        // 01
+                        leading_zeros     = true,
+                        // 1e2.3, which is tokenized but isn't a number
+                        exponent_fraction = true,
+                        // { 1 : 2 }
+                        non_string_keys   = true,
+                        // only a map or array at the top
+                        scalar_root       = false,
+                        // a raw tab or newline etc inside a string
+                        control_chars     = true,
+                };
+        };
+
+        struct strict_dialect{
+                enum : bool{
+                        single_quotes     = false,
+                        bare_identifiers  = false,
+                        leading_plus      = false,
+                        lax_fraction      = false,
+                        leading_zeros     = false,
+                        exponent_fraction = false,
+                        non_string_keys   = false,
+                        scalar_root       = true,
+                        control_chars     = false,
+                };
+        };
+
+} // gjson
+#endif // JSON_PARSER_DIALECT_H
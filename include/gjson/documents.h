@@ -0,0 +1,165 @@
+#ifndef JSON_PARSER_DOCUMENTS_H
+#define JSON_PARSER_DOCUMENTS_H
+
+#include <deque>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "basic_parser.h"
+#include "push_parser.h"
+#include "stream.h"
+
+namespace gjson{
+
+        /*
+                Input iterator over whatever next() gives, ie
+
+                        document_stream<JsonObjectMaker> docs(text);
+                        for(auto& obj : docs)
+                                ...
+                        if( docs.error() )
+                                ...
+         */
+        template<class Stream>
+        struct document_iterator : std::iterator<std::input_iterator_tag, typename Stream::value_type>{
+                using value_type = typename Stream::value_type;
+
+                document_iterator() = default;
+                explicit document_iterator(Stream& stream)
+                        : stream_(&stream)
+                {
+                        ++*this;
+                }
+                value_type& operator*(){ return value_; }
+                value_type* operator->(){ return &value_; }
+                document_iterator& operator++(){
+                        if( ! stream_->next(value_) )
+                                stream_ = nullptr;
+                        return *this;
+                }
+                bool operator==(document_iterator const& that)const{ return stream_ == that.stream_; }
+                bool operator!=(document_iterator const& that)const{ return stream_ != that.stream_; }
+        private:
+                Stream* stream_{nullptr};
+                value_type value_;
+        };
+
+        /*
+                Back to back documents in one buffer, with or without
+                whitespace between them, ie
+                        {"a":1}{"a":2} [3]
+                There's one tokenizer for the whole buffer, so the structural
+                index is built once, and one Maker which is reset() between
+                documents so it keeps its memory. Offsets in errors are from
+                the start of the buffer
+         */
+        template<class Maker, class Iter = char const*, class Dialect = relaxed_dialect>
+        struct basic_document_stream{
+                using value_type = typename std::decay<decltype(std::declval<Maker&>().make())>::type;
+                using iterator = document_iterator<basic_document_stream>;
+
+                basic_document_stream(Iter first, Iter last, parse_options const& opts = parse_options{},
+                                      Maker maker = Maker{})
+                        : maker_(std::move(maker))
+                        , parser_(maker_, first, last, opts)
+                {}
+                basic_document_stream(basic_document_stream const&) = delete;
+                basic_document_stream& operator=(basic_document_stream const&) = delete;
+
+                // false at the end or on bad input, error() tells them apart
+                bool next(value_type& out){
+                        maker_.reset();
+                        if( ! parser_.parse_next(error_) )
+                                return false;
+                        out = maker_.make();
+                        return true;
+                }
+                parse_error const& error()const{ return error_; }
+
+                iterator begin(){ return iterator(*this); }
+                iterator end(){ return iterator(); }
+        private:
+                Maker maker_;
+                basic_parser<Maker, Iter, Dialect> parser_;
+                parse_error error_;
+        };
+        template<class Maker, class Dialect = relaxed_dialect>
+        struct document_stream : basic_document_stream<Maker, char const*, Dialect>{
+                explicit document_stream(std::string const& s, parse_options const& opts = parse_options{},
+                                         Maker maker = Maker{})
+                        : basic_document_stream<Maker, char const*, Dialect>(s.data(), s.data() + s.size(), opts, std::move(maker))
+                {}
+        };
+
+        /*
+                The same from a source, see stream.h, which is read a window
+                at a time through the push parser. The documents finished in
+                each window are queued up and handed out one at a time
+         */
+        template<class Maker, class Source, class Dialect = relaxed_dialect>
+        struct basic_document_reader{
+                using value_type = typename std::decay<decltype(std::declval<Maker&>().make())>::type;
+                using iterator = document_iterator<basic_document_reader>;
+
+                explicit basic_document_reader(Source& source, std::size_t window = default_stream_window,
+                                               parse_options const& opts = parse_options{}, Maker maker = Maker{})
+                        : source_(source)
+                        , maker_(std::move(maker))
+                        , parser_(maker_, opts)
+                        , buf_(window)
+                {
+                        parser_.on_document([this](){
+                                ready_.push_back(maker_.make());
+                                maker_.reset();
+                        });
+                }
+                basic_document_reader(basic_document_reader const&) = delete;
+                basic_document_reader& operator=(basic_document_reader const&) = delete;
+
+                // false at the end or on bad input, error() tells them apart
+                bool next(value_type& out){
+                        while( ready_.empty() ){
+                                if( finished_ )
+                                        return false;
+                                read_();
+                        }
+                        out = std::move(ready_.front());
+                        ready_.pop_front();
+                        return true;
+                }
+                parse_error const& error()const{
+                        return io_error_ ? io_error_ : parser_.error();
+                }
+
+                iterator begin(){ return iterator(*this); }
+                iterator end(){ return iterator(); }
+        private:
+                void read_(){
+                        auto n = source_.read(buf_.data(), buf_.size());
+                        if( n < 0 ){
+                                io_error_.code = error_code::io_error;
+                                io_error_.offset = parser_.consumed();
+                                finished_ = true;
+                        } else if( n == 0 ){
+                                parser_.finish();
+                                finished_ = true;
+                        } else if( ! parser_.feed(buf_.data(), static_cast<std::size_t>(n)) ){
+                                // whatever was finished before the error still comes out
+                                finished_ = true;
+                        }
+                }
+
+                Source& source_;
+                Maker maker_;
+                basic_push_parser<Maker, Dialect> parser_;
+                std::vector<char> buf_;
+                std::deque<value_type> ready_;
+                parse_error io_error_;
+                bool finished_{false};
+        };
+
+} // gjson
+#endif // JSON_PARSER_DOCUMENTS_H
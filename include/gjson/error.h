@@ -0,0 +1,127 @@
+#ifndef JSON_PARSER_ERROR_H
+#define JSON_PARSER_ERROR_H
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <iostream>
+
+#include <boost/preprocessor.hpp>
+
+namespace gjson{
+
+        #define ERROR_CODES/**/\
+                (none)\
+                (unterminated_string)\
+                (invalid_escape)\
+                (invalid_unicode_escape)\
+                (invalid_number)\
+                (invalid_token)\
+                (unexpected_character)\
+                (expected_map_or_array)\
+                (expected_value)\
+                (expected_right_curl)\
+                (expected_right_br)\
+                (trailing_input)\
+                (io_error)\
+                (invalid_utf8)\
+                (too_deep)\
+                (unexpected_type)\
+                (missing_field)\
+                (out_of_memory)\
+
+        #define ERROR_ENUM_AUX(r,data,i,elem) BOOST_PP_COMMA_IF(i) elem
+        #define ERROR_STRING_AUX(r,data,elem)\
+                case error_code::elem:\
+                        return BOOST_PP_STRINGIZE(elem);
+        enum class error_code{
+                BOOST_PP_SEQ_FOR_EACH_I(ERROR_ENUM_AUX,~,ERROR_CODES)
+        };
+        inline
+        char const* to_string(error_code code){
+                switch(code){
+                        BOOST_PP_SEQ_FOR_EACH(ERROR_STRING_AUX,~,ERROR_CODES)
+                        default:
+                                __builtin_unreachable();
+                }
+        }
+        inline
+        std::ostream& operator<<(std::ostream& ostr, error_code code){
+                return ostr << to_string(code);
+        }
+        #undef ERROR_STRING_AUX
+        #undef ERROR_ENUM_AUX
+        #undef ERROR_CODES
+
+        /*
+                This is all we record when something goes wrong, so that
+                rejecting bad input is cheap. Anything more expensive, like
+                the line and column, is worked out from the offset when
+                someone asks for it
+         */
+        struct parse_error{
+                error_code code{error_code::none};
+                // byte offset into the input
+                std::size_t offset{0};
+
+                explicit operator bool()const{ return code != error_code::none; }
+        };
+
+        struct error_location{
+                // both 1 based
+                std::size_t line{1};
+                std::size_t column{1};
+        };
+
+        template<class Iter>
+        error_location locate(Iter first, Iter last, std::size_t offset){
+                error_location loc;
+                for(std::size_t i = 0; i != offset && first != last; ++i, ++first){
+                        if( *first == '\n' ){
+                                ++loc.line;
+                                loc.column = 1;
+                        } else {
+                                ++loc.column;
+                        }
+                }
+                return loc;
+        }
+
+        /*
+                Pretty message with some context, ie
+                        error: expected_right_br
+                         [ 23 -3455 ]
+                                ^
+         */
+        template<class Iter>
+        std::string describe(Iter first, Iter last, parse_error const& err){
+                enum{ before = 40, after = 40 };
+
+                auto size = static_cast<std::size_t>(std::distance(first, last));
+                auto offset = std::min(err.offset, size);
+                auto ctx_first = offset > before ? offset - before : 0;
+                auto ctx_last  = std::min(size, offset + after);
+
+                std::string ret = "error: ";
+                ret += to_string(err.code);
+                ret += "\n";
+                ret.append(std::next(first, ctx_first), std::next(first, ctx_last));
+                ret += "\n";
+                ret += std::string(offset - ctx_first, ' ');
+                ret += "^"; // no newline
+                return ret;
+        }
+
+        // what the throwing wrappers throw
+        struct parse_exception : std::domain_error{
+                parse_exception(parse_error const& err, std::string const& what)
+                        : std::domain_error{what}, error_{err}
+                {}
+                parse_error const& error()const{ return error_; }
+        private:
+                parse_error error_;
+        };
+
+} // gjson
+#endif // JSON_PARSER_ERROR_H
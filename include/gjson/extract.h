@@ -0,0 +1,333 @@
+#ifndef JSON_PARSER_EXTRACT_H
+#define JSON_PARSER_EXTRACT_H
+
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/exception/all.hpp>
+
+#include "basic_parser.h"
+#include "JsonObject.h"
+#include "JsonObjectMaker.h"
+
+namespace gjson{
+
+        /*
+                A handful of json pointers, ie
+                        ""              the whole document
+                        /user/id        the id in the user map
+                        /items/3        the fourth item, or the key "3" of a map
+                        /a~1b/c~0d      the keys "a/b" then "c~d"
+                where a step that's just * is any key or index, so items
+                then * then price is the price of every item. They're
+                made into a trie with the common prefixes shared, where each
+                node is a set of paths we're part way into. Going down a key
+                or an index is one lookup
+         */
+        struct path_set{
+                path_set(std::initializer_list<std::string> paths)
+                        : path_set(std::vector<std::string>(paths))
+                {}
+                path_set(std::vector<std::string> const& paths)
+                        : nodes_(1)
+                {
+                        for(std::size_t idx=0;idx!=paths.size();++idx)
+                                add_(paths[idx], idx);
+                }
+
+                static constexpr std::size_t root = 0;
+
+                // the nodes one down from node, appended to out
+                void step(std::size_t node, std::string const* key, std::vector<std::size_t>& out)const{
+                        auto const& n = nodes_[node];
+                        if( key ){
+                                auto iter = n.keys.find(*key);
+                                if( iter != n.keys.end() )
+                                        out.push_back(iter->second);
+                        }
+                        if( n.any != 0 )
+                                out.push_back(n.any);
+                }
+                void step(std::size_t node, std::size_t index, std::vector<std::size_t>& out)const{
+                        auto const& n = nodes_[node];
+                        auto iter = n.indices.find(index);
+                        if( iter != n.indices.end() )
+                                out.push_back(iter->second);
+                        if( n.any != 0 )
+                                out.push_back(n.any);
+                }
+                // which paths end at node, as indices into what we were made with
+                std::vector<std::size_t> const& ends(std::size_t node)const{ return nodes_[node].ends; }
+        private:
+                struct node_{
+                        std::map<std::string, std::size_t> keys;
+                        std::map<std::size_t, std::size_t> indices;
+                        // 0 is none, nothing points back to the root
+                        std::size_t any{0};
+                        std::vector<std::size_t> ends;
+                };
+
+                void add_(std::string const& path, std::size_t which){
+                        if( ! path.empty() && path[0] != '/' )
+                                BOOST_THROW_EXCEPTION(std::domain_error("path must be empty or start with /, got " + path));
+                        std::size_t node = root;
+                        for(std::size_t pos = 0; pos != path.size(); ){
+                                auto end = path.find('/', pos + 1);
+                                if( end == std::string::npos )
+                                        end = path.size();
+                                auto seg = path.substr(pos + 1, end - pos - 1);
+                                pos = end;
+
+                                if( seg == "*" ){
+                                        if( nodes_[node].any == 0 ){
+                                                auto next = new_node_();
+                                                nodes_[node].any = next;
+                                        }
+                                        node = nodes_[node].any;
+                                        continue;
+                                }
+                                seg = unescape_(seg);
+                                auto iter = nodes_[node].keys.find(seg);
+                                if( iter == nodes_[node].keys.end() ){
+                                        auto next = new_node_();
+                                        nodes_[node].keys[seg] = next;
+                                        // it's an index too, unless it has a leading 0
+                                        if( ! seg.empty() && seg.size() < 20 &&
+                                            seg.find_first_not_of("0123456789") == std::string::npos &&
+                                            ( seg[0] != '0' || seg.size() == 1 ) )
+                                                nodes_[node].indices[std::stoull(seg)] = next;
+                                        node = next;
+                                } else {
+                                        node = iter->second;
+                                }
+                        }
+                        nodes_[node].ends.push_back(which);
+                }
+                std::size_t new_node_(){
+                        nodes_.emplace_back();
+                        return nodes_.size() - 1;
+                }
+                // ~1 is / and ~0 is ~
+                static std::string unescape_(std::string const& seg){
+                        std::string out;
+                        for(std::size_t idx=0;idx!=seg.size();++idx){
+                                if( seg[idx] == '~' && idx + 1 != seg.size() && ( seg[idx+1] == '0' || seg[idx+1] == '1' ) ){
+                                        out += seg[idx+1] == '0' ? '~' : '/';
+                                        ++idx;
+                                } else {
+                                        out += seg[idx];
+                                }
+                        }
+                        return out;
+                }
+
+                std::vector<node_> nodes_;
+        };
+
+        /*
+                A Maker which walks the path_set as it goes. Anything no path
+                goes down is skipped by the parser (see maker_ctrl), and when
+                we reach the end of a path the value from there is built with
+                its own Maker, then
+                        callback(path, value)
+                with path the index into the path_set. So only what was asked
+                for is ever built. Paths which go through a value we're
+                already building still match, each gets its own copy
+         */
+        template<class Maker, class F>
+        struct path_extractor{
+                path_extractor(path_set const& paths, F& f)
+                        : paths_(paths), f_(f)
+                {}
+
+                maker_ctrl begin_map(){
+                        auto ctrl = value_();
+                        each_( [](Maker& m){ m.begin_map(); } );
+                        push_(true);
+                        return ctrl;
+                }
+                void end_map(){
+                        each_( [](Maker& m){ m.end_map(); } );
+                        pop_();
+                }
+                maker_ctrl begin_array(){
+                        auto ctrl = value_();
+                        each_( [](Maker& m){ m.begin_array(); } );
+                        push_(false);
+                        return ctrl;
+                }
+                void end_array(){
+                        each_( [](Maker& m){ m.end_array(); } );
+                        pop_();
+                }
+                maker_ctrl make_string(std::string const& value){
+                        auto g = [&](Maker& m){ m.make_string(value); };
+                        return at_key_() ? key_(&value, g) : scalar_(g);
+                }
+                maker_ctrl make_int(std::int64_t value){
+                        auto g = [&](Maker& m){ m.make_int(value); };
+                        if( at_key_() ){
+                                auto name = std::to_string(value);
+                                return key_(&name, g);
+                        }
+                        return scalar_(g);
+                }
+                // the rest can only be keys for * to match
+                maker_ctrl make_float(double value){
+                        auto g = [&](Maker& m){ m.make_float(value); };
+                        return at_key_() ? key_(nullptr, g) : scalar_(g);
+                }
+                maker_ctrl make_null(){
+                        auto g = [](Maker& m){ m.make_null(); };
+                        return at_key_() ? key_(nullptr, g) : scalar_(g);
+                }
+                maker_ctrl make_true(){
+                        auto g = [](Maker& m){ m.make_true(); };
+                        return at_key_() ? key_(nullptr, g) : scalar_(g);
+                }
+                maker_ctrl make_false(){
+                        auto g = [](Maker& m){ m.make_false(); };
+                        return at_key_() ? key_(nullptr, g) : scalar_(g);
+                }
+                // ready for another document
+                void reset(){
+                        frames_.clear();
+                        active_.clear();
+                        live_ = 0;
+                }
+        private:
+                struct frame_{
+                        // where our nodes start in active_, they go up to the next frame's
+                        std::size_t first;
+                        // the next index for an array
+                        std::size_t index;
+                        bool map;
+                        // a map which wants a key next
+                        bool key;
+                };
+                struct capture_{
+                        Maker maker;
+                        std::size_t depth;
+                        std::size_t node;
+                };
+
+                bool at_key_()const{
+                        return ! frames_.empty() && frames_.back().map && frames_.back().key;
+                }
+                // the start of a value, works out which nodes it's at into next_
+                maker_ctrl value_(){
+                        if( frames_.empty() ){
+                                next_.assign(1, std::size_t{path_set::root});
+                        } else if( ! frames_.back().map ){
+                                auto& top = frames_.back();
+                                next_.clear();
+                                for(std::size_t idx=top.first;idx!=active_.size();++idx)
+                                        paths_.step(active_[idx], top.index, next_);
+                                ++top.index;
+                        }
+                        // for a map key_() did it
+                        for(auto node : next_){
+                                if( ! paths_.ends(node).empty() )
+                                        capture_at_(node);
+                        }
+                        return next_.empty() && live_ == 0 ? maker_ctrl::skip : maker_ctrl::keep;
+                }
+                template<class G>
+                maker_ctrl key_(std::string const* name, G g){
+                        each_(g);
+                        auto& top = frames_.back();
+                        next_.clear();
+                        for(std::size_t idx=top.first;idx!=active_.size();++idx)
+                                paths_.step(active_[idx], name, next_);
+                        // the parser skips the value, so the next thing is a key again
+                        if( next_.empty() && live_ == 0 )
+                                return maker_ctrl::skip;
+                        top.key = false;
+                        return maker_ctrl::keep;
+                }
+                template<class G>
+                maker_ctrl scalar_(G g){
+                        value_();
+                        each_(g);
+                        end_value_();
+                        return maker_ctrl::keep;
+                }
+                void push_(bool map){
+                        frames_.push_back(frame_{active_.size(), 0, map, true});
+                        active_.insert(active_.end(), next_.begin(), next_.end());
+                }
+                void pop_(){
+                        active_.resize(frames_.back().first);
+                        frames_.pop_back();
+                        end_value_();
+                }
+                // hands over whatever was started at this value
+                void end_value_(){
+                        auto first = live_;
+                        while( first != 0 && captures_[first - 1].depth == frames_.size() )
+                                --first;
+                        for(auto idx = first; idx != live_; ++idx){
+                                auto value = captures_[idx].maker.make();
+                                for(auto which : paths_.ends(captures_[idx].node))
+                                        f_(which, value);
+                        }
+                        live_ = first;
+                        if( ! frames_.empty() )
+                                frames_.back().key = true;
+                }
+                void capture_at_(std::size_t node){
+                        // the makers are kept for the next capture, to keep their memory
+                        if( live_ == captures_.size() )
+                                captures_.push_back(capture_{Maker{}, 0, 0});
+                        auto& c = captures_[live_++];
+                        c.maker.reset();
+                        c.depth = frames_.size();
+                        c.node = node;
+                }
+                template<class G>
+                void each_(G g){
+                        for(std::size_t idx=0;idx!=live_;++idx)
+                                g(captures_[idx].maker);
+                }
+
+                path_set const& paths_;
+                F& f_;
+                std::vector<frame_> frames_;
+                std::vector<std::size_t> active_;
+                std::vector<std::size_t> next_;
+                std::vector<capture_> captures_;
+                std::size_t live_{0};
+        };
+
+        /*
+                Only what's at the paths is built, ie
+
+                        gjson::extract(text, {"/user/id", "/items/3/price"},
+                                [&](std::size_t path, JsonObject& value){
+                                        ...
+                                });
+
+                where path is 0 for /user/id and 1 for the price, called in
+                the order they are in the text. Makers other than JsonObjectMaker
+                need to be default constructible and have reset()
+         */
+        template<class Maker = JsonObjectMaker, class Dialect = relaxed_dialect, class F>
+        bool extract(std::string const& text, path_set const& paths, F f, parse_error& err,
+                     parse_options const& opts = parse_options{})
+        {
+                path_extractor<Maker, F> m(paths, f);
+                basic_parser<path_extractor<Maker, F>, char const*, Dialect> p(m, text.data(), text.data() + text.size(), opts);
+                return p.parse(err);
+        }
+        // throws parse_exception on bad input
+        template<class Maker = JsonObjectMaker, class Dialect = relaxed_dialect, class F>
+        void extract(std::string const& text, path_set const& paths, F f){
+                path_extractor<Maker, F> m(paths, f);
+                basic_parser<path_extractor<Maker, F>, char const*, Dialect> p(m, text.data(), text.data() + text.size());
+                p.parse();
+        }
+
+} // gjson
+#endif // JSON_PARSER_EXTRACT_H
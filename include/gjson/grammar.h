@@ -0,0 +1,432 @@
+#ifndef JSON_PARSER_GRAMMAR_H
+#define JSON_PARSER_GRAMMAR_H
+
+#include <vector>
+
+#include "tokenizer.h"
+#include "basic_parser.h"
+#include "error.h"
+
+namespace gjson{
+namespace detail{
+
+        /*
+                A stack which lives inside the object until it has more than
+                N things on it, as most documents aren't very deep
+         */
+        template<class T, std::size_t N>
+        struct small_stack{
+                std::size_t size()const{ return size_; }
+                bool empty()const{ return size_ == 0; }
+                T& back(){ return size_ <= N ? inline_[size_ - 1] : spill_.back(); }
+                T const& back()const{ return size_ <= N ? inline_[size_ - 1] : spill_.back(); }
+                void push_back(T const& value){
+                        if( size_ < N )
+                                inline_[size_] = value;
+                        else
+                                spill_.push_back(value);
+                        ++size_;
+                }
+                void pop_back(){
+                        if( size_ > N )
+                                spill_.pop_back();
+                        --size_;
+                }
+                void clear(){
+                        spill_.clear();
+                        size_ = 0;
+                }
+                void assign(std::size_t n, T const& value){
+                        clear();
+                        for(std::size_t i=0;i!=n;++i)
+                                push_back(value);
+                }
+        private:
+                T inline_[N];
+                std::vector<T> spill_;
+                std::size_t size_{0};
+        };
+
+        /*
+                The same grammar as basic_parser, but as a state machine with
+                an explicit stack instead of recursion, so it can be driven
+                one token at a time and stopped at any point. Each open map
+                or array is one entry on the stack, holding what we expect
+                to see next in it
+         */
+        struct grammar{
+                enum state : unsigned char{
+                        // expecting the top level map or array
+                        state_root,
+                        // seen the whole document
+                        state_done,
+                        // [ ^
+                        state_array_first,
+                        // [ 1, ^
+                        state_array_value,
+                        // [ 1 ^
+                        state_array_next,
+                        // { ^
+                        state_map_first,
+                        // { "a":1, ^
+                        state_map_key,
+                        // { "a" ^
+                        state_map_colon_first,
+                        // { "a":1, "b" ^
+                        state_map_colon,
+                        // { "a": ^
+                        state_map_value_first,
+                        // { "a":1, "b": ^
+                        state_map_value,
+                        // { "a":1 ^
+                        state_map_next,
+                        state_count,
+                };
+                enum input : unsigned char{
+                        input_scalar,
+                        input_left_curl,
+                        input_right_curl,
+                        input_left_br,
+                        input_right_br,
+                        input_comma,
+                        input_colon,
+                        // no more tokens
+                        input_end,
+                        input_count,
+                };
+                enum action : unsigned char{
+                        action_error,
+                        action_value,
+                        action_key,
+                        action_begin_map,
+                        action_begin_array,
+                        action_end_map,
+                        action_end_array,
+                        // just move to the next state
+                        action_shift,
+                };
+                struct transition{
+                        action act;
+                        // for action_shift and action_key
+                        state next;
+                };
+
+                static input classify(token_type type){
+                        switch(type){
+                        case token_type::left_curl:  return input_left_curl;
+                        case token_type::right_curl: return input_right_curl;
+                        case token_type::left_br:    return input_left_br;
+                        case token_type::right_br:   return input_right_br;
+                        case token_type::comma:      return input_comma;
+                        case token_type::colon:      return input_colon;
+                        case token_type::dummy:      return input_end;
+                        default:                     return input_scalar;
+                        }
+                }
+
+                static transition lookup(state s, input in){
+                        #define E { action_error      , state_root }
+                        #define V { action_value      , state_root }
+                        #define BM { action_begin_map  , state_root }
+                        #define BA { action_begin_array, state_root }
+                        #define EM { action_end_map    , state_root }
+                        #define EA { action_end_array  , state_root }
+                        #define K(next) { action_key  , next }
+                        #define S(next) { action_shift, next }
+                        static const transition table[state_count][input_count] = {
+                                //                     scalar                    {   }   [   ]   ,                       :                         end
+                                /* root            */ { E                       , BM, E , BA, E , E                      , E                       , E },
+                                /* done            */ { E                       , E , E , E , E , E                      , E                       , E },
+                                /* array_first     */ { V                       , BM, E , BA, EA, E                      , E                       , E },
+                                /* array_value     */ { V                       , BM, E , BA, E , E                      , E                       , E },
+                                /* array_next      */ { E                       , E , E , E , EA, S(state_array_value)   , E                       , E },
+                                /* map_first       */ { K(state_map_colon_first), E , EM, E , E , E                      , E                       , E },
+                                /* map_key         */ { K(state_map_colon)      , E , E , E , E , E                      , E                       , E },
+                                /* map_colon_first */ { E                       , E , E , E , E , E                      , S(state_map_value_first), E },
+                                /* map_colon       */ { E                       , E , E , E , E , E                      , S(state_map_value)      , E },
+                                /* map_value_first */ { V                       , BM, E , BA, E , E                      , E                       , E },
+                                /* map_value       */ { V                       , BM, E , BA, E , E                      , E                       , E },
+                                /* map_next        */ { E                       , E , EM, E , E , S(state_map_key)       , E                       , E },
+                        };
+                        #undef S
+                        #undef K
+                        #undef EA
+                        #undef EM
+                        #undef BA
+                        #undef BM
+                        #undef V
+                        #undef E
+                        return table[s][in];
+                }
+
+                /*
+                        What basic_parser reports for the same mistake, ie
+                        it's always "expected a ']'" until we've seen a comma
+                 */
+                static error_code error_for(state s){
+                        static const error_code table[state_count] = {
+                                /* root            */ error_code::expected_map_or_array,
+                                /* done            */ error_code::trailing_input,
+                                /* array_first     */ error_code::expected_right_br,
+                                /* array_value     */ error_code::expected_value,
+                                /* array_next      */ error_code::expected_right_br,
+                                /* map_first       */ error_code::expected_right_curl,
+                                /* map_key         */ error_code::expected_value,
+                                /* map_colon_first */ error_code::expected_right_curl,
+                                /* map_colon       */ error_code::expected_value,
+                                /* map_value_first */ error_code::expected_right_curl,
+                                /* map_value       */ error_code::expected_value,
+                                /* map_next        */ error_code::expected_right_curl,
+                        };
+                        return table[s];
+                }
+
+                // where we go once a value is finished
+                static state after_value(state s){
+                        switch(s){
+                        case state_root:
+                                return state_done;
+                        case state_array_first:
+                        case state_array_value:
+                                return state_array_next;
+                        default:
+                                return state_map_next;
+                        }
+                }
+        };
+
+        /*
+                Takes maker_ctrl::skip like basic_parser, what isn't wanted
+                still goes through the grammar but the Maker doesn't see it.
+                skip_started() is set when the last token opened a map or
+                array that's skipped, then whoever's driving can jump to its
+                end with skip_container() rather than feed us all of it.
+
+                Given the counts from count_containers(), a Maker with
+                begin_map(n) and begin_array(n) gets them, looked up by the
+                offset of the bracket like basic_parser does
+         */
+        template<class Maker, class Dialect = relaxed_dialect>
+        struct grammar_machine{
+                // max_depth of 0 is no limit
+                explicit grammar_machine(Maker& maker, std::size_t max_depth = 0)
+                        : maker_(maker), max_depth_(max_depth)
+                {
+                        stack_.push_back(grammar::state_root);
+                }
+
+                /*
+                        Feeds one token, tok is the tokenizer it came from so
+                        we can get the string value out. Returns
+                        error_code::none if the token was ok
+                 */
+                template<class Tokenizer>
+                error_code step(Tokenizer const& tok, token const& t){
+                        grammar::state& s = stack_.back();
+                        skip_started_ = false;
+                        auto in = grammar::classify(t.type());
+                        auto tr = grammar::lookup(s, in);
+                        if( Dialect::scalar_root && s == grammar::state_root && in == grammar::input_scalar )
+                                tr.act = grammar::action_value;
+                        if( ! Dialect::non_string_keys && tr.act == grammar::action_key && t.type() != token_type::string_ )
+                                tr.act = grammar::action_error;
+                        switch(tr.act){
+                        case grammar::action_error:
+                                return error_for_(s);
+                        case grammar::action_value:
+                                if( skipping_() || skip_value_ ){
+                                        skip_value_ = false;
+                                } else {
+                                        bool skip;
+                                        if( ! make_scalar_(tok, t, skip) )
+                                                return error_code::invalid_number;
+                                }
+                                s = grammar::after_value(s);
+                                return error_code::none;
+                        case grammar::action_key:
+                                if( ! skipping_() ){
+                                        if( ! make_scalar_(tok, t, skip_value_) )
+                                                return error_code::invalid_number;
+                                }
+                                s = tr.next;
+                                return error_code::none;
+                        case grammar::action_begin_map:
+                        {
+                                if( too_deep_() )
+                                        return error_code::too_deep;
+                                s = grammar::after_value(s);
+                                bool skip = ! skipping_() && ! skip_value_ && begin_map_(t.offset());
+                                stack_.push_back(grammar::state_map_first);
+                                begin_skip_(skip);
+                                return error_code::none;
+                        }
+                        case grammar::action_begin_array:
+                        {
+                                if( too_deep_() )
+                                        return error_code::too_deep;
+                                s = grammar::after_value(s);
+                                bool skip = ! skipping_() && ! skip_value_ && begin_array_(t.offset());
+                                stack_.push_back(grammar::state_array_first);
+                                begin_skip_(skip);
+                                return error_code::none;
+                        }
+                        case grammar::action_end_map:
+                                if( end_skip_() )
+                                        maker_.end_map();
+                                stack_.pop_back();
+                                return error_code::none;
+                        case grammar::action_end_array:
+                                if( end_skip_() )
+                                        maker_.end_array();
+                                stack_.pop_back();
+                                return error_code::none;
+                        case grammar::action_shift:
+                                s = tr.next;
+                                return error_code::none;
+                        }
+                        __builtin_unreachable();
+                }
+                // no more input, none if we've seen a whole document
+                error_code finish()const{
+                        if( done() )
+                                return error_code::none;
+                        return error_for_(stack_.back());
+                }
+                bool done()const{
+                        return stack_.size() == 1 && stack_.back() == grammar::state_done;
+                }
+                // how many maps and arrays we're inside
+                std::size_t depth()const{ return stack_.size() - 1; }
+                // nothing seen since the start, or since restart()
+                bool at_start()const{
+                        return stack_.size() == 1 && stack_.back() == grammar::state_root;
+                }
+                // for size_hints
+                void use_counts(std::vector<container_count> counts){
+                        counts_ = std::move(counts);
+                        counted_ = true;
+                        count_cursor_ = 0;
+                }
+                // the last token opened a map or array the Maker doesn't want
+                bool skip_started()const{ return skip_started_; }
+                // ready for another document
+                void restart(){
+                        stack_.assign(1, grammar::state_root);
+                        skip_value_ = false;
+                        skip_from_ = 0;
+                }
+        private:
+                // inside of something skipped, so the Maker sees none of it
+                bool skipping_()const{
+                        return skip_from_ != 0 && stack_.size() >= skip_from_;
+                }
+                /*
+                        Just pushed a map or array, which is skipped if the
+                        Maker said so from its begin, or the key before it
+                        did. Only the first of these gets the end
+                 */
+                void begin_skip_(bool skip){
+                        if( skipping_() || ! ( skip || skip_value_ ) )
+                                return;
+                        skip_from_ = stack_.size();
+                        skip_close_ = skip;
+                        skip_value_ = false;
+                        skip_started_ = true;
+                }
+                // true if the Maker skips it
+                bool begin_map_(std::size_t open){
+                        return begin_map_(open, takes_map_count<Maker>{});
+                }
+                bool begin_map_(std::size_t open, std::true_type){
+                        if( counted_ )
+                                return maker_skips( [&](){ return maker_.begin_map(count_(open)); } );
+                        return begin_map_(open, std::false_type{});
+                }
+                bool begin_map_(std::size_t, std::false_type){
+                        return maker_skips( [&](){ return maker_.begin_map(); } );
+                }
+                bool begin_array_(std::size_t open){
+                        return begin_array_(open, takes_array_count<Maker>{});
+                }
+                bool begin_array_(std::size_t open, std::true_type){
+                        if( counted_ )
+                                return maker_skips( [&](){ return maker_.begin_array(count_(open)); } );
+                        return begin_array_(open, std::false_type{});
+                }
+                bool begin_array_(std::size_t, std::false_type){
+                        return maker_skips( [&](){ return maker_.begin_array(); } );
+                }
+                // same as basic_parser's
+                std::size_t count_(std::size_t open){
+                        for(; count_cursor_ != counts_.size() && counts_[count_cursor_].offset < open; ++count_cursor_);
+                        if( count_cursor_ != counts_.size() && counts_[count_cursor_].offset == open )
+                                return counts_[count_cursor_].count;
+                        return 0;
+                }
+                // about to pop, true if the Maker wants the end
+                bool end_skip_(){
+                        if( ! skipping_() )
+                                return true;
+                        if( stack_.size() != skip_from_ )
+                                return false;
+                        skip_from_ = 0;
+                        return skip_close_;
+                }
+                bool too_deep_()const{
+                        return max_depth_ != 0 && depth() >= max_depth_;
+                }
+                static error_code error_for_(grammar::state s){
+                        if( Dialect::scalar_root && s == grammar::state_root )
+                                return error_code::expected_value;
+                        return grammar::error_for(s);
+                }
+                // skip is what the Maker said about it
+                template<class Tokenizer>
+                bool make_scalar_(Tokenizer const& tok, token const& t, bool& skip){
+                        switch(t.type()){
+                        case token_type::int_:
+                                skip = maker_skips( [&](){ return maker_.make_int( t.int_value() ); } );
+                                return true;
+                        case token_type::float_:
+                                if( ! t.convertible() )
+                                        return false;
+                                skip = maker_skips( [&](){ return maker_.make_float( t.float_value() ); } );
+                                return true;
+                        case token_type::string_:
+                                skip = maker_skips( [&](){ return make_string(maker_, tok, t, scratch_); } );
+                                return true;
+                        case token_type::true_:
+                                skip = maker_skips( [&](){ return maker_.make_true(); } );
+                                return true;
+                        case token_type::false_:
+                                skip = maker_skips( [&](){ return maker_.make_false(); } );
+                                return true;
+                        case token_type::null_:
+                                skip = maker_skips( [&](){ return maker_.make_null(); } );
+                                return true;
+                        default:
+                                __builtin_unreachable();
+                        }
+                }
+
+                Maker& maker_;
+                std::size_t max_depth_;
+                small_stack<grammar::state, 32> stack_;
+                // the key before said skip, so the value after it goes
+                bool skip_value_{false};
+                // when not 0, everything this deep on the stack is skipped
+                std::size_t skip_from_{0};
+                // whether the Maker saw the begin of what's skipped
+                bool skip_close_{false};
+                bool skip_started_{false};
+                // strings with escapes are decoded into this, for a Maker which takes a string_view
+                std::string scratch_;
+                // for size_hints
+                bool counted_{false};
+                std::vector<container_count> counts_;
+                std::size_t count_cursor_{0};
+        };
+
+} // detail
+} // gjson
+#endif // JSON_PARSER_GRAMMAR_H
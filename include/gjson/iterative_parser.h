@@ -0,0 +1,80 @@
+#ifndef JSON_PARSER_ITERATIVE_PARSER_H
+#define JSON_PARSER_ITERATIVE_PARSER_H
+
+#include <boost/exception/all.hpp>
+
+#include "tokenizer.h"
+#include "grammar.h"
+#include "error.h"
+
+namespace gjson{
+
+        /*
+                A drop in for basic_parser which doesn't recurse, each token
+                goes through the grammar table in grammar.h and the open maps
+                and arrays are an explicit stack. So how deep the input goes
+                costs heap rather than call stack, and opts.max_depth caps
+                that too. The Maker sees the same events, skips and
+                size_hints included, and bad input gets the same error, as
+                with basic_parser.
+
+                It isn't quicker though, a table lookup and a push or pop
+                per token costs more than the calls it saves, and
+                gjson_bench has it 20-25% behind basic_parser. It's for
+                input that might be too deep to recurse over
+         */
+        template <class Maker, class Iter, class Dialect = relaxed_dialect>
+        struct basic_iterative_parser{
+                basic_iterative_parser( Maker& maker, Iter first, Iter last, parse_options const& opts = parse_options{} )
+                      : tok_( first, last, opts )
+                      , machine_( maker, opts.max_depth )
+                {
+                        if( opts.size_hints && ( detail::takes_map_count<Maker>::value || detail::takes_array_count<Maker>::value ) ){
+                                std::vector<container_count> counts;
+                                tok_.count_containers(counts);
+                                machine_.use_counts(std::move(counts));
+                        }
+                }
+
+                // doesn't throw, returns false and fills in err on bad input
+                bool parse(parse_error& err){
+                        for(; ! tok_.eos();){
+                                token const& t = tok_.peak();
+                                auto code = machine_.step(tok_, t);
+                                if( code != error_code::none ){
+                                        tok_.fail(code);
+                                        break;
+                                }
+                                if( machine_.done() ){
+                                        tok_.next();
+                                        break;
+                                }
+                                // straight to the end of what the Maker doesn't want, like basic_parser
+                                if( machine_.skip_started() )
+                                        tok_.skip_container(t.offset());
+                                else
+                                        tok_.next();
+                        }
+                        if( ! machine_.done() )
+                                tok_.fail(machine_.finish());
+                        else if( ! eos() )
+                                tok_.fail(error_code::trailing_input);
+                        err = tok_.error();
+                        return ! err;
+                }
+                // throws parse_exception on bad input
+                void parse(){
+                        parse_error err;
+                        if( ! parse(err) )
+                                BOOST_THROW_EXCEPTION(parse_exception(err, tok_.get_error()));
+                }
+                bool eos()const{ return tok_.eos(); }
+                parse_error const& error()const{ return tok_.error(); }
+                error_location location()const{ return tok_.location(); }
+        private:
+                basic_tokenizer<Iter, Dialect> tok_;
+                detail::grammar_machine<Maker, Dialect> machine_;
+        };
+
+} // gjson
+#endif // JSON_PARSER_ITERATIVE_PARSER_H
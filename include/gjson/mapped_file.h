@@ -0,0 +1,109 @@
+#ifndef JSON_PARSER_MAPPED_FILE_H
+#define JSON_PARSER_MAPPED_FILE_H
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace gjson{
+
+        /*
+                Read only mapping of a whole file, so we can parse it in place
+                as a [char const*, char const*) range without reading it into
+                a string first. We tell the kernel we're going to read it
+                front to back so it reads ahead.
+
+                Only files whose size is what's in them, a pipe or a file
+                in /proc says it's empty whatever it has, so they fail with
+                ENODEV rather than look like an empty file. parse_fd() in
+                stream.h reads those
+         */
+        struct mapped_file{
+                mapped_file() = default;
+                mapped_file(mapped_file const&) = delete;
+                mapped_file& operator=(mapped_file const&) = delete;
+                mapped_file(mapped_file&& that)
+                        : data_{that.data_}, size_{that.size_}, errno_{that.errno_}
+                {
+                        that.data_ = 0;
+                        that.size_ = 0;
+                }
+                mapped_file& operator=(mapped_file&& that){
+                        std::swap(data_, that.data_);
+                        std::swap(size_, that.size_);
+                        std::swap(errno_, that.errno_);
+                        return *this;
+                }
+                ~mapped_file(){
+                        close();
+                }
+
+                // returns false and sets last_errno() on failure
+                bool open(std::string const& path){
+                        close();
+                        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                        if( fd < 0 )
+                                return fail_();
+                        struct stat st;
+                        if( ::fstat(fd, &st) != 0 ){
+                                fail_();
+                                ::close(fd);
+                                return false;
+                        }
+                        if( ! S_ISREG(st.st_mode) ){
+                                // what mmap would have said
+                                errno_ = S_ISDIR(st.st_mode) ? EISDIR : ENODEV;
+                                ::close(fd);
+                                return false;
+                        }
+                        size_ = static_cast<std::size_t>(st.st_size);
+                        // can't map nothing, but /proc files are all size 0
+                        if( size_ == 0 ){
+                                char c;
+                                auto n = ::read(fd, &c, 1);
+                                if( n != 0 )
+                                        errno_ = n < 0 ? errno : ENODEV;
+                                ::close(fd);
+                                return n == 0;
+                        }
+                        void* ptr = ::mmap(0, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                        ::close(fd);
+                        if( ptr == MAP_FAILED ){
+                                size_ = 0;
+                                return fail_();
+                        }
+                        ::madvise(ptr, size_, MADV_SEQUENTIAL);
+                        data_ = static_cast<char const*>(ptr);
+                        return true;
+                }
+                void close(){
+                        if( data_ )
+                                ::munmap(const_cast<char*>(data_), size_);
+                        data_ = 0;
+                        size_ = 0;
+                }
+
+                char const* begin()const{ return data_ ? data_ : ""; }
+                char const* end()const{ return begin() + size_; }
+                std::size_t size()const{ return size_; }
+                int last_errno()const{ return errno_; }
+                std::string last_error()const{ return std::strerror(errno_); }
+        private:
+                bool fail_(){
+                        errno_ = errno;
+                        return false;
+                }
+
+                char const* data_{0};
+                std::size_t size_{0};
+                int errno_{0};
+        };
+
+} // gjson
+#endif // JSON_PARSER_MAPPED_FILE_H
@@ -0,0 +1,223 @@
+#ifndef JSON_PARSER_NDJSON_H
+#define JSON_PARSER_NDJSON_H
+
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "basic_parser.h"
+#include "char_class.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
+
+namespace gjson{
+
+        struct ndjson_options{
+                // 0 is one per core
+                unsigned threads{0};
+                // lines handed to a worker at once
+                std::size_t batch_lines{1024};
+                // false gives each batch back as soon as it's done
+                bool ordered{true};
+                // carry on past bad lines, otherwise we stop at the first one
+                bool skip_bad{false};
+                parse_options parse;
+        };
+
+        struct ndjson_error{
+                // from 1
+                std::size_t line;
+                // the offset is from the start of the line
+                parse_error error;
+        };
+
+namespace detail{
+
+        struct ndjson_line_{
+                char const* first;
+                char const* last;
+                std::size_t line;
+        };
+
+        template<class Value>
+        struct ndjson_batch_{
+                std::size_t index;
+                std::vector<std::pair<std::size_t, Value> > values;
+                std::vector<ndjson_error> errors;
+                std::exception_ptr exception;
+        };
+
+        // the next batch_lines lines which aren't blank, memchr does the work
+        inline char const* next_ndjson_batch_(char const* first, char const* last, std::size_t& line,
+                                              std::size_t batch_lines, std::vector<ndjson_line_>& out)
+        {
+                out.clear();
+                while( first != last && out.size() < batch_lines ){
+                        auto nl = static_cast<char const*>(std::memchr(first, '\n', static_cast<std::size_t>(last - first)));
+                        char const* end = nl ? nl : last;
+                        ++line;
+                        if( skip_space(first, end) != end )
+                                out.push_back(ndjson_line_{first, end, line});
+                        first = nl ? nl + 1 : last;
+                }
+                return first;
+        }
+
+} // detail
+
+        /*
+                Newline delimited json, ie one document per line
+                        {"a":1}
+                        {"a":2}
+                Lines are cut up on this thread with memchr and handed out in
+                batches to a thread pool. Each batch gets a Maker from
+                factory(), which is reused for each line by calling make()
+                then reset(). For each good line we call
+                        callback(line, maker.make())
+                on this thread, in order unless opts.ordered is false, in
+                which case it's in whatever order the batches finish.
+
+                Bad lines are added to errors. Without opts.skip_bad we stop
+                at the first one, and the callback has seen every line
+                before it if we're in order. Blank lines are skipped but
+                still count. Returns true if every line was good
+         */
+        template<class Maker, class Dialect = relaxed_dialect, class Factory, class Callback>
+        bool parse_ndjson(char const* first, char const* last, Factory factory, Callback callback,
+                          std::vector<ndjson_error>& errors, ndjson_options const& opts = ndjson_options{})
+        {
+                using value_type = decltype(std::declval<Maker&>().make());
+                using batch_type = detail::ndjson_batch_<value_type>;
+
+                std::mutex mtx;
+                std::condition_variable cv;
+                std::vector<batch_type> done;
+
+                auto work = [&, factory](std::vector<detail::ndjson_line_> lines, std::size_t index){
+                        batch_type batch;
+                        batch.index = index;
+                        try{
+                                Maker maker = factory();
+                                for(auto const& l : lines){
+                                        basic_parser<Maker, char const*, Dialect> p(maker, l.first, l.last, opts.parse);
+                                        parse_error err;
+                                        if( p.parse(err) ){
+                                                batch.values.emplace_back(l.line, maker.make());
+                                        } else{
+                                                batch.errors.push_back(ndjson_error{l.line, err});
+                                                if( ! opts.skip_bad ){
+                                                        break;
+                                                }
+                                        }
+                                        maker.reset();
+                                }
+                        } catch(...){
+                                batch.exception = std::current_exception();
+                        }
+                        {
+                                std::lock_guard<std::mutex> lock(mtx);
+                                done.push_back(std::move(batch));
+                        }
+                        cv.notify_one();
+                };
+
+                std::size_t submitted = 0;
+                std::size_t finished = 0;
+                // batches waiting for an earlier one when we're in order
+                std::map<std::size_t, batch_type> waiting;
+                std::size_t next = 0;
+                bool stop = false;
+                std::exception_ptr exception;
+
+                auto deliver = [&](batch_type& batch){
+                        if( stop )
+                                return;
+                        if( batch.exception ){
+                                exception = batch.exception;
+                                stop = true;
+                                return;
+                        }
+                        for(auto& v : batch.values){
+                                // the first bad line in a batch stops it, so
+                                // later good ones can't be here
+                                callback(v.first, std::move(v.second));
+                        }
+                        errors.insert(errors.end(), batch.errors.begin(), batch.errors.end());
+                        if( ! batch.errors.empty() && ! opts.skip_bad )
+                                stop = true;
+                };
+                auto collect = [&](std::vector<batch_type>& ready){
+                        for(auto& batch : ready){
+                                ++finished;
+                                if( ! opts.ordered ){
+                                        deliver(batch);
+                                        continue;
+                                }
+                                waiting.emplace(batch.index, std::move(batch));
+                                for(auto iter = waiting.find(next); iter != waiting.end(); iter = waiting.find(next)){
+                                        deliver(iter->second);
+                                        waiting.erase(iter);
+                                        ++next;
+                                }
+                        }
+                        ready.clear();
+                };
+
+                {
+                        thread_pool pool(opts.threads);
+                        // enough in flight to keep everyone busy, without
+                        // holding the whole input as values
+                        std::size_t max_in_flight = pool.size() * 2;
+                        std::size_t line = 0;
+                        std::vector<detail::ndjson_line_> lines;
+                        std::vector<batch_type> ready;
+                        for(;;){
+                                if( first != last && ! stop && submitted - finished < max_in_flight ){
+                                        first = detail::next_ndjson_batch_(first, last, line, opts.batch_lines, lines);
+                                        if( ! lines.empty() ){
+                                                pool.submit([&work, batch = std::move(lines), index = submitted]()mutable{
+                                                        work(std::move(batch), index);
+                                                });
+                                                ++submitted;
+                                        }
+                                        continue;
+                                }
+                                if( submitted == finished )
+                                        break;
+                                {
+                                        std::unique_lock<std::mutex> lock(mtx);
+                                        cv.wait(lock, [&](){ return ! done.empty(); });
+                                        ready.swap(done);
+                                }
+                                collect(ready);
+                        }
+                }
+                if( exception )
+                        std::rethrow_exception(exception);
+                return errors.empty();
+        }
+        template<class Maker, class Dialect = relaxed_dialect, class Factory, class Callback>
+        bool parse_ndjson(std::string const& s, Factory factory, Callback callback,
+                          std::vector<ndjson_error>& errors, ndjson_options const& opts = ndjson_options{})
+        {
+                return parse_ndjson<Maker, Dialect>(s.data(), s.data() + s.size(), factory, callback, errors, opts);
+        }
+        // an io_error at line 0 if the file can't be mapped
+        template<class Maker, class Dialect = relaxed_dialect, class Factory, class Callback>
+        bool parse_ndjson_file(std::string const& path, Factory factory, Callback callback,
+                               std::vector<ndjson_error>& errors, ndjson_options const& opts = ndjson_options{})
+        {
+                mapped_file file;
+                if( ! file.open(path) ){
+                        errors.push_back(ndjson_error{0, parse_error{error_code::io_error, 0}});
+                        return false;
+                }
+                return parse_ndjson<Maker, Dialect>(file.begin(), file.end(), factory, callback, errors, opts);
+        }
+
+} // gjson
+#endif // JSON_PARSER_NDJSON_H
@@ -0,0 +1,230 @@
+#ifndef JSON_PARSER_NUMBER_PARSER_H
+#define JSON_PARSER_NUMBER_PARSER_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <string>
+
+#include "power_of_five_table.h"
+#include "char_class.h"
+
+namespace gjson{
+namespace detail{
+
+        /*
+                SWAR digit parsing, 8 ascii digits are loaded into one
+                64 bit word with swar_load_()
+         */
+        inline bool is_eight_digits_(std::uint64_t val){
+                return ( ( val & 0xF0F0F0F0F0F0F0F0ULL ) |
+                         ( ( ( val + 0x0606060606060606ULL ) & 0xF0F0F0F0F0F0F0F0ULL ) >> 4 ) ) == 0x3333333333333333ULL;
+        }
+        inline std::uint32_t parse_eight_digits_(std::uint64_t val){
+                const std::uint64_t mask = 0x000000FF000000FFULL;
+                const std::uint64_t mul1 = 0x000F424000000064ULL; // 100 + (1000000 << 32)
+                const std::uint64_t mul2 = 0x0000271000000001ULL; // 1 + (10000 << 32)
+                val -= 0x3030303030303030ULL;
+                val = ( val * 10 ) + ( val >> 8 );
+                val = ( ( ( val & mask ) * mul1 ) + ( ( ( val >> 16 ) & mask ) * mul2 ) ) >> 32;
+                return static_cast<std::uint32_t>(val);
+        }
+
+        /*
+                Accumulates the digits of a number as the tokenizer scans
+                them, so we end up with value = mantissa * 10^exponent.
+                Only the first 19 significant digits fit, anything after
+                that is dropped and marked as truncated
+         */
+        struct number_builder{
+                enum{ max_digits = 19 };
+
+                void digit(unsigned d, bool fraction){
+                        if( digits == 0 && d == 0 ){
+                                // leading zero
+                                if( fraction )
+                                        --exponent;
+                                return;
+                        }
+                        if( digits < max_digits ){
+                                mantissa = mantissa * 10 + d;
+                                ++digits;
+                                if( fraction )
+                                        --exponent;
+                        } else {
+                                truncated = true;
+                                if( ! fraction )
+                                        ++exponent;
+                        }
+                }
+                // true if there's room for 8 digits without leading zeros
+                bool can_take_eight()const{
+                        return digits != 0 && digits + 8 <= max_digits;
+                }
+                void eight_digits(std::uint32_t value, bool fraction){
+                        mantissa = mantissa * 100000000 + value;
+                        digits += 8;
+                        if( fraction )
+                                exponent -= 8;
+                }
+
+                bool negative{false};
+                std::uint64_t mantissa{0};
+                unsigned digits{0};
+                bool truncated{false};
+                // from the fraction digits, the explicit exponent is added later
+                std::int64_t exponent{0};
+        };
+
+        // true if it fits, otherwise the caller should treat it as a float
+        inline bool to_int64(number_builder const& nb, std::int64_t& out){
+                if( nb.truncated || nb.exponent != 0 )
+                        return false;
+                const std::uint64_t limit = static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max());
+                if( nb.negative ){
+                        if( nb.mantissa > limit + 1 )
+                                return false;
+                        out = static_cast<std::int64_t>( 0 - nb.mantissa );
+                } else {
+                        if( nb.mantissa > limit )
+                                return false;
+                        out = static_cast<std::int64_t>( nb.mantissa );
+                }
+                return true;
+        }
+
+        /*
+                Eisel-Lemire, w * 10^q to the nearest double. Returns false
+                in the rare case where the 128 bit product isn't precise
+                enough to decide the rounding
+         */
+        inline bool eisel_lemire_(std::uint64_t w, std::int64_t q, bool negative, double& out){
+                auto make = [&](std::uint64_t bits){
+                        if( negative )
+                                bits |= static_cast<std::uint64_t>(1) << 63;
+                        std::memcpy(&out, &bits, sizeof(out));
+                        return true;
+                };
+                const int mantissa_bits = 52;
+                const std::uint64_t infinity = static_cast<std::uint64_t>(0x7FF) << mantissa_bits;
+
+                if( w == 0 || q < smallest_power_of_five )
+                        return make(0);
+                if( q > largest_power_of_five )
+                        return make(infinity);
+
+                int lz = __builtin_clzll(w);
+                w <<= lz;
+
+                std::uint64_t const* table = power_of_five_128();
+                auto index = 2 * static_cast<std::size_t>(q - smallest_power_of_five);
+
+                __extension__ typedef unsigned __int128 u128;
+                u128 first = static_cast<u128>(w) * table[index];
+                std::uint64_t high = static_cast<std::uint64_t>(first >> 64);
+                std::uint64_t low  = static_cast<std::uint64_t>(first);
+                // we need the top 55 bits to be right
+                const std::uint64_t precision_mask = 0xFFFFFFFFFFFFFFFFULL >> ( mantissa_bits + 3 );
+                if( ( high & precision_mask ) == precision_mask ){
+                        u128 second = static_cast<u128>(w) * table[index + 1];
+                        std::uint64_t second_high = static_cast<std::uint64_t>(second >> 64);
+                        low += second_high;
+                        if( second_high > low )
+                                ++high;
+                }
+                if( low == 0xFFFFFFFFFFFFFFFFULL ){
+                        // 5^q is exact for these, so the product is too
+                        bool inside_safe_exponent = ( q >= -27 ) && ( q <= 55 );
+                        if( ! inside_safe_exponent )
+                                return false;
+                }
+
+                int upperbit = static_cast<int>(high >> 63);
+                std::uint64_t mantissa = high >> ( upperbit + 64 - mantissa_bits - 3 );
+                std::int64_t power2 = ( ( ( 152170 + 65536 ) * q ) >> 16 ) + 63 + upperbit - lz + 1023;
+
+                if( power2 <= 0 ){
+                        // subnormal
+                        if( -power2 + 1 >= 64 )
+                                return make(0);
+                        mantissa >>= -power2 + 1;
+                        mantissa += ( mantissa & 1 );
+                        mantissa >>= 1;
+                        power2 = ( mantissa < ( static_cast<std::uint64_t>(1) << mantissa_bits ) ) ? 0 : 1;
+                        return make( ( mantissa & ~( static_cast<std::uint64_t>(1) << mantissa_bits ) ) |
+                                     ( static_cast<std::uint64_t>(power2) << mantissa_bits ) );
+                }
+                // exactly half way, round to even instead of up
+                if( low <= 1 && q >= -4 && q <= 23 && ( mantissa & 3 ) == 1 ){
+                        if( ( mantissa << ( upperbit + 64 - mantissa_bits - 3 ) ) == high )
+                                mantissa &= ~static_cast<std::uint64_t>(1);
+                }
+                mantissa += ( mantissa & 1 );
+                mantissa >>= 1;
+                if( mantissa >= ( static_cast<std::uint64_t>(2) << mantissa_bits ) ){
+                        mantissa = static_cast<std::uint64_t>(1) << mantissa_bits;
+                        ++power2;
+                }
+                mantissa &= ~( static_cast<std::uint64_t>(1) << mantissa_bits );
+                if( power2 >= 0x7FF )
+                        return make(infinity);
+                return make( mantissa | ( static_cast<std::uint64_t>(power2) << mantissa_bits ) );
+        }
+
+        /*
+                Fast paths for nb.mantissa * 10^(nb.exponent + exp10), returns
+                false if we have to go the slow way
+         */
+        inline bool to_double(number_builder const& nb, std::int64_t exp10, double& out){
+                std::int64_t q = nb.exponent + exp10;
+                if( nb.truncated ){
+                        /*
+                                The real value is between mantissa and mantissa+1, if
+                                they round to the same double that's the answer
+                         */
+                        double upper;
+                        if( ! eisel_lemire_(nb.mantissa    , q, nb.negative, out) ||
+                            ! eisel_lemire_(nb.mantissa + 1, q, nb.negative, upper) )
+                        {
+                                return false;
+                        }
+                        return out == upper;
+                }
+                // Clinger, both the mantissa and the power of ten are exact doubles
+                if( nb.mantissa <= ( static_cast<std::uint64_t>(1) << 53 ) && -22 <= q && q <= 22 ){
+                        static const double powers[] = {
+                                1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+                        };
+                        double value = static_cast<double>(nb.mantissa);
+                        if( q < 0 )
+                                value /= powers[-q];
+                        else
+                                value *= powers[q];
+                        out = nb.negative ? -value : value;
+                        return true;
+                }
+                return eisel_lemire_(nb.mantissa, q, nb.negative, out);
+        }
+
+        // the slow way, for the odd number with more than 19 digits
+        inline bool to_double_fallback(std::string const& text, double& out){
+                std::istringstream istr(text);
+                istr.imbue(std::locale::classic());
+                istr >> out;
+                if( ! istr.fail() )
+                        return true;
+                // out of range gives us the largest double
+                if( std::fabs(out) == std::numeric_limits<double>::max() ){
+                        out = std::copysign(std::numeric_limits<double>::infinity(), out);
+                        return true;
+                }
+                return false;
+        }
+
+} // detail
+} // gjson
+#endif // JSON_PARSER_NUMBER_PARSER_H
@@ -0,0 +1,337 @@
+#ifndef JSON_PARSER_ON_DEMAND_H
+#define JSON_PARSER_ON_DEMAND_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <boost/exception/all.hpp>
+
+#include "tokenizer.h"
+#include "error.h"
+
+namespace gjson{
+
+        /*
+                Reads fields straight out of the text, ie
+
+                        on_demand_document doc(text);
+                        auto id = doc["user"]["id"].get_int64();
+
+                A value is just where it starts in the text, nothing is
+                built, and looking inside one walks the tokens from there,
+                jumping over anything we pass with skip_value, which goes
+                through the structural index with use_structural_index,
+                built once for all the lookups. So only the keys and values
+                walked over are checked, what's skipped only has to have
+                it's brackets match up.
+
+                Each object remembers where the last key it found was, and
+                the next lookup starts from there, going back round to the
+                start if need be. So reading fields in the order they are in
+                the text is one pass, and any other order still works. Keep
+                hold of a value, ie
+                        auto user = doc["user"];
+                to have that for more than one lookup.
+
+                The getters throw parse_exception. Errors are kept in the
+                value until then, so doc["a"]["b"] is missing_field if there's
+                no "a". The first syntax error we find sticks to the document.
+                The text has to outlive the document, and the document the
+                values
+         */
+        template<class Dialect = relaxed_dialect>
+        struct basic_on_demand_document{
+                using tokenizer_type = basic_tokenizer<char const*, Dialect>;
+
+                struct value{
+                        value() = default;
+
+                        // the field called key of an object
+                        value operator[](std::string const& key){
+                                return find_field_(key.data(), key.size());
+                        }
+                        value operator[](char const* key){
+                                return find_field_(key, std::strlen(key));
+                        }
+                        // the element at index of an array
+                        value operator[](std::size_t index){
+                                parse_error err;
+                                if( ! enter_(token_type::left_br, err) )
+                                        return failed_(err);
+                                auto& tok = doc_->tok_;
+                                if( tok.peak().type() == token_type::right_br )
+                                        return missing_();
+                                for(std::size_t i=0;i!=index;++i){
+                                        if( ! skip_(tok) )
+                                                return syntax_();
+                                        if( tok.peak().type() == token_type::right_br )
+                                                return missing_();
+                                        if( tok.peak().type() != token_type::comma ){
+                                                tok.fail(error_code::expected_right_br);
+                                                return syntax_();
+                                        }
+                                        tok.next();
+                                }
+                                return at_(tok.save_state_please());
+                        }
+                        value operator[](int index){
+                                return (*this)[static_cast<std::size_t>(index)];
+                        }
+
+                        /*
+                                f(element) for each element of an array, or
+                                f(key, value) for each field of an object
+                         */
+                        template<class F>
+                        void for_each(F f){
+                                check_();
+                                auto& tok = doc_->tok_;
+                                tok.restore_this_state_if_you_would_please(state_);
+                                bool map = tok.peak().type() == token_type::left_curl;
+                                parse_error err;
+                                if( ! enter_(map ? token_type::left_curl : token_type::left_br, err) )
+                                        throw_(err);
+                                auto close = map ? token_type::right_curl : token_type::right_br;
+                                if( tok.peak().type() != close ){
+                                        for(;;){
+                                                std::string key;
+                                                if( map && ! key_(tok, key) )
+                                                        break;
+                                                auto at = tok.save_state_please();
+                                                call_(f, key, at_(at), 0);
+                                                // whatever f did, we carry on from after the element
+                                                tok.restore_this_state_if_you_would_please(at);
+                                                if( ! skip_(tok) || tok.peak().type() != token_type::comma )
+                                                        break;
+                                                tok.next();
+                                        }
+                                        if( tok.peak().type() != close )
+                                                tok.fail(map ? error_code::expected_right_curl : error_code::expected_right_br);
+                                }
+                                check_();
+                        }
+
+                        std::int64_t get_int64(){
+                                auto const& t = scalar_();
+                                if( t.type() != token_type::int_ )
+                                        wrong_type_();
+                                return t.int_value();
+                        }
+                        double get_double(){
+                                auto const& t = scalar_();
+                                if( t.type() == token_type::int_ )
+                                        return static_cast<double>(t.int_value());
+                                if( t.type() != token_type::float_ )
+                                        wrong_type_();
+                                if( ! t.convertible() )
+                                        throw_(parse_error{error_code::invalid_number, t.offset()});
+                                return t.float_value();
+                        }
+                        bool get_bool(){
+                                auto const& t = scalar_();
+                                if( t.type() != token_type::true_ && t.type() != token_type::false_ )
+                                        wrong_type_();
+                                return t.type() == token_type::true_;
+                        }
+                        std::string get_string(){
+                                auto const& t = scalar_();
+                                if( t.type() != token_type::string_ )
+                                        wrong_type_();
+                                return doc_->tok_.value(t);
+                        }
+                        bool is_null(){
+                                return scalar_().type() == token_type::null_;
+                        }
+                        // left_curl, left_br, string_ etc for what's here
+                        token_type type(){
+                                return scalar_().type();
+                        }
+
+                        // none unless the getters would throw
+                        parse_error const& error()const{ return error_; }
+                        explicit operator bool()const{ return ! error_; }
+                private:
+                        friend struct basic_on_demand_document;
+                        using state_type = decltype(std::declval<tokenizer_type const&>().save_state_please());
+
+                        value(basic_on_demand_document* doc, state_type state)
+                                : doc_(doc), state_(state)
+                        {}
+
+                        value find_field_(char const* key, std::size_t n){
+                                parse_error err;
+                                if( ! enter_(token_type::left_curl, err) )
+                                        return failed_(err);
+                                auto& tok = doc_->tok_;
+                                if( ! started_ ){
+                                        first_key_ = resume_ = tok.save_state_please();
+                                        started_ = true;
+                                }
+                                // from the last key we found to the end, then from the start up to it
+                                tok.restore_this_state_if_you_would_please(resume_);
+                                std::size_t stop = resume_.peak_.offset();
+                                for(int pass = 0; pass != 2; ++pass){
+                                        bool first = true;
+                                        for(;;){
+                                                auto const& t = tok.peak();
+                                                if( pass == 1 && t.offset() >= stop )
+                                                        break;
+                                                if( first && t.type() == token_type::right_curl )
+                                                        break;
+                                                auto at_key = tok.save_state_please();
+                                                bool match = t.type() == token_type::string_ && key_equal_(t, key, n);
+                                                if( ! past_key_(tok) )
+                                                        return syntax_();
+                                                if( match ){
+                                                        resume_ = at_key;
+                                                        return at_(tok.save_state_please());
+                                                }
+                                                if( ! skip_(tok) )
+                                                        return syntax_();
+                                                if( tok.peak().type() == token_type::right_curl )
+                                                        break;
+                                                if( tok.peak().type() != token_type::comma ){
+                                                        tok.fail(error_code::expected_right_curl);
+                                                        return syntax_();
+                                                }
+                                                tok.next();
+                                                first = false;
+                                        }
+                                        tok.restore_this_state_if_you_would_please(first_key_);
+                                }
+                                return missing_();
+                        }
+                        // the key and colon, with peak() left on the value
+                        static bool key_(tokenizer_type& tok, std::string& key){
+                                if( tok.peak().type() == token_type::string_ )
+                                        key = tok.value(tok.peak());
+                                return past_key_(tok);
+                        }
+                        // the same without looking at what the key is
+                        static bool past_key_(tokenizer_type& tok){
+                                if( tok.peak().type() != token_type::string_ ){
+                                        tok.fail(error_code::expected_value);
+                                        return false;
+                                }
+                                tok.next();
+                                if( tok.peak().type() != token_type::colon ){
+                                        tok.fail(error_code::expected_value);
+                                        return false;
+                                }
+                                tok.next();
+                                return true;
+                        }
+                        bool key_equal_(token const& t, char const* key, std::size_t n)const{
+                                if( t.escaped() )
+                                        return doc_->tok_.value(t) == std::string(key, n);
+                                return t.length() == n && std::memcmp(doc_->first_ + t.offset(), key, n) == 0;
+                        }
+                        static bool skip_(tokenizer_type& tok){
+                                if( tok.skip_value() )
+                                        return true;
+                                tok.fail(error_code::expected_value);
+                                return false;
+                        }
+                        // past the { or [ we start with
+                        bool enter_(token_type open, parse_error& err){
+                                if( ! doc_ )
+                                        err = parse_error{error_code::expected_value, 0};
+                                if( error_ || ! doc_ ){
+                                        err = error_ ? error_ : err;
+                                        return false;
+                                }
+                                auto& tok = doc_->tok_;
+                                tok.restore_this_state_if_you_would_please(state_);
+                                if( tok.failed() ){
+                                        err = tok.error();
+                                        return false;
+                                }
+                                if( tok.peak().type() != open ){
+                                        err = parse_error{error_code::unexpected_type, tok.peak().offset()};
+                                        return false;
+                                }
+                                tok.next();
+                                return true;
+                        }
+                        token const& scalar_(){
+                                check_();
+                                auto& tok = doc_->tok_;
+                                tok.restore_this_state_if_you_would_please(state_);
+                                return tok.peak();
+                        }
+                        // f(key, value) if it takes that, otherwise f(value)
+                        template<class F>
+                        static auto call_(F& f, std::string const& key, value v, int) -> decltype(f(key, v), void()){
+                                f(key, v);
+                        }
+                        template<class F>
+                        static void call_(F& f, std::string const&, value v, long){
+                                f(v);
+                        }
+                        value at_(state_type state)const{
+                                return value(doc_, state);
+                        }
+                        value failed_(parse_error const& err)const{
+                                value v(doc_, state_);
+                                v.error_ = err;
+                                return v;
+                        }
+                        value missing_()const{
+                                return failed_(parse_error{error_code::missing_field, state_.peak_.offset()});
+                        }
+                        value syntax_()const{
+                                return failed_(doc_->tok_.error());
+                        }
+                        [[noreturn]] void wrong_type_()const{
+                                throw_(parse_error{error_code::unexpected_type, state_.peak_.offset()});
+                        }
+                        void check_()const{
+                                if( ! doc_ )
+                                        throw_(parse_error{error_code::expected_value, 0});
+                                if( error_ )
+                                        throw_(error_);
+                                if( doc_->tok_.failed() )
+                                        throw_(doc_->tok_.error());
+                        }
+                        [[noreturn]] void throw_(parse_error const& err)const{
+                                std::string what = doc_ ? describe(doc_->first_, doc_->last_, err) : to_string(err.code);
+                                BOOST_THROW_EXCEPTION(parse_exception(err, what));
+                        }
+
+                        basic_on_demand_document* doc_{nullptr};
+                        state_type state_;
+                        parse_error error_;
+                        // for objects, see find_field_
+                        bool started_{false};
+                        state_type first_key_;
+                        state_type resume_;
+                };
+
+                basic_on_demand_document(char const* first, char const* last, parse_options const& opts = parse_options{})
+                        : first_(first), last_(last), tok_(first, last, opts)
+                {
+                        root_ = value(this, tok_.save_state_please());
+                }
+                explicit basic_on_demand_document(std::string const& s, parse_options const& opts = parse_options{})
+                        : basic_on_demand_document(s.data(), s.data() + s.size(), opts)
+                {}
+                // we only look into the text, so it can't be a temporary
+                basic_on_demand_document(std::string&&, parse_options const& = parse_options{}) = delete;
+                basic_on_demand_document(basic_on_demand_document const&) = delete;
+                basic_on_demand_document& operator=(basic_on_demand_document const&) = delete;
+
+                value& root(){ return root_; }
+                template<class Key>
+                value operator[](Key&& key){ return root_[std::forward<Key>(key)]; }
+        private:
+                char const* first_;
+                char const* last_;
+                tokenizer_type tok_;
+                value root_;
+        };
+
+        using on_demand_document = basic_on_demand_document<>;
+
+} // gjson
+#endif // JSON_PARSER_ON_DEMAND_H
@@ -0,0 +1,251 @@
+#ifndef JSON_PARSER_PARALLEL_H
+#define JSON_PARSER_PARALLEL_H
+
+#include <cstdint>
+#include <future>
+#include <utility>
+#include <vector>
+
+#include "basic_parser.h"
+#include "char_class.h"
+#include "structural_index.h"
+#include "thread_pool.h"
+
+namespace gjson{
+
+        struct parallel_options{
+                // 0 is one per core
+                unsigned threads{0};
+                // pieces are at least this big, so small documents aren't split
+                std::size_t min_chunk{1 << 20};
+        };
+
+namespace detail{
+
+        /*
+                What a chunk does to the state, for both of the ways it
+                could start, [0] is outside a string and [1] inside
+         */
+        struct chunk_summary_{
+                // odd number of unescaped quotes
+                bool flips_string{false};
+                std::ptrdiff_t depth_change[2]{0, 0};
+                bool stray_single_quote[2]{false, false};
+        };
+
+        // the byte at pos is escaped if it follows an odd run of backslashes
+        inline bool escaped_at_(char const* first, char const* pos){
+                char const* iter = pos;
+                for(; iter != first && iter[-1] == '\\'; --iter);
+                return ( pos - iter ) % 2 == 1;
+        }
+
+        inline int depth_step_(char c){
+                switch(c){
+                case '{': case '[': return 1;
+                case '}': case ']': return -1;
+                default:            return 0;
+                }
+        }
+
+        /*
+                Same 64 byte blocks as the structural index, except we
+                don't know if we start inside a string, so we keep the
+                answer for both
+         */
+        inline chunk_summary_ summarize_chunk_(char const* body, char const* first, char const* last){
+                chunk_summary_ result;
+                std::uint64_t prev_escaped   = escaped_at_(body, first) ? 1 : 0;
+                std::uint64_t prev_in_string = 0;
+
+                std::size_t n = static_cast<std::size_t>(last - first);
+                char tail[64];
+                for(std::size_t offset = 0; offset < n; offset += 64){
+                        char const* block = first + offset;
+                        if( n - offset < 64 ){
+                                std::memset(tail, ' ', sizeof(tail));
+                                std::memcpy(tail, block, n - offset);
+                                block = tail;
+                        }
+                        auto m = classify_block_(block);
+
+                        std::uint64_t escaped = find_escaped_(m.backslash, prev_escaped);
+                        std::uint64_t quote = m.quote & ~escaped;
+                        std::uint64_t in_string = prefix_xor_(quote) ^ prev_in_string;
+                        prev_in_string = static_cast<std::uint64_t>( static_cast<std::int64_t>(in_string) >> 63 );
+
+                        // starting inside a string is just the other way round
+                        std::uint64_t outside[2] = { ~in_string, in_string };
+                        for(unsigned s=0;s!=2;++s){
+                                if( m.single_quote & outside[s] )
+                                        result.stray_single_quote[s] = true;
+                        }
+                        for(std::uint64_t bits = m.structural; bits; bits &= bits - 1 ){
+                                unsigned idx = static_cast<unsigned>(__builtin_ctzll(bits));
+                                unsigned s = ( outside[0] >> idx ) & 1 ? 0 : 1;
+                                result.depth_change[s] += depth_step_(block[idx]);
+                        }
+                }
+                result.flips_string = ( prev_in_string & 1 ) != 0;
+                return result;
+        }
+
+        // first comma directly inside the array, or last
+        inline char const* find_element_comma_(char const* body, char const* first, char const* last,
+                                                bool in_string, std::ptrdiff_t depth)
+        {
+                bool escaped = escaped_at_(body, first);
+                for(; first != last; ++first){
+                        if( escaped ){
+                                escaped = false;
+                        } else if( in_string ){
+                                if( *first == '\\' )
+                                        escaped = true;
+                                else if( *first == '"' )
+                                        in_string = false;
+                        } else if( *first == '"' ){
+                                in_string = true;
+                        } else if( *first == ',' && depth == 1 ){
+                                return first;
+                        } else {
+                                depth += depth_step_(*first);
+                        }
+                }
+                return last;
+        }
+
+} // detail
+
+        using text_range = std::pair<char const*, char const*>;
+
+        /*
+                Cuts a top level array into about parts pieces on element
+                boundaries, ie
+                        [ {"a":1}, "b,]", [2,3], 4 ]
+                          ^--------^     ^-------^
+                each range is one or more elements without the brackets or
+                the commas between the ranges.
+
+                Where to cut is decided without a serial scan. We guess at
+                evenly spaced offsets, then each piece works out what it
+                does to the depth and whether we're in a string for both
+                ways it could start, which are then chained together from
+                the front to pick the real one. Single quoted strings
+                can't be followed this way, so if there is one outside a
+                string we give up.
+
+                Returns nothing if the text isn't an array or can't be
+                split, that doesn't mean it's bad json. It doesn't mean it's
+                good json either, the pieces still have to be parsed
+         */
+        inline std::vector<text_range> split_top_level_array(char const* first, char const* last,
+                                                             std::size_t parts, thread_pool& pool)
+        {
+                std::vector<text_range> result;
+
+                first = detail::skip_space(first, last);
+                for(; last != first && detail::is_space(last[-1]); --last);
+                if( last - first < 2 || *first != '[' || last[-1] != ']' )
+                        return result;
+                char const* body = first + 1;
+                char const* body_last = last - 1;
+
+                std::size_t n = static_cast<std::size_t>(body_last - body);
+                if( parts < 2 || n < parts )
+                        return result;
+
+                std::vector<char const*> cuts(parts + 1);
+                for(std::size_t i=0;i!=parts;++i)
+                        cuts[i] = body + n / parts * i;
+                cuts[parts] = body_last;
+
+                std::vector<std::future<detail::chunk_summary_> > summaries;
+                for(std::size_t i=0;i!=parts;++i){
+                        char const* a = cuts[i];
+                        char const* b = cuts[i+1];
+                        summaries.push_back( pool.submit([=](){
+                                return detail::summarize_chunk_(body, a, b);
+                        }));
+                }
+
+                // now we know where each guess really starts
+                std::vector<bool> in_string(parts);
+                std::vector<std::ptrdiff_t> depth(parts);
+                bool s = false;
+                std::ptrdiff_t d = 1;
+                bool stray = false;
+                for(std::size_t i=0;i!=parts;++i){
+                        auto summary = summaries[i].get();
+                        in_string[i] = s;
+                        depth[i] = d;
+                        if( d < 1 )
+                                stray = true;
+                        stray = stray || summary.stray_single_quote[s];
+                        d += summary.depth_change[s];
+                        s = s != summary.flips_string;
+                }
+                if( stray )
+                        return result;
+
+                std::vector<std::future<char const*> > commas;
+                for(std::size_t i=1;i!=parts;++i){
+                        char const* a = cuts[i];
+                        char const* b = cuts[i+1];
+                        bool chunk_in_string = in_string[i];
+                        std::ptrdiff_t chunk_depth = depth[i];
+                        commas.push_back( pool.submit([=](){
+                                return detail::find_element_comma_(body, a, b, chunk_in_string, chunk_depth);
+                        }));
+                }
+
+                char const* start = body;
+                for(std::size_t i=1;i!=parts;++i){
+                        char const* comma = commas[i-1].get();
+                        // no element starts in this piece
+                        if( comma == cuts[i+1] )
+                                continue;
+                        result.emplace_back(start, comma);
+                        start = comma + 1;
+                }
+                result.emplace_back(start, body_last);
+                return result;
+        }
+
+        /*
+                Parses each range from split_top_level_array into its own
+                maker, made by factory(), on the pool. Each maker sees
+                        begin_array, the elements, end_array
+                so what comes out is an array per range, in order, and it's
+                up to the caller to join them. A range failing means the
+                whole thing has to be parsed serially to get the real error
+         */
+        template<class Maker, class Dialect = relaxed_dialect, class Factory>
+        bool parse_ranges(std::vector<text_range> const& ranges, Factory factory, std::vector<Maker>& out,
+                          thread_pool& pool, parse_options const& opts = parse_options{})
+        {
+                std::vector<std::future<std::pair<bool, Maker> > > jobs;
+                for(auto const& r : ranges){
+                        jobs.push_back( pool.submit([=](){
+                                std::pair<bool, Maker> ret(false, factory());
+                                ret.second.begin_array();
+                                basic_parser<Maker, char const*, Dialect> p(ret.second, r.first, r.second, opts);
+                                parse_error err;
+                                ret.first = p.parse_elements(err);
+                                if( ret.first )
+                                        ret.second.end_array();
+                                return ret;
+                        }));
+                }
+                bool ok = true;
+                out.clear();
+                out.reserve(jobs.size());
+                for(auto& job : jobs){
+                        auto ret = job.get();
+                        ok = ok && ret.first;
+                        out.push_back(std::move(ret.second));
+                }
+                return ok;
+        }
+
+} // gjson
+#endif // JSON_PARSER_PARALLEL_H
@@ -0,0 +1,316 @@
+#ifndef JSON_PARSER_PUSH_PARSER_H
+#define JSON_PARSER_PUSH_PARSER_H
+
+#include <functional>
+#include <string>
+
+#include "tokenizer.h"
+#include "grammar.h"
+#include "error.h"
+
+namespace gjson{
+
+        /*
+                Parses a document that arrives in pieces, ie
+
+                        JsonObjectMaker m;
+                        basic_push_parser<JsonObjectMaker> p(m);
+                        while( read some chunk )
+                                if( ! p.feed(chunk.data(), chunk.size()) )
+                                        break;
+                        if( p.finish() )
+                                auto obj = m.make();
+
+                Each chunk is tokenized in place, and the Maker sees events as
+                soon as we know them. A chunk can end anywhere, if it ends in
+                the middle of a token then just that token is copied into
+                pending_ until we've seen the end of it. The Maker sees the
+                same events as it would from basic_parser, and a map or
+                array it skips is gone over looking at nothing but brackets
+                and quotes the same way, however it's split up. The one
+                thing it can't do is size_hints, as that needs the whole
+                document up front, so begin_map(n) and begin_array(n) are
+                never called
+         */
+        template<class Maker, class Dialect = relaxed_dialect>
+        struct basic_push_parser{
+                using tokenizer_type = basic_tokenizer<char const*, Dialect>;
+
+                explicit basic_push_parser(Maker& maker, parse_options const& opts = parse_options{})
+                        : machine_(maker, opts.max_depth), options_(opts)
+                {}
+
+                // returns false once there's been an error
+                bool feed(char const* ptr, std::size_t n){
+                        if( failed() )
+                                return false;
+                        char const* last = ptr + n;
+                        if( ! pending_.empty() ){
+                                char const* end = scan_token_end_(ptr, last);
+                                pending_.append(ptr, end ? end : last);
+                                if( ! end ){
+                                        consumed_ += n;
+                                        return true;
+                                }
+                                if( ! run_(pending_.data(), pending_.data() + pending_.size(), pending_offset_, true) )
+                                        return false;
+                                pending_.clear();
+                                std::size_t used = static_cast<std::size_t>(end - ptr);
+                                consumed_ += used;
+                                ptr = end;
+                        }
+                        std::size_t offset = consumed_;
+                        consumed_ += static_cast<std::size_t>(last - ptr);
+                        return run_(ptr, last, offset, false);
+                }
+                bool feed(std::string const& s){
+                        return feed(s.data(), s.size());
+                }
+                /*
+                        For back to back documents, ie {..}{..}[..], f() is
+                        called as soon as each one is finished and we start on
+                        the next, rather than the rest being trailing input
+                 */
+                void on_document(std::function<void()> f){
+                        on_document_ = std::move(f);
+                }
+                /*
+                        No more input, returns true if we've seen a whole
+                        document
+                 */
+                bool finish(){
+                        if( failed() )
+                                return false;
+                        if( ! pending_.empty() ){
+                                if( ! run_(pending_.data(), pending_.data() + pending_.size(), pending_offset_, true) )
+                                        return false;
+                                pending_.clear();
+                        }
+                        // with on_document we can end between documents
+                        if( on_document_ && machine_.at_start() )
+                                return true;
+                        auto code = machine_.finish();
+                        if( code != error_code::none ){
+                                error_.code = code;
+                                error_.offset = consumed_;
+                                return false;
+                        }
+                        return true;
+                }
+
+                bool done()const{ return machine_.done(); }
+                bool failed()const{ return !! error_; }
+                parse_error const& error()const{ return error_; }
+                // how many bytes we've been fed
+                std::size_t consumed()const{ return consumed_; }
+        private:
+                static bool is_scalar_(token_type type){
+                        switch(type){
+                        case token_type::string_:
+                        case token_type::int_:
+                        case token_type::float_:
+                        case token_type::true_:
+                        case token_type::false_:
+                        case token_type::null_:
+                                return true;
+                        default:
+                                return false;
+                        }
+                }
+                static std::size_t token_end_(token const& t){
+                        return t.offset() + t.length() + ( t.quoted() ? 1 : 0 );
+                }
+
+                /*
+                        Tokenizes [first,last), offset is where first is in the
+                        whole input. Unless final is set, a token that might
+                        carry on into the next chunk is left in pending_
+                 */
+                bool run_(char const* first, char const* last, std::size_t offset, bool final){
+                        for(;;){
+                                if( skip_depth_ != 0 ){
+                                        char const* close = skip_raw_(first, last);
+                                        if( ! close )
+                                                return true;
+                                        offset += static_cast<std::size_t>(close - first);
+                                        first = close;
+                                }
+                                std::size_t skip_from = 0;
+                                if( ! tokenize_(first, last, offset, final, skip_from) )
+                                        return false;
+                                if( skip_from == 0 )
+                                        return true;
+                                // carry on after the bracket that started the skip
+                                skip_depth_ = 1;
+                                first += skip_from;
+                                offset += skip_from;
+                        }
+                }
+                /*
+                        What run_ does between skips, if the Maker skips a map
+                        or array skip_from is set to just after its bracket
+                 */
+                bool tokenize_(char const* first, char const* last, std::size_t offset, bool final, std::size_t& skip_from){
+                        tokenizer_type tok(first, last, options_);
+                        std::size_t size = static_cast<std::size_t>(last - first);
+                        // end of the last token we used
+                        std::size_t resume = 0;
+                        for(;;){
+                                if( tok.failed() ){
+                                        char const* start = detail::skip_space(first + resume, last);
+                                        if( ! final ){
+                                                reset_scan_();
+                                                if( ! scan_token_end_(start, last) ){
+                                                        stash_(start, last, offset + static_cast<std::size_t>(start - first));
+                                                        return true;
+                                                }
+                                        }
+                                        error_.code = tok.error().code;
+                                        error_.offset = offset + tok.error().offset;
+                                        return false;
+                                }
+                                token const& t = tok.peak();
+                                if( t.type() == token_type::dummy )
+                                        return true;
+                                if( ! final && ! t.quoted() && is_scalar_(t.type()) && token_end_(t) == size ){
+                                        // 123 could be 12345
+                                        reset_scan_();
+                                        scan_token_end_(first + t.offset(), last);
+                                        stash_(first + t.offset(), last, offset + t.offset());
+                                        return true;
+                                }
+                                auto code = machine_.step(tok, t);
+                                if( code != error_code::none ){
+                                        error_.code = code;
+                                        error_.offset = offset + t.offset();
+                                        return false;
+                                }
+                                if( on_document_ && machine_.done() ){
+                                        on_document_();
+                                        machine_.restart();
+                                }
+                                resume = token_end_(t);
+                                if( machine_.skip_started() ){
+                                        skip_from = resume;
+                                        return true;
+                                }
+                                tok.next();
+                        }
+                }
+                /*
+                        Goes over what the Maker doesn't want, like the
+                        tokenizer's skip_container(), carrying on from where
+                        the last chunk left off. Returns the bracket that
+                        closes it, or 0 if it's not in [iter,last)
+                 */
+                char const* skip_raw_(char const* iter, char const* last){
+                        for(; iter != last; ++iter){
+                                if( skip_quote_ ){
+                                        if( skip_escape_ ){
+                                                skip_escape_ = false;
+                                                continue;
+                                        }
+                                        iter = detail::find_quote_or_backslash(iter, last, skip_quote_);
+                                        if( iter == last )
+                                                return 0;
+                                        if( *iter == '\\' )
+                                                skip_escape_ = true;
+                                        else
+                                                skip_quote_ = 0;
+                                        continue;
+                                }
+                                switch(*iter){
+                                case '\'':
+                                        if( ! Dialect::single_quotes )
+                                                break;
+                                        BOOST_FALLTHROUGH;
+                                case '"':
+                                        skip_quote_ = *iter;
+                                        break;
+                                case '{': case '[':
+                                        ++skip_depth_;
+                                        break;
+                                case '}': case ']':
+                                        if( --skip_depth_ == 0 )
+                                                return iter;
+                                        break;
+                                }
+                        }
+                        return 0;
+                }
+                void stash_(char const* first, char const* last, std::size_t offset){
+                        pending_.assign(first, last);
+                        pending_offset_ = offset;
+                }
+
+                /*
+                        Finds the end of a partial token, carrying on from where
+                        the last call left off. Returns 0 if it's not in
+                        [iter,last)
+                 */
+                void reset_scan_(){
+                        scan_started_ = false;
+                        scan_quote_ = 0;
+                        scan_escape_ = false;
+                }
+                char const* scan_token_end_(char const* iter, char const* last){
+                        if( ! scan_started_ ){
+                                if( iter == last )
+                                        return 0;
+                                scan_started_ = true;
+                                if( *iter == '"' || *iter == '\'' ){
+                                        scan_quote_ = *iter;
+                                        ++iter;
+                                }
+                        }
+                        if( scan_quote_ ){
+                                for(; iter != last;){
+                                        if( scan_escape_ ){
+                                                scan_escape_ = false;
+                                                ++iter;
+                                                continue;
+                                        }
+                                        iter = detail::find_quote_or_backslash(iter, last, scan_quote_);
+                                        if( iter == last )
+                                                break;
+                                        if( *iter == '\\' ){
+                                                scan_escape_ = true;
+                                                ++iter;
+                                                continue;
+                                        }
+                                        return iter + 1;
+                                }
+                                return 0;
+                        }
+                        for(; iter != last; ++iter){
+                                char c = *iter;
+                                if( detail::is_space(c) || c == '"' || c == '\'' ||
+                                    ( detail::char_class(c) & detail::char_class_structural ) )
+                                {
+                                        return iter;
+                                }
+                        }
+                        return 0;
+                }
+
+                detail::grammar_machine<Maker, Dialect> machine_;
+                parse_options options_;
+                parse_error error_;
+                std::size_t consumed_{0};
+                std::function<void()> on_document_;
+
+                // a token split between chunks
+                std::string pending_;
+                std::size_t pending_offset_{0};
+                bool scan_started_{false};
+                char scan_quote_{0};
+                bool scan_escape_{false};
+
+                // inside of a map or array the Maker skipped
+                std::size_t skip_depth_{0};
+                char skip_quote_{0};
+                bool skip_escape_{false};
+        };
+
+} // gjson
+#endif // JSON_PARSER_PUSH_PARSER_H
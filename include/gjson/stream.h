@@ -0,0 +1,104 @@
+#ifndef JSON_PARSER_STREAM_H
+#define JSON_PARSER_STREAM_H
+
+#include <cerrno>
+#include <istream>
+#include <vector>
+
+#include <unistd.h>
+
+#include "push_parser.h"
+#include "error.h"
+
+namespace gjson{
+
+        /*
+                Sources for parse_source(), anything with
+                        // 0 at the end, -1 if something went wrong
+                        std::ptrdiff_t read(char* buf, std::size_t n);
+         */
+        struct istream_source{
+                explicit istream_source(std::istream& istr)
+                        : istr_(istr)
+                {}
+                std::ptrdiff_t read(char* buf, std::size_t n){
+                        istr_.read(buf, static_cast<std::streamsize>(n));
+                        if( istr_.bad() )
+                                return -1;
+                        return static_cast<std::ptrdiff_t>(istr_.gcount());
+                }
+        private:
+                std::istream& istr_;
+        };
+
+        // doesn't own the fd
+        struct fd_source{
+                explicit fd_source(int fd)
+                        : fd_(fd)
+                {}
+                std::ptrdiff_t read(char* buf, std::size_t n){
+                        for(;;){
+                                auto ret = ::read(fd_, buf, n);
+                                if( ret < 0 && errno == EINTR )
+                                        continue;
+                                return static_cast<std::ptrdiff_t>(ret);
+                        }
+                }
+        private:
+                int fd_;
+        };
+
+        enum{ default_stream_window = 64 * 1024 };
+
+        /*
+                Reads the source window bytes at a time into the same buffer
+                and pushes each one through basic_push_parser, so the memory
+                we use is the window plus the longest token, however big the
+                input is
+         */
+        template<class Maker, class Source>
+        bool parse_source(Maker& maker, Source& source, parse_error& err,
+                          std::size_t window = default_stream_window,
+                          parse_options const& opts = parse_options{})
+        {
+                std::vector<char> buf(window);
+                basic_push_parser<Maker> p(maker, opts);
+                for(;;){
+                        auto n = source.read(buf.data(), buf.size());
+                        if( n < 0 ){
+                                err.code = error_code::io_error;
+                                err.offset = p.consumed();
+                                return false;
+                        }
+                        if( n == 0 )
+                                break;
+                        if( ! p.feed(buf.data(), static_cast<std::size_t>(n)) ){
+                                err = p.error();
+                                return false;
+                        }
+                }
+                if( ! p.finish() ){
+                        err = p.error();
+                        return false;
+                }
+                return true;
+        }
+        template<class Maker>
+        bool parse_stream(Maker& maker, std::istream& istr, parse_error& err,
+                          std::size_t window = default_stream_window,
+                          parse_options const& opts = parse_options{})
+        {
+                istream_source source(istr);
+                return parse_source(maker, source, err, window, opts);
+        }
+        template<class Maker>
+        bool parse_fd(Maker& maker, int fd, parse_error& err,
+                      std::size_t window = default_stream_window,
+                      parse_options const& opts = parse_options{})
+        {
+                fd_source source(fd);
+                return parse_source(maker, source, err, window, opts);
+        }
+
+} // gjson
+#endif // JSON_PARSER_STREAM_H
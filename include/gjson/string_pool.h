@@ -0,0 +1,71 @@
+#ifndef JSON_PARSER_STRING_POOL_H
+#define JSON_PARSER_STRING_POOL_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_view.hpp>
+
+namespace gjson{
+
+        /*
+                Strings which come up again and again, like the keys in an
+                array of records, kept once and handed out as shared
+                immutable copies, see JsonObjectMaker. The lookup is on a
+                view of the text, so a string we already have costs no
+                allocation at all.
+
+                Short strings, like "home" or "fax", aren't pooled by
+                default. Up to 15 chars std::string keeps them in it's own
+                buffer, inside the JsonObject, so an unpooled one costs no
+                heap either, where a pooled one is a shared_ptr, a refcount
+                bump for every copy and a hash lookup for every parse. 16 is
+                the first length which would go on the heap with libstdc++
+                and libc++; pass a smaller min_length to pool them anyway.
+                One pool can be kept for a batch of parses, but it isn't
+                locked, so one thread at a time
+         */
+        struct string_pool{
+                using value_type = std::shared_ptr<std::string const>;
+
+                explicit string_pool(std::size_t min_length = 16, std::size_t max_length = 256,
+                                     std::size_t max_strings = 1 << 16)
+                        : min_length_(min_length), max_length_(max_length), max_strings_(max_strings)
+                {}
+                string_pool(string_pool const&) = delete;
+                string_pool& operator=(string_pool const&) = delete;
+
+                // nullptr for what we don't pool, because of it's length or we're full
+                value_type intern(boost::string_view s){
+                        if( s.size() < min_length_ || s.size() > max_length_ )
+                                return value_type{};
+                        auto iter = map_.find(s);
+                        if( iter != map_.end() )
+                                return iter->second;
+                        if( map_.size() == max_strings_ )
+                                return value_type{};
+                        auto ptr = std::make_shared<std::string const>(s.data(), s.size());
+                        // the key looks into the string we hold, which never changes
+                        map_.emplace(boost::string_view(*ptr), ptr);
+                        return ptr;
+                }
+                std::size_t size()const{ return map_.size(); }
+                // whatever was handed out stays alive
+                void clear(){ map_.clear(); }
+        private:
+                struct hash_{
+                        std::size_t operator()(boost::string_view s)const{
+                                return boost::hash_range(s.begin(), s.end());
+                        }
+                };
+
+                std::size_t min_length_;
+                std::size_t max_length_;
+                std::size_t max_strings_;
+                std::unordered_map<boost::string_view, value_type, hash_> map_;
+        };
+
+} // gjson
+#endif // JSON_PARSER_STRING_POOL_H
@@ -0,0 +1,257 @@
+#ifndef JSON_PARSER_STRING_SCANNER_H
+#define JSON_PARSER_STRING_SCANNER_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <iterator>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace gjson{
+namespace detail{
+
+        /*
+                Finds the first quote or backslash in [first,last), this is
+                what the tokenizer spends most of it's time on inside
+                strings, so do it 16 or 32 bytes at a time. With Control
+                it also stops at anything below 0x20, which strict json
+                doesn't allow in a string
+         */
+        template<bool Control = false>
+        char const* find_quote_or_backslash(char const* first, char const* last, char quote){
+                #if defined(__AVX2__)
+                __m256i q  = _mm256_set1_epi8(quote);
+                __m256i bs = _mm256_set1_epi8('\\');
+                for(; last - first >= 32; first += 32){
+                        __m256i c = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(first));
+                        __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(c, q), _mm256_cmpeq_epi8(c, bs));
+                        if( Control )
+                                m = _mm256_or_si256(m, _mm256_cmpeq_epi8(_mm256_min_epu8(c, _mm256_set1_epi8(0x1F)), c));
+                        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(m));
+                        if( mask )
+                                return first + __builtin_ctz(mask);
+                }
+                #elif defined(__SSE2__)
+                __m128i q  = _mm_set1_epi8(quote);
+                __m128i bs = _mm_set1_epi8('\\');
+                for(; last - first >= 16; first += 16){
+                        __m128i c = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first));
+                        __m128i m = _mm_or_si128(_mm_cmpeq_epi8(c, q), _mm_cmpeq_epi8(c, bs));
+                        if( Control )
+                                m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_min_epu8(c, _mm_set1_epi8(0x1F)), c));
+                        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(m));
+                        if( mask )
+                                return first + __builtin_ctz(mask);
+                }
+                #endif
+                for(; first != last; ++first){
+                        if( *first == quote || *first == '\\' )
+                                break;
+                        if( Control && static_cast<unsigned char>(*first) < 0x20 )
+                                break;
+                }
+                return first;
+        }
+        template<bool Control = false, class Iter>
+        Iter find_quote_or_backslash(Iter first, Iter last, char quote){
+                for(; first != last; ++first){
+                        if( *first == quote || *first == '\\' )
+                                break;
+                        if( Control && static_cast<unsigned char>(*first) < 0x20 )
+                                break;
+                }
+                return first;
+        }
+
+        inline int hex_digit_(char c){
+                if( '0' <= c && c <= '9' ) return c - '0';
+                if( 'a' <= c && c <= 'f' ) return c - 'a' + 10;
+                if( 'A' <= c && c <= 'F' ) return c - 'A' + 10;
+                return -1;
+        }
+        // reads XXXX, returns -1 if not 4 hex digits
+        template<class Iter>
+        long read_hex4_(Iter& iter, Iter last){
+                long cp = 0;
+                for(unsigned i=0;i!=4;++i,++iter){
+                        if( iter == last )
+                                return -1;
+                        int d = hex_digit_(*iter);
+                        if( d < 0 )
+                                return -1;
+                        cp = cp * 16 + d;
+                }
+                return cp;
+        }
+
+        enum class escape_status{
+                ok,
+                unterminated,
+                invalid_escape,
+                invalid_unicode_escape,
+        };
+
+        /*
+                iter is just after a backslash. Checks the escape
+                sequence and moves iter past it, a high surrogate must
+                be followed by a \uXXXX low surrogate
+         */
+        template<class Iter>
+        escape_status skip_escape(Iter& iter, Iter last, char quote){
+                if( iter == last )
+                        return escape_status::unterminated;
+                char c = *iter;
+                ++iter;
+                switch(c){
+                case '"': case '\\': case '/':
+                case 'b': case 'f': case 'n': case 'r': case 't':
+                        return escape_status::ok;
+                case 'u':{
+                        long cp = read_hex4_(iter, last);
+                        if( cp < 0 )
+                                return escape_status::invalid_unicode_escape;
+                        if( 0xDC00 <= cp && cp <= 0xDFFF )
+                                return escape_status::invalid_unicode_escape;
+                        if( 0xD800 <= cp && cp <= 0xDBFF ){
+                                if( iter == last || *iter != '\\' )
+                                        return escape_status::invalid_unicode_escape;
+                                ++iter;
+                                if( iter == last || *iter != 'u' )
+                                        return escape_status::invalid_unicode_escape;
+                                ++iter;
+                                long lo = read_hex4_(iter, last);
+                                if( ! ( 0xDC00 <= lo && lo <= 0xDFFF ) )
+                                        return escape_status::invalid_unicode_escape;
+                        }
+                        return escape_status::ok;
+                }
+                default:
+                        if( c == quote )
+                                return escape_status::ok;
+                        return escape_status::invalid_escape;
+                }
+        }
+
+        inline void append_utf8_(std::string& out, unsigned long cp){
+                if( cp < 0x80 ){
+                        out += static_cast<char>(cp);
+                } else if( cp < 0x800 ){
+                        out += static_cast<char>( 0xC0 | ( cp >> 6 ) );
+                        out += static_cast<char>( 0x80 | ( cp & 0x3F ) );
+                } else if( cp < 0x10000 ){
+                        out += static_cast<char>( 0xE0 | ( cp >> 12 ) );
+                        out += static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+                        out += static_cast<char>( 0x80 | ( cp & 0x3F ) );
+                } else {
+                        out += static_cast<char>( 0xF0 | ( cp >> 18 ) );
+                        out += static_cast<char>( 0x80 | ( ( cp >> 12 ) & 0x3F ) );
+                        out += static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+                        out += static_cast<char>( 0x80 | ( cp & 0x3F ) );
+                }
+        }
+
+        /*
+                Appends the decoded escape sequence starting just after a
+                backslash. The tokenizer has already checked the sequence
+                with skip_escape()
+         */
+        template<class Iter>
+        void decode_escape_(Iter& iter, Iter last, std::string& out){
+                char c = *iter;
+                ++iter;
+                switch(c){
+                case 'b': out += '\b'; return;
+                case 'f': out += '\f'; return;
+                case 'n': out += '\n'; return;
+                case 'r': out += '\r'; return;
+                case 't': out += '\t'; return;
+                case 'u':{
+                        unsigned long cp = static_cast<unsigned long>(read_hex4_(iter, last));
+                        if( 0xD800 <= cp && cp <= 0xDBFF ){
+                                std::advance(iter, 2);
+                                unsigned long lo = static_cast<unsigned long>(read_hex4_(iter, last));
+                                cp = 0x10000 + ( ( cp - 0xD800 ) << 10 ) + ( lo - 0xDC00 );
+                        }
+                        append_utf8_(out, cp);
+                        return;
+                }
+                default:
+                        // " \ / and the quote character are themselves
+                        out += c;
+                        return;
+                }
+        }
+
+        /*
+                Decodes the body of a string which has escapes in it. Runs
+                without a backslash are appended in one go
+         */
+        inline void unescape_string(char const* first, char const* last, std::string& out){
+                for(;;){
+                        auto bs = static_cast<char const*>(std::memchr(first, '\\', static_cast<std::size_t>(last - first)));
+                        if( ! bs ){
+                                out.append(first, last);
+                                return;
+                        }
+                        out.append(first, bs);
+                        first = bs + 1;
+                        decode_escape_(first, last, out);
+                }
+        }
+        template<class Iter>
+        void unescape_string(Iter first, Iter last, std::string& out){
+                for(; first != last;){
+                        if( *first != '\\' ){
+                                out += *first;
+                                ++first;
+                                continue;
+                        }
+                        ++first;
+                        decode_escape_(first, last, out);
+                }
+        }
+
+} // detail
+
+/*
+        The inverse of the tokenizer, so that what we print can be read
+        back in. Anything that isn't ASCII is passed through as is
+ */
+inline void escape_string(std::string const& s, std::string& out){
+        static char const hex[] = "0123456789abcdef";
+        out.reserve(out.size() + s.size() + 2);
+        auto run = s.begin();
+        for(auto iter = s.begin(); iter != s.end(); ++iter){
+                auto c = static_cast<unsigned char>(*iter);
+                if( c >= 0x20 && c != '"' && c != '\\' )
+                        continue;
+                out.append(run, iter);
+                run = std::next(iter);
+                switch(c){
+                case '"':  out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\b': out += "\\b";  break;
+                case '\f': out += "\\f";  break;
+                case '\n': out += "\\n";  break;
+                case '\r': out += "\\r";  break;
+                case '\t': out += "\\t";  break;
+                default:
+                        out += "\\u00";
+                        out += hex[c >> 4];
+                        out += hex[c & 0xF];
+                        break;
+                }
+        }
+        out.append(run, s.end());
+}
+inline std::string escape_string(std::string const& s){
+        std::string out;
+        escape_string(s, out);
+        return out;
+}
+
+} // gjson
+#endif // JSON_PARSER_STRING_SCANNER_H
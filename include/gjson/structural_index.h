@@ -0,0 +1,254 @@
+#ifndef JSON_PARSER_STRUCTURAL_INDEX_H
+#define JSON_PARSER_STRUCTURAL_INDEX_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <iterator>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace gjson{
+
+namespace detail{
+
+        /*
+                Only contiguous memory can be indexed, everything
+                else goes through the char-at-a-time path
+         */
+        template<class Iter>
+        struct is_contiguous_iterator : std::false_type{};
+        template<>
+        struct is_contiguous_iterator<char*> : std::true_type{};
+        template<>
+        struct is_contiguous_iterator<char const*> : std::true_type{};
+        template<>
+        struct is_contiguous_iterator<std::string::iterator> : std::true_type{};
+        template<>
+        struct is_contiguous_iterator<std::string::const_iterator> : std::true_type{};
+        template<>
+        struct is_contiguous_iterator<std::vector<char>::iterator> : std::true_type{};
+        template<>
+        struct is_contiguous_iterator<std::vector<char>::const_iterator> : std::true_type{};
+
+        // one bit per byte of a 64 byte block
+        struct block_masks{
+                std::uint64_t quote;
+                std::uint64_t single_quote;
+                std::uint64_t backslash;
+                std::uint64_t structural;
+                std::uint64_t whitespace;
+        };
+
+        #if defined(__AVX2__)
+        inline void classify_32_(char const* ptr, std::uint32_t* out){
+                __m256i c = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(ptr));
+                auto eq = [&](char x){ return _mm256_cmpeq_epi8(c, _mm256_set1_epi8(x)); };
+                auto mask = [](__m256i m){ return static_cast<std::uint32_t>(_mm256_movemask_epi8(m)); };
+
+                __m256i structural = _mm256_or_si256(
+                        _mm256_or_si256( _mm256_or_si256(eq('{'), eq('}')), _mm256_or_si256(eq('['), eq(']')) ),
+                        _mm256_or_si256(eq(':'), eq(',')));
+                // \t \n \v \f \r are 9..13
+                __m256i ctrl = _mm256_sub_epi8(c, _mm256_set1_epi8(9));
+                __m256i ws   = _mm256_or_si256( eq(' '),
+                        _mm256_cmpeq_epi8( _mm256_min_epu8(ctrl, _mm256_set1_epi8(4)), ctrl));
+
+                out[0] = mask(eq('"'));
+                out[1] = mask(eq('\''));
+                out[2] = mask(eq('\\'));
+                out[3] = mask(structural);
+                out[4] = mask(ws);
+        }
+        #elif defined(__SSE2__)
+        inline void classify_16_(char const* ptr, std::uint32_t* out){
+                __m128i c = _mm_loadu_si128(reinterpret_cast<__m128i const*>(ptr));
+                auto eq = [&](char x){ return _mm_cmpeq_epi8(c, _mm_set1_epi8(x)); };
+                auto mask = [](__m128i m){ return static_cast<std::uint32_t>(_mm_movemask_epi8(m)); };
+
+                __m128i structural = _mm_or_si128(
+                        _mm_or_si128( _mm_or_si128(eq('{'), eq('}')), _mm_or_si128(eq('['), eq(']')) ),
+                        _mm_or_si128(eq(':'), eq(',')));
+                // \t \n \v \f \r are 9..13
+                __m128i ctrl = _mm_sub_epi8(c, _mm_set1_epi8(9));
+                __m128i ws   = _mm_or_si128( eq(' '),
+                        _mm_cmpeq_epi8( _mm_min_epu8(ctrl, _mm_set1_epi8(4)), ctrl));
+
+                out[0] = mask(eq('"'));
+                out[1] = mask(eq('\''));
+                out[2] = mask(eq('\\'));
+                out[3] = mask(structural);
+                out[4] = mask(ws);
+        }
+        #endif
+
+        inline block_masks classify_block_(char const* ptr){
+                block_masks m;
+                #if defined(__AVX2__)
+                std::uint32_t lo[5], hi[5];
+                classify_32_(ptr     , lo);
+                classify_32_(ptr + 32, hi);
+                std::uint64_t* fields[] = { &m.quote, &m.single_quote, &m.backslash, &m.structural, &m.whitespace };
+                for(unsigned i=0;i!=5;++i)
+                        *fields[i] = lo[i] | ( static_cast<std::uint64_t>(hi[i]) << 32 );
+                #elif defined(__SSE2__)
+                std::uint32_t q[4][5];
+                for(unsigned i=0;i!=4;++i)
+                        classify_16_(ptr + i * 16, q[i]);
+                std::uint64_t* fields[] = { &m.quote, &m.single_quote, &m.backslash, &m.structural, &m.whitespace };
+                for(unsigned i=0;i!=5;++i){
+                        *fields[i] =   static_cast<std::uint64_t>(q[0][i])
+                                   | ( static_cast<std::uint64_t>(q[1][i]) << 16 )
+                                   | ( static_cast<std::uint64_t>(q[2][i]) << 32 )
+                                   | ( static_cast<std::uint64_t>(q[3][i]) << 48 );
+                }
+                #else
+                m = block_masks{0,0,0,0,0};
+                for(unsigned i=0;i!=64;++i){
+                        std::uint64_t bit = static_cast<std::uint64_t>(1) << i;
+                        switch(ptr[i]){
+                        case '"':  m.quote        |= bit; break;
+                        case '\'': m.single_quote |= bit; break;
+                        case '\\': m.backslash    |= bit; break;
+                        case '{': case '}': case '[': case ']': case ':': case ',':
+                                   m.structural   |= bit; break;
+                        case ' ': case '\t': case '\n': case '\v': case '\f': case '\r':
+                                   m.whitespace   |= bit; break;
+                        }
+                }
+                #endif
+                return m;
+        }
+
+        // bit i is the xor of bits 0..i
+        inline std::uint64_t prefix_xor_(std::uint64_t x){
+                x ^= x << 1;
+                x ^= x << 2;
+                x ^= x << 4;
+                x ^= x << 8;
+                x ^= x << 16;
+                x ^= x << 32;
+                return x;
+        }
+
+        /*
+                Returns the bits which are escaped by an odd length run of
+                backslashes, prev_escaped carries the state between blocks
+         */
+        inline std::uint64_t find_escaped_(std::uint64_t backslash, std::uint64_t& prev_escaped){
+                backslash &= ~prev_escaped;
+                std::uint64_t follows_escape = ( backslash << 1 ) | prev_escaped;
+                const std::uint64_t even_bits = 0x5555555555555555ULL;
+                std::uint64_t odd_sequence_starts = backslash & ~even_bits & ~follows_escape;
+                std::uint64_t sequences_starting_on_even_bits = odd_sequence_starts + backslash;
+                prev_escaped = sequences_starting_on_even_bits < odd_sequence_starts ? 1 : 0;
+                std::uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+                return ( even_bits ^ invert_mask ) & follows_escape;
+        }
+
+} // detail
+
+/*
+        First stage of parsing, for contiguous input we scan 64 bytes
+        at a time and record the offset of every place a token can
+        start, ie
+                { "a" : [ 1 , true ] }
+                ^ ^   ^ ^ ^ ^ ^    ^ ^
+        which is the structural characters, the opening quote of a
+        string, and the first character of every other run of
+        non-whitespace outside of a string. The tokenizer doesn't
+        tokenize from it, with parse_options::use_structural_index it's
+        what skips jump over and what the size_hints counts go over,
+        rather than the text.
+
+        The index only understands double quoted strings, so if there is
+        a single quote outside of a string it's marked as not usable and
+        the tokenizer has to do it the slow way
+ */
+struct structural_index{
+        using position_type = std::uint32_t;
+
+        structural_index() = default;
+        structural_index(char const* first, char const* last){
+                build(first, last);
+        }
+
+        void build(char const* first, char const* last){
+                positions_.clear();
+                usable_ = false;
+
+                std::size_t n = static_cast<std::size_t>(last - first);
+                if( n > static_cast<std::size_t>(static_cast<position_type>(-1)) )
+                        return;
+                // very roughly one token per 4 bytes
+                positions_.reserve( n / 4 + 1 );
+
+                std::uint64_t prev_in_string = 0;
+                std::uint64_t prev_escaped   = 0;
+                // a token can start at the very first byte
+                std::uint64_t prev_delimiter = 1;
+                std::uint64_t stray_single_quotes = 0;
+
+                char tail[64];
+                for(std::size_t offset = 0; offset < n; offset += 64){
+                        char const* block = first + offset;
+                        if( n - offset < 64 ){
+                                std::memset(tail, ' ', sizeof(tail));
+                                std::memcpy(tail, block, n - offset);
+                                block = tail;
+                        }
+                        auto m = detail::classify_block_(block);
+
+                        std::uint64_t escaped = detail::find_escaped_(m.backslash, prev_escaped);
+                        std::uint64_t quote = m.quote & ~escaped;
+
+                        std::uint64_t in_string = detail::prefix_xor_(quote) ^ prev_in_string;
+                        prev_in_string = static_cast<std::uint64_t>( static_cast<std::int64_t>(in_string) >> 63 );
+
+                        std::uint64_t open_quote  = quote & in_string;
+                        std::uint64_t close_quote = quote & ~in_string;
+
+                        std::uint64_t structural = m.structural & ~in_string;
+                        // something that ends a token, so the next byte
+                        // can start a scalar
+                        std::uint64_t delimiter = structural | ( m.whitespace & ~in_string ) | close_quote;
+                        std::uint64_t follows_delimiter = ( delimiter << 1 ) | prev_delimiter;
+                        prev_delimiter = delimiter >> 63;
+
+                        std::uint64_t scalar_start = follows_delimiter & ~in_string & ~quote & ~m.whitespace & ~m.structural;
+
+                        stray_single_quotes |= m.single_quote & ~in_string;
+
+                        flatten_( structural | open_quote | scalar_start, offset );
+                }
+                usable_ = ( stray_single_quotes == 0 );
+                if( ! usable_ )
+                        positions_.clear();
+        }
+
+        // empty, keeping the memory
+        void clear(){
+                positions_.clear();
+                usable_ = false;
+        }
+        bool usable()const{ return usable_; }
+        std::size_t size()const{ return positions_.size(); }
+        position_type operator[](std::size_t idx)const{ return positions_[idx]; }
+        std::vector<position_type> const& positions()const{ return positions_; }
+
+private:
+        void flatten_(std::uint64_t bits, std::size_t offset){
+                for(; bits; bits &= bits - 1 ){
+                        positions_.push_back( static_cast<position_type>( offset + __builtin_ctzll(bits) ) );
+                }
+        }
+
+        std::vector<position_type> positions_;
+        bool usable_{false};
+};
+
+} // gjson
+#endif // JSON_PARSER_STRUCTURAL_INDEX_H
@@ -0,0 +1,329 @@
+#ifndef JSON_PARSER_TAPE_H
+#define JSON_PARSER_TAPE_H
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/utility/string_view.hpp>
+
+#include "basic_parser.h"
+#include "error.h"
+
+namespace gjson{
+
+        /*
+                The whole document as a flat array of 64 bit words, so it can
+                be walked as many times as we like without tokenizing it
+                again. Each entry is the type in the top 8 bits and a payload
+                in the rest
+
+                        begin_map,begin_array   index of the matching end (32) | number of children (24)
+                        end_map,end_array       index of the matching begin
+                        string_                 1 | length (23) | offset into the text (32)
+                                                for a string without escapes, otherwise
+                                                0 | offset into strings_, which has the
+                                                length (32) then the decoded bytes
+                        int_,float_             nothing, the value is the next word
+                        true_,false_,null_      nothing
+
+                So only strings with escapes are copied, and the text has to
+                outlive the tape. The matching index is 32 bits, so a tape
+                can't have more than max_entries words, and push() throws
+                std::length_error past that
+
+                ie [1,{"a":true}] is
+                        0  begin_array  7|2
+                        1  int_
+                        2  1
+                        3  begin_map    6|1
+                        4  string_      0       -> "a"
+                        5  true_
+                        6  end_map      3
+                        7  end_array    0
+         */
+        struct tape{
+                enum entry_type : unsigned char{
+                        begin_map,
+                        end_map,
+                        begin_array,
+                        end_array,
+                        string_,
+                        int_,
+                        float_,
+                        true_,
+                        false_,
+                        null_,
+                };
+                // counts bigger than this are stored as this
+                enum : std::uint32_t{ max_count = 0xFFFFFF };
+                static constexpr std::uint64_t max_entries = static_cast<std::uint64_t>(1) << 32;
+
+                std::size_t size()const{ return words_.size(); }
+                bool empty()const{ return words_.empty(); }
+                void clear(){
+                        words_.clear();
+                        strings_.clear();
+                        text_first_ = text_last_ = nullptr;
+                }
+                /*
+                        The text strings can be left in, parse_tape sets it for
+                        an empty tape. Appending from other text is fine, those
+                        strings are copied
+                 */
+                void set_text(char const* first, char const* last){
+                        text_first_ = first;
+                        text_last_  = last;
+                }
+
+                entry_type type(std::size_t idx)const{
+                        return static_cast<entry_type>(words_[idx] >> 56);
+                }
+                // for begin_* this is the end, and the other way round
+                std::size_t matching(std::size_t idx)const{
+                        return static_cast<std::size_t>( ( words_[idx] >> 24 ) & 0xFFFFFFFF );
+                }
+                // number of values in an array, or pairs in a map
+                std::size_t count(std::size_t idx)const{
+                        return static_cast<std::size_t>( words_[idx] & max_count );
+                }
+                std::int64_t int_value(std::size_t idx)const{
+                        return static_cast<std::int64_t>(words_[idx + 1]);
+                }
+                double float_value(std::size_t idx)const{
+                        double value;
+                        std::memcpy(&value, &words_[idx + 1], sizeof(value));
+                        return value;
+                }
+                boost::string_view string_value(std::size_t idx)const{
+                        std::uint64_t payload = words_[idx] & payload_mask;
+                        if( payload & in_text ){
+                                return boost::string_view(text_first_ + ( payload & 0xFFFFFFFF ),
+                                                          static_cast<std::size_t>( ( payload >> 32 ) & max_text_length ));
+                        }
+                        std::size_t offset = static_cast<std::size_t>(payload);
+                        std::uint32_t length;
+                        std::memcpy(&length, strings_.data() + offset, sizeof(length));
+                        return boost::string_view(strings_.data() + offset + sizeof(length), length);
+                }
+                // the entry after the value at idx, skipping over children
+                std::size_t next(std::size_t idx)const{
+                        switch(type(idx)){
+                        case begin_map:
+                        case begin_array:
+                                return matching(idx) + 1;
+                        case int_:
+                        case float_:
+                                return idx + 2;
+                        default:
+                                return idx + 1;
+                        }
+                }
+
+                // building
+                std::size_t push(entry_type t, std::uint64_t payload = 0){
+                        if( words_.size() >= max_entries )
+                                throw std::length_error("tape: more than 2^32 entries");
+                        words_.push_back( ( static_cast<std::uint64_t>(t) << 56 ) | payload );
+                        return words_.size() - 1;
+                }
+                void push_int(std::int64_t value){
+                        push(int_);
+                        words_.push_back(static_cast<std::uint64_t>(value));
+                }
+                void push_float(double value){
+                        push(float_);
+                        std::uint64_t bits;
+                        std::memcpy(&bits, &value, sizeof(bits));
+                        words_.push_back(bits);
+                }
+                void push_string(boost::string_view value){
+                        std::less<char const*> before;
+                        if( text_first_ && value.size() <= max_text_length &&
+                            ! before(value.data(), text_first_) && ! before(text_last_, value.data() + value.size()) ){
+                                auto offset = static_cast<std::uint64_t>( value.data() - text_first_ );
+                                if( offset <= 0xFFFFFFFF ){
+                                        push(string_, in_text | ( static_cast<std::uint64_t>(value.size()) << 32 ) | offset);
+                                        return;
+                                }
+                        }
+                        std::uint32_t length = static_cast<std::uint32_t>(value.size());
+                        auto offset = strings_.size();
+                        strings_.append(reinterpret_cast<char const*>(&length), sizeof(length));
+                        strings_.append(value.data(), value.size());
+                        push(string_, offset);
+                }
+                // end is the index we just pushed the matching close at
+                void close(std::size_t begin, std::size_t end, std::size_t children){
+                        if( children > max_count )
+                                children = max_count;
+                        words_[begin] = ( words_[begin] & ~payload_mask ) |
+                                        ( static_cast<std::uint64_t>(end) << 24 ) | children;
+                        words_[end]   = ( words_[end] & ~payload_mask ) |
+                                        ( static_cast<std::uint64_t>(begin) << 24 );
+                }
+        private:
+                static constexpr std::uint64_t payload_mask = ( static_cast<std::uint64_t>(1) << 56 ) - 1;
+                static constexpr std::uint64_t in_text = static_cast<std::uint64_t>(1) << 55;
+                static constexpr std::uint64_t max_text_length = ( static_cast<std::uint64_t>(1) << 23 ) - 1;
+
+                std::vector<std::uint64_t> words_;
+                std::string strings_;
+                char const* text_first_{nullptr};
+                char const* text_last_{nullptr};
+        };
+
+        /*
+                A Maker which writes to a tape, so anything that can drive a
+                Maker can build one
+         */
+        struct tape_maker{
+                explicit tape_maker(tape& t)
+                        : tape_(t)
+                {}
+
+                void begin_map(){ begin_(tape::begin_map); }
+                void end_map(){ end_(tape::end_map, 2); }
+                void begin_array(){ begin_(tape::begin_array); }
+                void end_array(){ end_(tape::end_array, 1); }
+                // a view into the text, unless it had escapes, see tape
+                void make_string(boost::string_view value){
+                        value_();
+                        tape_.push_string(value);
+                }
+                void make_int(std::int64_t value){
+                        value_();
+                        tape_.push_int(value);
+                }
+                void make_float(double value){
+                        value_();
+                        tape_.push_float(value);
+                }
+                void make_null(){
+                        value_();
+                        tape_.push(tape::null_);
+                }
+                void make_true(){
+                        value_();
+                        tape_.push(tape::true_);
+                }
+                void make_false(){
+                        value_();
+                        tape_.push(tape::false_);
+                }
+        private:
+                struct frame{
+                        std::size_t begin;
+                        // keys and values both count, so a map has twice
+                        std::size_t items;
+                };
+                void value_(){
+                        if( ! stack_.empty() )
+                                ++stack_.back().items;
+                }
+                void begin_(tape::entry_type t){
+                        value_();
+                        stack_.push_back(frame{tape_.push(t), 0});
+                }
+                void end_(tape::entry_type t, std::size_t per_child){
+                        auto end = tape_.push(t);
+                        tape_.close(stack_.back().begin, end, stack_.back().items / per_child);
+                        stack_.pop_back();
+                }
+
+                tape& tape_;
+                std::vector<frame> stack_;
+        };
+
+namespace detail{
+
+        // the tape already has the counts, so there's no need for size_hints
+        template<class Maker>
+        void begin_map_(Maker& maker, std::size_t n, std::true_type){ maker.begin_map(n); }
+        template<class Maker>
+        void begin_map_(Maker& maker, std::size_t, std::false_type){ maker.begin_map(); }
+        template<class Maker>
+        void begin_array_(Maker& maker, std::size_t n, std::true_type){ maker.begin_array(n); }
+        template<class Maker>
+        void begin_array_(Maker& maker, std::size_t, std::false_type){ maker.begin_array(); }
+        // only a Maker without make_string(boost::string_view) gets a copy
+        template<class Maker>
+        void replay_string_(Maker& maker, boost::string_view s, std::true_type){ maker.make_string(s); }
+        template<class Maker>
+        void replay_string_(Maker& maker, boost::string_view s, std::false_type){ maker.make_string(s.to_string()); }
+
+} // detail
+
+        /*
+                Replays the tape into a Maker, it sees exactly the events it
+                would have from the parser, with the counts for a Maker
+                that takes them (see basic_parser.h)
+         */
+        template<class Maker>
+        void walk_tape(tape const& t, Maker& maker, std::size_t first = 0, std::size_t last = static_cast<std::size_t>(-1)){
+                if( last > t.size() )
+                        last = t.size();
+                for(std::size_t idx = first; idx < last;){
+                        switch(t.type(idx)){
+                        case tape::begin_map:   detail::begin_map_(maker, t.count(idx), detail::takes_map_count<Maker>{});     break;
+                        case tape::end_map:     maker.end_map();     break;
+                        case tape::begin_array: detail::begin_array_(maker, t.count(idx), detail::takes_array_count<Maker>{}); break;
+                        case tape::end_array:   maker.end_array();   break;
+                        case tape::string_:
+                                detail::replay_string_(maker, t.string_value(idx), detail::takes_string_view<Maker>{});
+                                break;
+                        case tape::int_:
+                                maker.make_int( t.int_value(idx) );
+                                ++idx;
+                                break;
+                        case tape::float_:
+                                maker.make_float( t.float_value(idx) );
+                                ++idx;
+                                break;
+                        case tape::true_:  maker.make_true();  break;
+                        case tape::false_: maker.make_false(); break;
+                        case tape::null_:  maker.make_null();  break;
+                        }
+                        ++idx;
+                }
+        }
+
+namespace detail{
+        template<class Iter>
+        void tape_text_(tape& out, Iter first, Iter last, std::true_type){
+                if( out.empty() && first != last )
+                        out.set_text(&*first, &*first + std::distance(first, last));
+        }
+        // the tokenizer copies every string, so there's nothing to point at
+        template<class Iter>
+        void tape_text_(tape&, Iter, Iter, std::false_type){}
+} // detail
+
+        /*
+                tokenizes [first,last) onto the end of out, which is left half
+                written on failure. The tape looks into [first,last), so it
+                has to stay put while the tape is used
+         */
+        template<class Iter, class Dialect = relaxed_dialect>
+        bool parse_tape(Iter first, Iter last, tape& out, parse_error& err,
+                        parse_options const& opts = parse_options{})
+        {
+                detail::tape_text_(out, first, last, detail::is_contiguous_iterator<Iter>{});
+                tape_maker m(out);
+                basic_parser<tape_maker, Iter, Dialect> p(m, first, last, opts);
+                return p.parse(err);
+        }
+        inline
+        bool parse_tape(std::string const& s, tape& out, parse_error& err,
+                        parse_options const& opts = parse_options{})
+        {
+                return parse_tape(s.data(), s.data() + s.size(), out, err, opts);
+        }
+        // the tape would be left looking into a string which is gone
+        bool parse_tape(std::string&&, tape&, parse_error&, parse_options const& = parse_options{}) = delete;
+
+} // gjson
+#endif // JSON_PARSER_TAPE_H
@@ -0,0 +1,82 @@
+#ifndef JSON_PARSER_THREAD_POOL_H
+#define JSON_PARSER_THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gjson{
+
+        /*
+                Fixed number of workers taking jobs off one queue, submit
+                gives back a future for the result. The destructor runs
+                whatever is still queued before joining
+         */
+        struct thread_pool{
+                explicit thread_pool(unsigned n = 0){
+                        if( n == 0 )
+                                n = default_size();
+                        for(unsigned i=0;i!=n;++i)
+                                workers_.emplace_back([this](){ run_(); });
+                }
+                ~thread_pool(){
+                        {
+                                std::lock_guard<std::mutex> lock(mtx_);
+                                stop_ = true;
+                        }
+                        cv_.notify_all();
+                        for(auto& t : workers_)
+                                t.join();
+                }
+                thread_pool(thread_pool const&) = delete;
+                thread_pool& operator=(thread_pool const&) = delete;
+
+                // one per core, hardware_concurrency is allowed to say 0
+                static unsigned default_size(){
+                        unsigned n = std::thread::hardware_concurrency();
+                        return n == 0 ? 1 : n;
+                }
+                unsigned size()const{ return static_cast<unsigned>(workers_.size()); }
+
+                template<class F>
+                auto submit(F f) -> std::future<decltype(f())>{
+                        using result_type = decltype(f());
+                        auto task = std::make_shared<std::packaged_task<result_type()> >(std::move(f));
+                        auto ret = task->get_future();
+                        {
+                                std::lock_guard<std::mutex> lock(mtx_);
+                                jobs_.emplace_back([task](){ (*task)(); });
+                        }
+                        cv_.notify_one();
+                        return ret;
+                }
+        private:
+                void run_(){
+                        for(;;){
+                                std::function<void()> job;
+                                {
+                                        std::unique_lock<std::mutex> lock(mtx_);
+                                        cv_.wait(lock, [this](){ return stop_ || ! jobs_.empty(); });
+                                        if( jobs_.empty() )
+                                                return;
+                                        job = std::move(jobs_.front());
+                                        jobs_.pop_front();
+                                }
+                                job();
+                        }
+                }
+
+                std::mutex mtx_;
+                std::condition_variable cv_;
+                std::deque<std::function<void()> > jobs_;
+                bool stop_{false};
+                std::vector<std::thread> workers_;
+        };
+
+} // gjson
+#endif // JSON_PARSER_THREAD_POOL_H
@@ -3,11 +3,23 @@
 
 #include <sstream>
 #include <iostream>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
 
+#include <boost/config.hpp>
 #include <boost/preprocessor.hpp>
 #include <boost/format.hpp>
-#include <boost/optional.hpp>
-#include <boost/optional/optional_io.hpp>
+#include <boost/utility/string_view.hpp>
+
+#include "char_class.h"
+#include "structural_index.h"
+#include "string_scanner.h"
+#include "number_parser.h"
+#include "error.h"
+#include "utf8.h"
+#include "dialect.h"
 
 namespace gjson{
 
@@ -54,37 +66,136 @@ namespace gjson{
                 } while ( 0 )
 
 
+        /*
+                A token is just a view into the input, the text is only
+                copied out when someone asks the tokenizer for value().
+                For strings the view is the characters between the quotes.
+                A default constructed token is a dummy, which is what
+                peak() returns when there's nothing left
+         */
         struct token{
-                token(token_type _type, std::string const& _value)
-                        :type_(_type),value_(_value)
+                token() = default;
+                token(token_type _type, std::size_t _offset, std::size_t _length, bool _escaped = false)
+                        :type_(_type),escaped_(_escaped),offset_(_offset),length_(_length)
                 {}
                 token_type type()const{return type_;}
-                std::string const& value()const{return value_;}
+                std::size_t offset()const{return offset_;}
+                std::size_t length()const{return length_;}
+                // true if a string has escape sequences that value() has to decode
+                bool escaped()const{return escaped_;}
+                // true for "abc" and 'abc', false for a bare abc
+                bool quoted()const{return quoted_;}
+
+                // numbers are converted by the tokenizer as it scans them
+                std::int64_t int_value()const{return int_value_;}
+                double float_value()const{return float_value_;}
+                // false for things like 1e2.3 which we tokenize but aren't numbers
+                bool convertible()const{return convertible_;}
+                token& set_int_value(std::int64_t value){
+                        int_value_ = value;
+                        return *this;
+                }
+                token& set_float_value(double value){
+                        float_value_ = value;
+                        return *this;
+                }
+                token& set_convertible(bool value){
+                        convertible_ = value;
+                        return *this;
+                }
+                token& set_quoted(bool value){
+                        quoted_ = value;
+                        return *this;
+                }
 
                 friend std::ostream& operator<<(std::ostream& ostr, token const& tok){
-                        return ostr << "(" << tok.type() << ",\"" << tok.value() << "\")";
+                        return ostr << "(" << tok.type() << "," << tok.offset() << "," << tok.length() << ")";
                 }
         private:
-                token_type type_;
-                std::string value_;
+                token_type type_{token_type::dummy};
+                bool escaped_{false};
+                bool convertible_{true};
+                bool quoted_{false};
+                std::size_t offset_{0};
+                std::size_t length_{0};
+                union{
+                        std::int64_t int_value_{0};
+                        double float_value_;
+                };
+        };
+        static_assert( std::is_trivially_copyable<token>::value, "token should be a view");
+
+        struct parse_options{
+                /*
+                        Check that strings are valid UTF-8 as we scan them,
+                        anything bad is reported as invalid_utf8 at the
+                        first byte of the bad sequence. Off by default, as
+                        strings are otherwise passed through as is
+                 */
+                bool validate_utf8{false};
+                /*
+                        Maps and arrays nested deeper than this are
+                        reported as too_deep at the opening bracket, 0 is
+                        no limit
+                 */
+                std::size_t max_depth{0};
+                /*
+                        Count what's in every map and array before parsing,
+                        so a Maker with begin_map(n)/begin_array(n) can
+                        reserve, see basic_parser. It's one more pass over
+                        the text, so off by default
+                 */
+                bool size_hints{false};
+                /*
+                        Have skips and size_hints go over the structural
+                        index, see structural_index.h, rather than the text.
+                        Building it is another pass over all of the text,
+                        which bench/parser.cpp has slower than what it
+                        saves, so off by default
+                 */
+                bool use_structural_index{false};
+        };
+
+        // from count_containers, the bracket at offset has count values, or pairs for a map
+        struct container_count{
+                std::size_t offset;
+                std::size_t count;
+        };
+
+        /*
+                What a parse needs besides what the Maker makes, the index,
+                the size_hints counts and somewhere to decode strings. Each
+                parser has it's own, but one handed from parser to parser
+                keeps it's memory, so once it's big enough a parse doesn't
+                allocate, see arena_document
+         */
+        struct parse_buffers{
+                structural_index index;
+                std::vector<container_count> counts;
+                std::vector<std::size_t> count_stack;
+                std::string scratch;
         };
 
-        template<class Iter>
+        template<class Iter, class Dialect = relaxed_dialect>
         struct basic_tokenizer{
+                using dialect_type = Dialect;
 
                 struct state_t{
                         Iter first_, last_;
-                        boost::optional<token> peak_;
+                        token peak_;
+                        // where the last skip got to in index_
+                        std::size_t cursor_{0};
                 };
 
+                // not worth indexing anything smaller than this
+                enum{ structural_index_threshold = 128 };
+
 
                 struct iterator{
                         explicit iterator(basic_tokenizer* self = 0)
                                 :self_{self}{
                                 if( !! self ){
-                                        if( ! self_->eos()){
-                                                tok_ = self_->peak();
-                                        }
+                                        tok_ = self_->peak();
                                 }
                         }
 
@@ -115,41 +226,76 @@ namespace gjson{
                                 return *this;
                         }
                         token const& operator*()const{
-                                return *tok_;
+                                return tok_;
                         }
                         token const* operator->()const{
-                                return &*tok_;
+                                return &tok_;
                         }
                 private:
                         basic_tokenizer* self_{0};
-                        boost::optional<token> tok_;
+                        token tok_;
                 };
 
 
 
-                explicit basic_tokenizer(std::string const& str)
-                        : mem_{str}, start_{mem_.begin()}, end_{mem_.end()}
+                explicit basic_tokenizer(std::string const& str, parse_options const& opts = parse_options{})
+                        : mem_{str}, start_{mem_.begin()}, end_{mem_.end()}, options_{opts}
+                {
+                        state_.first_ = start_;
+                        state_.last_ = end_;
+
+                        next();
+                }
+                basic_tokenizer(Iter first, Iter last, parse_options const& opts = parse_options{})
+                        : start_{first}, end_{last}, options_{opts}
                 {
                         state_.first_ = start_;
                         state_.last_ = end_;
 
                         next();
                 }
-                basic_tokenizer(Iter first, Iter last)
-                        : start_{first}, end_{last}
+                // the index, if it's wanted, is built in index's memory, see parse_buffers
+                basic_tokenizer(Iter first, Iter last, parse_options const& opts, structural_index&& index)
+                        : start_{first}, end_{last}, index_{std::move(index)}, options_{opts}
                 {
                         state_.first_ = start_;
                         state_.last_ = end_;
 
+                        index_.clear();
                         next();
                 }
-                bool eos()const{return state_.first_ == state_.last_ && !state_.peak_;}
-                boost::optional<token> peak(){return state_.peak_;}
-                boost::optional<token> next(){
+                // gives the memory back, there's no index after
+                structural_index release_index(){
+                        structural_index out = std::move(index_);
+                        index_ = structural_index{};
+                        return out;
+                }
+                bool eos()const{return state_.first_ == state_.last_ && state_.peak_.type() == token_type::dummy;}
+                token const& peak()const{return state_.peak_;}
+                token const& next(){
                         state_.peak_ = next_();
                         //PRINT(std::distance(state_.first_,state_.last_));
                         return state_.peak_;
                 }
+                // this is where we allocate
+                std::string value(token const& tok)const{
+                        auto first = std::next(start_, tok.offset());
+                        auto last  = std::next(first, tok.length());
+                        if( ! tok.escaped() )
+                                return std::string(first, last);
+                        std::string out;
+                        out.reserve(tok.length());
+                        unescape_(first, last, out, detail::is_contiguous_iterator<Iter>{});
+                        return out;
+                }
+                /*
+                        Same, without the allocation. Unless it has escapes the
+                        view is into the input, otherwise it's decoded into
+                        scratch, which is only good until the next call
+                 */
+                boost::string_view value(token const& tok, std::string& scratch)const{
+                        return value_(tok, scratch, detail::is_contiguous_iterator<Iter>{});
+                }
 
                 state_t save_state_please()const{
                         return state_;
@@ -180,97 +326,442 @@ namespace gjson{
                 auto begin(){ return token_begin(); }
                 auto end(){ return token_end(); }
 
+                /*
+                        Errors don't throw, the tokenizer just records what went
+                        wrong and where, and then behaves as if it's at the end of
+                        the input, so whoever is driving it unwinds naturally.
+                        Only the first error is kept
+                 */
+                bool failed()const{ return !! error_; }
+                parse_error const& error()const{ return error_; }
+                // worked out when asked for
+                error_location location()const{
+                        return locate(start_, end_, error_.offset);
+                }
                 std::string get_error()const{
-                        return error_;
+                        if( ! failed() )
+                                return std::string{};
+                        return describe(start_, end_, error_);
                 }
+                // for the parser, the error is at the token we're looking at
+                void fail(error_code code){
+                        if( failed() )
+                                return;
+                        error_.code = code;
+                        if( state_.peak_.type() != token_type::dummy )
+                                error_.offset = state_.peak_.offset();
+                        else
+                                error_.offset = static_cast<std::size_t>(std::distance(start_, state_.first_));
+                        state_.first_ = state_.last_;
+                        state_.peak_ = token{};
+                }
+                /*
+                        Whether skip_container() and count_containers() go
+                        over the index, which builds it if it hasn't been
+                 */
+                bool indexed(){ return use_index_(); }
 
-                boost::optional<token> return_errror_(std::string const& msg){
-
-
-                        enum{ before = 40, after = 40 };
-
-                        Iter ctx_start{start_};
-                        if( before < std::distance(ctx_start, state_.first_) ){
-                                ctx_start = state_.first_ - before;
+                /*
+                        For when nobody wants what's inside the map or array
+                        whose bracket is at open, which we've just read. Jumps to the
+                        matching close, which is then peak(), without
+                        tokenizing or converting anything. Only brackets and
+                        quotes are looked at, so bad json in there isn't
+                        noticed. If there's no matching close we end up at
+                        the end of the input
+                 */
+                void skip_container(std::size_t open){
+                        if( failed() )
+                                return;
+                        if( use_index_() )
+                                skip_container_indexed_(open + 1);
+                        else
+                                skip_container_raw_(open + 1);
+                        next();
+                }
+                // skips the value at peak(), false if there isn't one
+                bool skip_value(){
+                        token open = peak();
+                        switch(open.type()){
+                        case token_type::left_curl:
+                        case token_type::left_br:
+                        {
+                                auto close = open.type() == token_type::left_curl ? token_type::right_curl
+                                                                                  : token_type::right_br;
+                                skip_container(open.offset());
+                                if( peak().type() == close ){
+                                        next();
+                                        return true;
+                                }
+                                // the same error parsing it would have given
+                                fail(close == token_type::right_curl ? error_code::expected_right_curl
+                                                                     : error_code::expected_right_br);
+                                return false;
                         }
-
-                        Iter ctx_end = state_.first_ + after;
-                        if( end_ < ctx_end )
-                                ctx_end = end_;
-
-
-                        // now make a cursor
-                        //
-                        //  [a,2, @)
-                        //        ^
-                        
-                        auto d = std::distance(ctx_start, state_.first_);
-
-
-                        std::stringstream sstr;
-                        sstr << "error: " << msg << "\n";
-                        sstr << std::string(ctx_start, ctx_end) << "\n";
-                        if( d != 0){
-                                sstr << std::string(d, ' ');
+                        case token_type::string_:
+                        case token_type::int_:
+                        case token_type::float_:
+                        case token_type::true_:
+                        case token_type::false_:
+                        case token_type::null_:
+                                next();
+                                return true;
+                        default:
+                                return false;
                         }
-                        sstr << "^"; // no newline
-
-                        error_ = sstr.str();
-
-                        std::cerr << get_error() << "\n";
+                }
 
-                        throw std::domain_error(get_error());
-                        // XXX want to use this
+                /*
+                        Counts every map and array in the input, in the order
+                        they start, ie [1,{"a":[]}] is
+                                (0,2) (3,1) (8,0)
+                        Goes over the index if there is one, otherwise the
+                        text, but only brackets, commas and quotes are looked
+                        at, so for bad json the counts are just a guess
+                 */
+                void count_containers(std::vector<container_count>& out){
+                        std::vector<std::size_t> stack;
+                        count_containers(out, stack);
+                }
+                // stack is what it needs for the brackets it's in
+                void count_containers(std::vector<container_count>& out, std::vector<std::size_t>& stack){
+                        out.clear();
+                        stack.clear();
+                        auto visit = [&](char c, std::size_t offset){
+                                switch(c){
+                                case '}': case ']':
+                                        if( ! stack.empty() )
+                                                stack.pop_back();
+                                        return;
+                                }
+                                // anything else means the one we're in isn't empty
+                                if( ! stack.empty() && out[stack.back()].count == 0 )
+                                        out[stack.back()].count = 1;
+                                switch(c){
+                                case '{': case '[':
+                                        stack.push_back(out.size());
+                                        out.push_back(container_count{offset, 0});
+                                        break;
+                                case ',':
+                                        if( ! stack.empty() )
+                                                ++out[stack.back()].count;
+                                        break;
+                                }
+                        };
+                        if( use_index_() ){
+                                for(std::size_t cursor = 0; cursor != index_.size(); ++cursor)
+                                        visit(*std::next(start_, index_[cursor]), index_[cursor]);
+                                return;
+                        }
+                        std::size_t offset = 0;
+                        for(Iter iter = start_; iter != state_.last_; ++iter, ++offset){
+                                char c = *iter;
+                                if( detail::is_space(c) )
+                                        continue;
+                                visit(c, offset);
+                                if( c != '"' && ! ( Dialect::single_quotes && c == '\'' ) )
+                                        continue;
+                                // same as skip_container_raw_
+                                Iter first = iter;
+                                for(++iter;;){
+                                        iter = find_quote_or_backslash_(iter, c, detail::is_contiguous_iterator<Iter>{});
+                                        if( iter == state_.last_ || *iter == c )
+                                                break;
+                                        if( *iter == '\\' && ++iter == state_.last_ )
+                                                break;
+                                        ++iter;
+                                }
+                                if( iter == state_.last_ )
+                                        return;
+                                offset += static_cast<std::size_t>(std::distance(first, iter));
+                        }
                 }
         private:
+                // the index already knows which brackets are in strings
+                void skip_container_indexed_(std::size_t offset){
+                        auto const& positions = index_.positions();
+                        auto from = positions.begin() + static_cast<std::ptrdiff_t>(std::min(state_.cursor_, positions.size()));
+                        if( from != positions.begin() && *std::prev(from) >= offset )
+                                from = positions.begin();
+                        std::size_t cursor = static_cast<std::size_t>(
+                                std::lower_bound(from, positions.end(), offset) - positions.begin());
+                        std::size_t depth = 1;
+                        for(; cursor != index_.size(); ++cursor){
+                                switch(*std::next(start_, index_[cursor])){
+                                case '{': case '[':
+                                        ++depth;
+                                        break;
+                                case '}': case ']':
+                                        if( --depth == 0 ){
+                                                state_.first_ = std::next(start_, index_[cursor]);
+                                                state_.cursor_ = cursor;
+                                                return;
+                                        }
+                                        break;
+                                }
+                        }
+                        state_.first_ = state_.last_;
+                        state_.cursor_ = cursor;
+                }
+                void skip_container_raw_(std::size_t offset){
+                        Iter iter = std::next(start_, offset);
+                        std::size_t depth = 1;
+                        while( iter != state_.last_ ){
+                                char c = *iter;
+                                switch(c){
+                                case '\'':
+                                        if( ! Dialect::single_quotes )
+                                                break;
+                                        BOOST_FALLTHROUGH;
+                                case '"':
+                                        for(++iter;;){
+                                                iter = find_quote_or_backslash_(iter, c, detail::is_contiguous_iterator<Iter>{});
+                                                if( iter == state_.last_ || *iter == c )
+                                                        break;
+                                                // whatever is after a backslash can't end the string
+                                                if( *iter == '\\' && ++iter == state_.last_ )
+                                                        break;
+                                                ++iter;
+                                        }
+                                        if( iter == state_.last_ ){
+                                                state_.first_ = state_.last_;
+                                                return;
+                                        }
+                                        break;
+                                case '{': case '[':
+                                        ++depth;
+                                        break;
+                                case '}': case ']':
+                                        if( --depth == 0 ){
+                                                state_.first_ = iter;
+                                                return;
+                                        }
+                                        break;
+                                }
+                                ++iter;
+                        }
+                        state_.first_ = state_.last_;
+                }
+                token fail_(error_code code){
+                        if( ! failed() ){
+                                error_.code = code;
+                                error_.offset = static_cast<std::size_t>(std::distance(start_, state_.first_));
+                        }
+                        state_.first_ = state_.last_;
+                        return token{};
+                }
+                boost::string_view value_(token const& tok, std::string& scratch, std::true_type)const{
+                        if( tok.length() == 0 )
+                                return boost::string_view{};
+                        char const* first = &*start_ + tok.offset();
+                        if( ! tok.escaped() )
+                                return boost::string_view{first, tok.length()};
+                        scratch.clear();
+                        detail::unescape_string(first, first + tok.length(), scratch);
+                        return scratch;
+                }
+                boost::string_view value_(token const& tok, std::string& scratch, std::false_type)const{
+                        auto first = std::next(start_, tok.offset());
+                        auto last  = std::next(first, tok.length());
+                        scratch.clear();
+                        if( ! tok.escaped() )
+                                scratch.append(first, last);
+                        else
+                                detail::unescape_string(first, last, scratch);
+                        return scratch;
+                }
+                static void unescape_(Iter first, Iter last, std::string& out, std::false_type){
+                        detail::unescape_string(first, last, out);
+                }
+                static void unescape_(Iter first, Iter last, std::string& out, std::true_type){
+                        char const* ptr = &*first;
+                        detail::unescape_string(ptr, ptr + std::distance(first, last), out);
+                }
+                /*
+                        With use_structural_index, the index is built the
+                        first time a skip or the counts want it. The tokens
+                        themselves don't go over it, so a parse which
+                        doesn't skip or count never pays for it
+                 */
+                bool use_index_(){
+                        if( ! index_built_ ){
+                                index_built_ = true;
+                                if( options_.use_structural_index )
+                                        build_index_(detail::is_contiguous_iterator<Iter>{});
+                        }
+                        return index_.usable();
+                }
+                void build_index_(std::false_type){}
+                void build_index_(std::true_type){
+                        #ifndef GJSON_NO_STRUCTURAL_INDEX
+                        if( std::distance(start_, end_) < structural_index_threshold )
+                                return;
+                        char const* first = &*start_;
+                        index_.build(first, first + std::distance(start_, end_));
+                        #endif
+                }
+                void eat_whitespace_(){
+                        eat_whitespace_(detail::is_contiguous_iterator<Iter>{});
+                }
+                void eat_whitespace_(std::false_type){
+                        for(;state_.first_!=state_.last_;++state_.first_)
+                                if( ! detail::is_space(*state_.first_))
+                                        break;
+                }
+                // 8 at a time
+                void eat_whitespace_(std::true_type){
+                        if( state_.first_ == state_.last_ )
+                                return;
+                        char const* base = &*start_;
+                        char const* first = base + std::distance(start_, state_.first_);
+                        char const* last  = base + std::distance(start_, state_.last_);
+                        state_.first_ = std::next(start_, detail::skip_space(first, last) - base);
+                }
+                Iter skip_digits_(Iter iter, std::false_type)const{
+                        for(; iter != state_.last_ && detail::is_digit(*iter);++iter);
+                        return iter;
+                }
+                Iter skip_digits_(Iter iter, std::true_type)const{
+                        if( iter == state_.last_ )
+                                return iter;
+                        char const* base = &*start_;
+                        char const* first = base + std::distance(start_, iter);
+                        char const* last  = base + std::distance(start_, state_.last_);
+                        return std::next(start_, detail::skip_digits(first, last) - base);
+                }
 
                 /*
                         I'm not using regular expressions on purpose
                  */
-                boost::optional<token> next_(){
-
-                        // eat whitespace
-                        for(;state_.first_!=state_.last_;++state_.first_)
-                                if( ! std::isspace(*state_.first_))
+                token make_token_(token_type type, Iter first, Iter last, bool escaped = false)const{
+                        return token(type,
+                                     static_cast<std::size_t>(std::distance(start_, first)),
+                                     static_cast<std::size_t>(std::distance(first, last)),
+                                     escaped);
+                }
+                /*
+                        The value of the number is worked out as we scan it, so
+                        the parser never has to look at the text again
+                 */
+                token make_number_(Iter first, Iter last, bool real,
+                                   detail::number_builder const& nb, std::int64_t exp10,
+                                   bool convertible)const{
+                        auto tmp = make_token_(token_type::float_, first, last);
+                        if( ! convertible )
+                                return tmp.set_convertible(false);
+                        std::int64_t int_value;
+                        if( ! real && detail::to_int64(nb, int_value) )
+                                return make_token_(token_type::int_, first, last).set_int_value(int_value);
+                        // too big for an int64 is still a number
+                        double float_value;
+                        if( ! detail::to_double(nb, exp10, float_value) &&
+                            ! detail::to_double_fallback(std::string(first, last), float_value) )
+                        {
+                                return tmp.set_convertible(false);
+                        }
+                        return tmp.set_float_value(float_value);
+                }
+                void scan_digits_(Iter& iter, detail::number_builder& nb, bool fraction, std::false_type){
+                        for(; iter != state_.last_ && detail::is_digit(*iter);++iter)
+                                nb.digit(*iter - '0', fraction);
+                }
+                void scan_digits_(Iter& iter, detail::number_builder& nb, bool fraction, std::true_type){
+                        char const* base = &*start_;
+                        char const* ptr  = base + std::distance(start_, iter);
+                        char const* last = base + std::distance(start_, state_.last_);
+                        // 8 at a time until we run out of digits
+                        for(; last - ptr >= 8 && nb.can_take_eight(); ptr += 8){
+                                auto val = detail::swar_load_(ptr);
+                                if( ! detail::is_eight_digits_(val) )
                                         break;
+                                nb.eight_digits(detail::parse_eight_digits_(val), fraction);
+                        }
+                        for(; ptr != last && detail::is_digit(*ptr); ++ptr){
+                                nb.digit(*ptr - '0', fraction);
+                                if( last - ptr >= 9 && nb.can_take_eight() ){
+                                        // leading zeros are done, go back to 8 at a time
+                                        auto val = detail::swar_load_(ptr + 1);
+                                        if( detail::is_eight_digits_(val) ){
+                                                nb.eight_digits(detail::parse_eight_digits_(val), fraction);
+                                                ptr += 8;
+                                        }
+                                }
+                        }
+                        iter = std::next(start_, ptr - base);
+                }
+                Iter find_invalid_utf8_(Iter first, Iter last, std::false_type)const{
+                        return detail::find_invalid_utf8(first, last);
+                }
+                Iter find_invalid_utf8_(Iter first, Iter last, std::true_type)const{
+                        char const* base = &*start_;
+                        char const* ptr  = base + std::distance(start_, first);
+                        char const* end  = base + std::distance(start_, last);
+                        return std::next(start_, detail::find_invalid_utf8(ptr, end) - base);
+                }
+                Iter find_quote_or_backslash_(Iter iter, char quote, std::false_type)const{
+                        return detail::find_quote_or_backslash< ! Dialect::control_chars >(iter, state_.last_, quote);
+                }
+                Iter find_quote_or_backslash_(Iter iter, char quote, std::true_type)const{
+                        char const* base = &*start_;
+                        char const* first = base + std::distance(start_, iter);
+                        char const* last  = base + std::distance(start_, state_.last_);
+                        return std::next(start_, detail::find_quote_or_backslash< ! Dialect::control_chars >(first, last, quote) - base);
+                }
+                token next_(){
+
+                        eat_whitespace_();
                         if( state_.first_ == state_.last_)
-                                return boost::none;
+                                return token{};
 
                         switch(*state_.first_){
-                                case '{': ++state_.first_; return token(token_type::left_curl ,"{");
-                                case '}': ++state_.first_; return token(token_type::right_curl,"}");
-                                case '[': ++state_.first_; return token(token_type::left_br   ,"[");
-                                case ']': ++state_.first_; return token(token_type::right_br  ,"]");
-                                case ',': ++state_.first_; return token(token_type::comma     ,",");
-                                case ':': ++state_.first_; return token(token_type::colon     ,":");
-
+                                case '{': ++state_.first_; return make_token_(token_type::left_curl , std::prev(state_.first_), state_.first_);
+                                case '}': ++state_.first_; return make_token_(token_type::right_curl, std::prev(state_.first_), state_.first_);
+                                case '[': ++state_.first_; return make_token_(token_type::left_br   , std::prev(state_.first_), state_.first_);
+                                case ']': ++state_.first_; return make_token_(token_type::right_br  , std::prev(state_.first_), state_.first_);
+                                case ',': ++state_.first_; return make_token_(token_type::comma     , std::prev(state_.first_), state_.first_);
+                                case ':': ++state_.first_; return make_token_(token_type::colon     , std::prev(state_.first_), state_.first_);
+
+                                case '\'':
+                                        if( ! Dialect::single_quotes )
+                                                return fail_(error_code::unexpected_character);
+                                        BOOST_FALLTHROUGH;
                                 case '"':{
-                                        auto iter = state_.first_;
-                                        ++iter;
-                                        for(;*iter != '"';++iter){
-                                                if( iter == state_.last_)
-                                                        return return_errror_("unterminated string");
+                                        char quote = *state_.first_;
+                                        auto first = std::next(state_.first_);
+                                        auto iter = first;
+                                        bool escaped = false;
+                                        for(;;){
+                                                iter = find_quote_or_backslash_(iter, quote, detail::is_contiguous_iterator<Iter>{});
+                                                if( iter == state_.last_ )
+                                                        return fail_(error_code::unterminated_string);
+                                                if( *iter == quote )
+                                                        break;
+                                                if( ! Dialect::control_chars && *iter != '\\' ){
+                                                        state_.first_ = iter;
+                                                        return fail_(error_code::unexpected_character);
+                                                }
+                                                escaped = true;
+                                                state_.first_ = iter;
+                                                ++iter;
+                                                switch( detail::skip_escape(iter, state_.last_, quote) ){
+                                                case detail::escape_status::ok:
+                                                        break;
+                                                case detail::escape_status::unterminated:
+                                                        return fail_(error_code::unterminated_string);
+                                                case detail::escape_status::invalid_escape:
+                                                        return fail_(error_code::invalid_escape);
+                                                case detail::escape_status::invalid_unicode_escape:
+                                                        return fail_(error_code::invalid_unicode_escape);
+                                                }
                                         }
-                                        assert( *iter == '"');
-                                        token tmp(token_type::string_,
-                                                std::string(
-                                                        std::next(state_.first_),
-                                                        iter));
-                                        state_.first_ = std::next(iter);
-                                        return tmp;
-                                }
-                                case '\'':{
-                                        auto iter = state_.first_;
-                                        ++iter;
-                                        for(;*iter != '\'';++iter){
-                                                if( iter == state_.last_)
-                                                        return return_errror_("unterminated string");
+                                        if( options_.validate_utf8 ){
+                                                auto bad = find_invalid_utf8_(first, iter, detail::is_contiguous_iterator<Iter>{});
+                                                if( bad != iter ){
+                                                        state_.first_ = bad;
+                                                        return fail_(error_code::invalid_utf8);
+                                                }
                                         }
-                                        assert( *iter == '\'');
-                                        token tmp(token_type::string_,
-                                                std::string(
-                                                        std::next(state_.first_),
-                                                        iter));
+                                        token tmp = make_token_(token_type::string_, first, iter, escaped).set_quoted(true);
                                         state_.first_ = std::next(iter);
                                         return tmp;
                                 }
@@ -279,41 +770,61 @@ namespace gjson{
                         }
 
                         // is it an int or float literals?
-                        if( std::isdigit(*state_.first_) || *state_.first_ == '+' || *state_.first_ == '-' || *state_.first_ == '.'){
+                        if( detail::is_number_start(*state_.first_) ){
 
                                 
                                 bool real = false;
                                 bool leading_dot = false;
+                                detail::number_builder nb;
 
                                 auto iter = state_.first_;
                                 ++iter;
 
                                 switch(*state_.first_ ){
                                         case '+':
+                                                if( ! Dialect::leading_plus )
+                                                        return fail_(error_code::unexpected_character);
+                                                BOOST_FALLTHROUGH;
                                         case '-':
+                                                nb.negative = ( *state_.first_ == '-' );
                                                 // must be followed by digit
                                                 if( iter == state_.last_  )
-                                                        return return_errror_("+/- not followed by digit");
-                                                if( *iter == '.' ){
+                                                        return fail_(error_code::invalid_number);
+                                                if( Dialect::lax_fraction && *iter == '.' ){
                                                         real = true;
                                                         leading_dot = true;
                                                         ++iter;
                                                 }
-                                                if( iter == state_.last_  || ! std::isdigit( *iter ) )
-                                                        return return_errror_("+/- not followed by digit");
+                                                if( iter == state_.last_  || ! detail::is_digit( *iter ) )
+                                                        return fail_(error_code::invalid_number);
                                                 break;
                                         case '.':
+                                                if( ! Dialect::lax_fraction )
+                                                        return fail_(error_code::unexpected_character);
                                                 real = true;
                                                 leading_dot = true;
                                                 // must be followed by digit
-                                                if( iter == state_.last_  || ! std::isdigit( *iter ) )
-                                                        return return_errror_(". not followed by digit");
+                                                if( iter == state_.last_  || ! detail::is_digit( *iter ) )
+                                                        return fail_(error_code::invalid_number);
                                                 break;
                                         default:
+                                                nb.digit(*state_.first_ - '0', false);
                                                 break;
                                 }
 
-                                for(; iter != state_.last_ && std::isdigit(*iter);++iter);
+                                if( ! Dialect::leading_zeros ){
+                                        // 0 has to be on it's own, ie 0.1 but not 01
+                                        auto digit = std::prev(iter);
+                                        if( ! detail::is_digit(*digit) )
+                                                digit = iter;
+                                        if( *digit == '0' ){
+                                                auto next = std::next(digit);
+                                                if( next != state_.last_ && detail::is_digit(*next) )
+                                                        return fail_(error_code::invalid_number);
+                                        }
+                                }
+
+                                scan_digits_(iter, nb, leading_dot, detail::is_contiguous_iterator<Iter>{});
 
                                 if( ! leading_dot ){
                                         // at the 12.34 etc
@@ -321,24 +832,32 @@ namespace gjson{
                                         if( iter != state_.last_ && *iter == '.'){
                                                 ++iter;
                                                 // we can have 0. etc
-                                                for(; iter != state_.last_ && std::isdigit(*iter);++iter);
+                                                if( ! Dialect::lax_fraction &&
+                                                    ( iter == state_.last_ || ! detail::is_digit(*iter) ) )
+                                                {
+                                                        return fail_(error_code::invalid_number);
+                                                }
+                                                scan_digits_(iter, nb, true, detail::is_contiguous_iterator<Iter>{});
                                                 real = true;
                                         }
                                 }
                                 /*
                                         [+-]?\d+\(.\d\*\)?[eE][+-]\d+\(.\d|+\)
                                  */
-                                bool sci = false;
                                 if( iter != state_.last_ && 
                                     ( *iter == 'e' || *iter == 'E') )
                                 {
-                                        sci = true;
                                         ++iter;
                                         if( iter == state_.last_ )
-                                                return return_errror_("expected +/-");
+                                                return fail_(error_code::invalid_number);
 
+                                        bool negative_exponent = false;
                                         switch(*iter){
-                                        case '+': case '-':
+                                        case '-':
+                                                negative_exponent = true;
+                                                ++iter;
+                                                break;
+                                        case '+':
                                                 ++iter;
                                                   break;
                                         default:
@@ -347,75 +866,95 @@ namespace gjson{
                                         }
 
                                         if( iter == state_.last_ )
-                                                return return_errror_("expected expoonent");
+                                                return fail_(error_code::invalid_number);
                                         
-                                        for(; iter != state_.last_ && std::isdigit(*iter);++iter);
+                                        // we can always fit this, anything bigger is 0 or inf anyway
+                                        std::int64_t exp10 = 0;
+                                        bool convertible = detail::is_digit(*iter);
+                                        if( ! Dialect::exponent_fraction && ! convertible )
+                                                return fail_(error_code::invalid_number);
+                                        for(; iter != state_.last_ && detail::is_digit(*iter);++iter){
+                                                if( exp10 < 100000 )
+                                                        exp10 = exp10 * 10 + ( *iter - '0' );
+                                        }
                                         if( iter != state_.last_ && *iter == '.'){
+                                                if( ! Dialect::exponent_fraction )
+                                                        return fail_(error_code::invalid_number);
                                                 ++iter;
                                                 // we can have 0. etc
-                                                for(; iter != state_.last_ && std::isdigit(*iter);++iter);
-                                                real = true;
+                                                iter = skip_digits_(iter, detail::is_contiguous_iterator<Iter>{});
+                                                // we accept 1e2.3, but it isn't a number
+                                                convertible = false;
                                         }
                                 
                                         // most not precede a [a-z]
                                         if( iter != state_.last_ ){
-                                                if( std::isalpha( *iter ) ){
-                                                        return return_errror_("invalid token");
+                                                if( detail::is_alpha( *iter ) ){
+                                                        return fail_(error_code::invalid_token);
                                                 }
                                         }
-                                        auto tmp = token(
-                                                token_type::float_,
-                                                std::string(
-                                                        state_.first_,
-                                                        iter));
+                                        auto tmp = make_number_(state_.first_, iter, true, nb,
+                                                                negative_exponent ? -exp10 : exp10,
+                                                                convertible);
                                         state_.first_ = iter;
-                                        return std::move(tmp);
+                                        return tmp;
 
 
                                 }
 
 
                                
-                                auto tmp = token(
-                                        ( real ? token_type::float_ : token_type::int_ ),
-                                        std::string(
-                                                state_.first_,
-                                                iter));
+                                auto tmp = make_number_(state_.first_, iter, real, nb, 0, true);
                                 state_.first_ = iter;
 
                                 // most not precede a [a-z]
                                 if( iter != state_.last_ ){
-                                        if( std::isalpha( *iter ) ){
-                                                return return_errror_("invalid token");
+                                        if( detail::is_alpha( *iter ) ){
+                                                return fail_(error_code::invalid_token);
                                         }
                                 }
-                                return std::move(tmp);
-                        }  else if( std::isalpha(*state_.first_) || *state_.first_ == '_' ){
+                                return tmp;
+                        }  else if( detail::is_alpha(*state_.first_) || *state_.first_ == '_' ){
                                 auto iter = state_.first_;
-                                for(; (iter != state_.last_) && ( std::isalnum(*iter) || *iter == '_' );++iter){
+                                for(; (iter != state_.last_) && detail::is_ident(*iter);++iter){
                                         if( iter == state_.last_){
                                                 break;
                                         }
                                 }
-                                std::string s( state_.first_, iter);
+                                auto first = state_.first_;
                                 state_.first_ = iter;
-                                if( s == "true" ){
-                                        return token(token_type::true_, std::move(s));
+                                if( is_keyword_(first, iter, "true") ){
+                                        return make_token_(token_type::true_, first, iter);
+                                }
+                                if( is_keyword_(first, iter, "false") ){
+                                        return make_token_(token_type::false_, first, iter);
                                 }
-                                if( s == "false" ){
-                                        return token(token_type::false_, std::move(s));
+                                if( Dialect::bare_identifiers )
+                                        return make_token_(token_type::string_, first, iter);
+                                if( is_keyword_(first, iter, "null") ){
+                                        return make_token_(token_type::null_, first, iter);
                                 }
-                                return token(token_type::string_, std::move(s));
+                                state_.first_ = first;
+                                return fail_(error_code::unexpected_character);
                         } else{
-                                return return_errror_("unregognized sequence of chars");
+                                return fail_(error_code::unexpected_character);
                         }
                 }
+                template<std::size_t N>
+                static bool is_keyword_(Iter first, Iter last, char const (&kw)[N]){
+                        if( static_cast<std::size_t>(std::distance(first, last)) != N - 1 )
+                                return false;
+                        return std::equal(first, last, kw);
+                }
         private:
                 // TODO: reject construction from a string regerence
                 std::string mem_;
                 Iter start_, end_;
                 state_t state_;
-                std::string error_;
+                structural_index index_;
+                parse_options options_;
+                parse_error error_;
+                bool index_built_{false};
         };
 
         using tokenizer = basic_tokenizer<std::string::const_iterator>;
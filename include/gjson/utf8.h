@@ -0,0 +1,255 @@
+#ifndef JSON_PARSER_UTF8_H
+#define JSON_PARSER_UTF8_H
+
+#include <cstdint>
+
+#include "char_class.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace gjson{
+namespace detail{
+
+        inline bool is_utf8_continuation_(unsigned char c){
+                return ( c & 0xC0 ) == 0x80;
+        }
+
+        /*
+                Checks one sequence starting at iter, and moves iter past it.
+                Returns false if it's not valid, ie overlong, a surrogate,
+                bigger than U+10FFFF, or cut short
+         */
+        template<class Iter>
+        bool skip_utf8_sequence_(Iter& iter, Iter last){
+                auto c = static_cast<unsigned char>(*iter);
+                ++iter;
+                if( c < 0x80 )
+                        return true;
+                // the allowed range of the second byte, the rest are 80..BF
+                unsigned char lo = 0x80, hi = 0xBF;
+                unsigned n;
+                if( 0xC2 <= c && c <= 0xDF ){
+                        n = 1;
+                } else if( 0xE0 <= c && c <= 0xEF ){
+                        n = 2;
+                        if( c == 0xE0 ) lo = 0xA0;
+                        if( c == 0xED ) hi = 0x9F;
+                } else if( 0xF0 <= c && c <= 0xF4 ){
+                        n = 3;
+                        if( c == 0xF0 ) lo = 0x90;
+                        if( c == 0xF4 ) hi = 0x8F;
+                } else {
+                        return false;
+                }
+                for(unsigned i = 0; i != n; ++i, ++iter){
+                        if( iter == last )
+                                return false;
+                        auto d = static_cast<unsigned char>(*iter);
+                        if( d < lo || d > hi )
+                                return false;
+                        lo = 0x80;
+                        hi = 0xBF;
+                }
+                return true;
+        }
+
+        // returns the start of the first bad sequence, or last
+        template<class Iter>
+        Iter find_invalid_utf8(Iter first, Iter last){
+                for(; first != last;){
+                        Iter start = first;
+                        if( ! skip_utf8_sequence_(first, last) )
+                                return start;
+                }
+                return first;
+        }
+
+        inline char const* find_invalid_utf8_scalar_(char const* first, char const* last){
+                for(; first != last;){
+                        // ascii 8 at a time
+                        if( last - first >= 8 && ( swar_load_(first) & 0x8080808080808080ULL ) == 0 ){
+                                first += 8;
+                                continue;
+                        }
+                        char const* start = first;
+                        if( ! skip_utf8_sequence_(first, last) )
+                                return start;
+                }
+                return first;
+        }
+
+        /*
+                Backs up from p to the start of the sequence it's in, given
+                that everything before p is known to be good
+         */
+        inline char const* utf8_boundary_(char const* first, char const* p){
+                for(unsigned i = 0; i != 3 && p != first &&
+                    is_utf8_continuation_(static_cast<unsigned char>(p[-1])); ++i)
+                {
+                        --p;
+                }
+                if( p != first && static_cast<unsigned char>(p[-1]) >= 0xC0 )
+                        --p;
+                return p;
+        }
+
+        #if defined(__AVX2__)
+        /*
+                The lookup table method from Keiser and Lemire, "Validating
+                UTF-8 In Less Than One Instruction Per Byte". Each byte is
+                classified by three 16 entry tables, indexed by the high and
+                low nibble of the byte before it and the high nibble of
+                itself, the AND of which is the set of errors that pair of
+                bytes could be. Three and four byte sequences also need the
+                2nd and 3rd previous bytes to say where continuations must be.
+
+                This only says if a block is bad, not where, so it returns
+                the start of the sequence the first bad block starts in
+                (or the end of the whole blocks) and the scalar code carries
+                on from there and finds exactly where it is
+         */
+        struct utf8_avx2_{
+                enum : unsigned char{
+                        too_short      = 1 << 0,
+                        too_long       = 1 << 1,
+                        overlong_3     = 1 << 2,
+                        too_large      = 1 << 3,
+                        surrogate      = 1 << 4,
+                        overlong_2     = 1 << 5,
+                        too_large_1000 = 1 << 6,
+                        overlong_4     = 1 << 6,
+                        two_conts      = 1 << 7,
+                        carry          = too_short | too_long | two_conts,
+                };
+                static __m256i table_(char const (&t)[16]){
+                        __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(t));
+                        return _mm256_broadcastsi128_si256(x);
+                }
+                static __m256i high_nibble_(__m256i x){
+                        return _mm256_and_si256(_mm256_srli_epi16(x, 4), _mm256_set1_epi8(0x0F));
+                }
+                // the byte N before each byte, with prev being the last block
+                template<int N>
+                static __m256i prev_(__m256i input, __m256i prev){
+                        return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - N);
+                }
+                static __m256i check_special_cases_(__m256i input, __m256i prev1){
+                        static char const byte_1_high[16] = {
+                                // 0_______ ________ <ascii in byte 1>
+                                too_long, too_long, too_long, too_long,
+                                too_long, too_long, too_long, too_long,
+                                // 10______ ________ <continuation in byte 1>
+                                (char)two_conts, (char)two_conts, (char)two_conts, (char)two_conts,
+                                // 1100____ ________ <two byte lead in byte 1>
+                                too_short | overlong_2,
+                                // 1101____ ________ <two byte lead in byte 1>
+                                too_short,
+                                // 1110____ ________ <three byte lead in byte 1>
+                                too_short | overlong_3 | surrogate,
+                                // 1111____ ________ <four+ byte lead in byte 1>
+                                too_short | too_large | too_large_1000 | overlong_4,
+                        };
+                        static char const byte_1_low[16] = {
+                                // ____0000 ________
+                                (char)( carry | overlong_3 | overlong_2 | overlong_4 ),
+                                // ____0001 ________
+                                (char)( carry | overlong_2 ),
+                                // ____001_ ________
+                                (char)carry,
+                                (char)carry,
+                                // ____0100 ________
+                                (char)( carry | too_large ),
+                                // ____0101 ________
+                                (char)( carry | too_large | too_large_1000 ),
+                                // ____011_ ________
+                                (char)( carry | too_large | too_large_1000 ),
+                                (char)( carry | too_large | too_large_1000 ),
+                                // ____1___ ________
+                                (char)( carry | too_large | too_large_1000 ),
+                                (char)( carry | too_large | too_large_1000 ),
+                                (char)( carry | too_large | too_large_1000 ),
+                                (char)( carry | too_large | too_large_1000 ),
+                                (char)( carry | too_large | too_large_1000 ),
+                                // ____1101 ________
+                                (char)( carry | too_large | too_large_1000 | surrogate ),
+                                (char)( carry | too_large | too_large_1000 ),
+                                (char)( carry | too_large | too_large_1000 ),
+                        };
+                        static char const byte_2_high[16] = {
+                                // ________ 0_______ <ascii in byte 2>
+                                too_short, too_short, too_short, too_short,
+                                too_short, too_short, too_short, too_short,
+                                // ________ 1000____
+                                (char)( too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4 ),
+                                // ________ 1001____
+                                (char)( too_long | overlong_2 | two_conts | overlong_3 | too_large ),
+                                // ________ 101_____
+                                (char)( too_long | overlong_2 | two_conts | surrogate  | too_large ),
+                                (char)( too_long | overlong_2 | two_conts | surrogate  | too_large ),
+                                // ________ 11______
+                                too_short, too_short, too_short, too_short,
+                        };
+                        __m256i a = _mm256_shuffle_epi8(table_(byte_1_high), high_nibble_(prev1));
+                        __m256i b = _mm256_shuffle_epi8(table_(byte_1_low),
+                                                        _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)));
+                        __m256i c = _mm256_shuffle_epi8(table_(byte_2_high), high_nibble_(input));
+                        return _mm256_and_si256(_mm256_and_si256(a, b), c);
+                }
+                static __m256i check_multibyte_lengths_(__m256i input, __m256i prev, __m256i special_cases){
+                        __m256i prev2 = prev_<2>(input, prev);
+                        __m256i prev3 = prev_<3>(input, prev);
+                        // 0x80 where there has to be a 2nd or 3rd continuation
+                        __m256i third  = _mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+                        __m256i fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+                        __m256i must23 = _mm256_and_si256(
+                                _mm256_cmpgt_epi8(_mm256_or_si256(third, fourth), _mm256_setzero_si256()),
+                                _mm256_set1_epi8(static_cast<char>(0x80)));
+                        return _mm256_xor_si256(must23, special_cases);
+                }
+                // non zero if the block ends part way through a sequence
+                static __m256i is_incomplete_(__m256i input){
+                        const __m256i max_value = _mm256_setr_epi8(
+                                -1, -1, -1, -1, -1, -1, -1, -1,
+                                -1, -1, -1, -1, -1, -1, -1, -1,
+                                -1, -1, -1, -1, -1, -1, -1, -1,
+                                -1, -1, -1, -1, -1,
+                                static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+                        return _mm256_subs_epu8(input, max_value);
+                }
+                static char const* run(char const* first, char const* last){
+                        __m256i prev = _mm256_setzero_si256();
+                        __m256i prev_incomplete = _mm256_setzero_si256();
+                        char const* ptr = first;
+                        for(; last - ptr >= 32; ptr += 32){
+                                __m256i input = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(ptr));
+                                __m256i error;
+                                if( _mm256_movemask_epi8(input) == 0 ){
+                                        error = prev_incomplete;
+                                        prev_incomplete = _mm256_setzero_si256();
+                                } else {
+                                        __m256i prev1 = prev_<1>(input, prev);
+                                        __m256i special = check_special_cases_(input, prev1);
+                                        error = check_multibyte_lengths_(input, prev, special);
+                                        prev_incomplete = is_incomplete_(input);
+                                }
+                                if( ! _mm256_testz_si256(error, error) )
+                                        return utf8_boundary_(first, ptr);
+                                prev = input;
+                        }
+                        return utf8_boundary_(first, ptr);
+                }
+        };
+        #endif
+
+        inline char const* find_invalid_utf8(char const* first, char const* last){
+                #if defined(__AVX2__)
+                first = utf8_avx2_::run(first, last);
+                #endif
+                return find_invalid_utf8_scalar_(first, last);
+        }
+
+} // detail
+} // gjson
+#endif // JSON_PARSER_UTF8_H
@@ -15,6 +15,8 @@
 #include <boost/range/algorithm.hpp>
 #include <boost/variant.hpp>
 
+#include "basic_parser.h"
+#include "mapped_file.h"
 
 namespace gjson{
 namespace variant{
@@ -549,17 +551,19 @@ namespace variant{
         }
 
         template<class Iter>
-        auto try_parse(Iter first, Iter last)->boost::optional<variant::node>{
+        auto try_parse(Iter first, Iter last, parse_error& err)->boost::optional<variant::node>{
                 maker m;
                 basic_parser<maker,Iter> p(m,first,last);
-                try{ 
-                        p.parse();
-                } catch(std::exception const& e){
+                if( ! p.parse(err) )
                         return boost::none;
-                }
                 return m.make();
         }
         template<class Iter>
+        auto try_parse(Iter first, Iter last)->boost::optional<variant::node>{
+                parse_error err;
+                return try_parse(first, last, err);
+        }
+        template<class Iter>
         auto parse(Iter first, Iter last)->variant::node{
                 variant::maker m;
                 basic_parser<maker,Iter> p(m,first,last);
@@ -574,6 +578,33 @@ namespace variant{
         decltype(auto) try_parse(std::string const& s){
                 return try_parse(s.begin(), s.end());
         }
+        inline
+        decltype(auto) try_parse(std::string const& s, parse_error& err){
+                return try_parse(s.begin(), s.end(), err);
+        }
+        /*
+                Parses the file in place through a read only mapping, a
+                failure to open it is an io_error at offset 0
+         */
+        inline
+        boost::optional<node> try_parse_file(std::string const& path, parse_error& err){
+                mapped_file file;
+                if( ! file.open(path) ){
+                        err.code = error_code::io_error;
+                        err.offset = 0;
+                        return boost::none;
+                }
+                return try_parse(file.begin(), file.end(), err);
+        }
+        inline
+        node parse_file(std::string const& path){
+                mapped_file file;
+                if( ! file.open(path) ){
+                        parse_error err{error_code::io_error, 0};
+                        BOOST_THROW_EXCEPTION(parse_exception(err, path + ": " + file.last_error()));
+                }
+                return parse(file.begin(), file.end());
+        }
 } // variant
 } // gjson
 
@@ -1,6 +1,12 @@
 #include "gjson/JsonObject.h"
 #include "gjson/JsonObjectMaker.h"
 #include "gjson/basic_parser.h"
+#include "gjson/string_scanner.h"
+#include "gjson/stream.h"
+#include "gjson/mapped_file.h"
+#include "gjson/parallel.h"
+
+#include <algorithm>
 
 namespace gjson{
 
@@ -9,8 +15,127 @@ void JsonObject::Parse(std::string const& s){
         auto iter = s.begin(), end = s.end();
         basic_parser<JsonObjectMaker,decltype(iter)> p(m,iter, end);
         p.parse();
-        auto ret = m.make();
-        *this = ret;
+        *this = m.make();
+}
+bool JsonObject::TryParse(std::string const& s, parse_error& error){
+        JsonObjectMaker m;
+        auto iter = s.begin(), end = s.end();
+        basic_parser<JsonObjectMaker,decltype(iter)> p(m,iter, end);
+        if( ! p.parse(error) )
+                return false;
+        *this = m.make();
+        return true;
+}
+void JsonObject::Parse(std::string const& s, string_pool& pool){
+        JsonObjectMaker m(pool);
+        basic_parser<JsonObjectMaker,char const*> p(m, s.data(), s.data() + s.size());
+        p.parse();
+        *this = m.make();
+}
+bool JsonObject::TryParse(std::string const& s, parse_error& error, string_pool& pool){
+        JsonObjectMaker m(pool);
+        basic_parser<JsonObjectMaker,char const*> p(m, s.data(), s.data() + s.size());
+        if( ! p.parse(error) )
+                return false;
+        *this = m.make();
+        return true;
+}
+void JsonObject::Parse(std::string const& s, parse_options const& opts, key_order order){
+        JsonObjectMaker m(order);
+        basic_parser<JsonObjectMaker,char const*> p(m, s.data(), s.data() + s.size(), opts);
+        p.parse();
+        *this = m.make();
+}
+bool JsonObject::TryParse(std::string const& s, parse_error& error, parse_options const& opts, key_order order){
+        JsonObjectMaker m(order);
+        basic_parser<JsonObjectMaker,char const*> p(m, s.data(), s.data() + s.size(), opts);
+        if( ! p.parse(error) )
+                return false;
+        *this = m.make();
+        return true;
+}
+void JsonObject::Parse(std::istream& istr){
+        parse_error error;
+        if( ! TryParse(istr, error) ){
+                std::stringstream sstr;
+                sstr << "error: " << error.code << " at offset " << error.offset;
+                BOOST_THROW_EXCEPTION(parse_exception(error, sstr.str()));
+        }
+}
+bool JsonObject::TryParse(std::istream& istr, parse_error& error){
+        JsonObjectMaker m;
+        if( ! parse_stream(m, istr, error) )
+                return false;
+        *this = m.make();
+        return true;
+}
+void JsonObject::ParseFile(std::string const& path){
+        mapped_file file;
+        if( ! file.open(path) ){
+                parse_error error{error_code::io_error, 0};
+                BOOST_THROW_EXCEPTION(parse_exception(error, path + ": " + file.last_error()));
+        }
+        JsonObjectMaker m;
+        basic_parser<JsonObjectMaker,char const*> p(m, file.begin(), file.end());
+        p.parse();
+        *this = m.make();
+}
+bool JsonObject::TryParseFile(std::string const& path, parse_error& error){
+        mapped_file file;
+        if( ! file.open(path) ){
+                error.code = error_code::io_error;
+                error.offset = 0;
+                return false;
+        }
+        JsonObjectMaker m;
+        basic_parser<JsonObjectMaker,char const*> p(m, file.begin(), file.end());
+        if( ! p.parse(error) )
+                return false;
+        *this = m.make();
+        return true;
+}
+bool JsonObject::ParseParallel_(std::string const& s, parallel_options const& opts){
+        unsigned threads = opts.threads != 0 ? opts.threads : thread_pool::default_size();
+        std::size_t parts = std::min<std::size_t>(threads, s.size() / std::max<std::size_t>(opts.min_chunk, 1));
+        if( parts < 2 )
+                return false;
+        thread_pool pool(threads);
+        auto ranges = split_top_level_array(s.data(), s.data() + s.size(), parts, pool);
+        if( ranges.size() < 2 )
+                return false;
+        std::vector<JsonObjectMaker> makers;
+        if( ! parse_ranges<JsonObjectMaker>(ranges, [](){ return JsonObjectMaker{}; }, makers, pool) )
+                return false;
+
+        // join the pieces in order
+        std::vector<JsonObject> pieces;
+        std::size_t total = 0;
+        for(auto& m : makers){
+                pieces.push_back(m.make());
+                total += pieces.back().as_array_.size();
+        }
+        JsonObject result{Tag_Array{}};
+        result.as_array_.reserve(total);
+        for(auto& piece : pieces){
+                for(auto& item : piece.as_array_)
+                        result.as_array_.emplace_back(std::move(item));
+        }
+        *this = std::move(result);
+        return true;
+}
+void JsonObject::ParseParallel(std::string const& s, parallel_options const& opts){
+        if( ! ParseParallel_(s, opts) )
+                Parse(s);
+}
+void JsonObject::ParseParallel(std::string const& s, unsigned threads){
+        parallel_options opts;
+        opts.threads = threads;
+        ParseParallel(s, opts);
+}
+bool JsonObject::TryParseParallel(std::string const& s, parse_error& error, parallel_options const& opts){
+        if( ParseParallel_(s, opts) )
+                return true;
+        return TryParse(s, error);
 }
 
 
@@ -327,7 +452,7 @@ namespace Detail{
 
                 
                 void on_nil()override{
-                        do_primitive_("<nil>");
+                        do_primitive_("null");
                 }
                 void on_bool(bool value)override{
                         do_primitive_( value ? "true" : "false" );
@@ -339,7 +464,10 @@ namespace Detail{
                         do_primitive_( boost::lexical_cast<std::string>(value));
                 }
                 void on_string(std::string const& value)override{
-                        do_primitive_( "\"" + value + "\"");
+                        std::string quoted{"\""};
+                        escape_string(value, quoted);
+                        quoted += "\"";
+                        do_primitive_( std::move(quoted) );
                 }
                 VisitorCtrl begin_array(size_t n)override{
                         do_begin_(Type_Array, n);
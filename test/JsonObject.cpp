@@ -5,6 +5,8 @@
 #include <unordered_map>
 #include <list>
 #include <gtest/gtest.h>
+#include <unistd.h>
+#include <cstdlib>
 
 
 
@@ -414,3 +416,53 @@ TEST(JsonObject, complex1){
         JsonObject obj;
         EXPECT_NO_THROW( obj.Parse(msg) );
 }
+
+TEST(JsonObject, EscapedStringRoundTrip){
+        JsonObject obj;
+        obj.Parse(R"( { "payload" : "{\"id\":1,\"tags\":[\"a\\tb\"]}", "line" : "one\ntwo\u0001" } )");
+        EXPECT_EQ( R"({"id":1,"tags":["a\tb"]})", obj["payload"].AsString() );
+        EXPECT_EQ( "one\ntwo\x01", obj["line"].AsString() );
+
+        JsonObject other;
+        other.Parse( obj.ToString() );
+        EXPECT_EQ( obj["payload"].AsString(), other["payload"].AsString() );
+        EXPECT_EQ( obj["line"].AsString(), other["line"].AsString() );
+
+        JsonObject inner;
+        inner.Parse( other["payload"].AsString() );
+        EXPECT_EQ( 1, inner["id"].AsInteger() );
+        EXPECT_EQ( "a\tb", inner["tags"][0].AsString() );
+}
+
+TEST(JsonObject, TryParse){
+        JsonObject obj;
+        obj.Parse(R"( { "a" : 1 } )");
+        parse_error err;
+        EXPECT_FALSE( obj.TryParse(R"( { "a" : [ 1, 2 } )", err) );
+        EXPECT_EQ( error_code::expected_right_br, err.code );
+        EXPECT_EQ( 16, err.offset );
+        // left alone
+        EXPECT_EQ( 1, obj["a"].AsInteger() );
+        EXPECT_TRUE( obj.TryParse(R"( [ 1, 2 ] )") );
+        EXPECT_EQ( 2, obj.size() );
+}
+
+TEST(JsonObject, ParseFile){
+        char path[] = "/tmp/gjson_test_XXXXXX";
+        int fd = mkstemp(path);
+        ASSERT_GE( fd, 0 );
+        std::string text = R"( { "primes" : [ 2, 3, 5, 7 ], "name" : "bob" } )";
+        EXPECT_EQ( static_cast<ssize_t>(text.size()), write(fd, text.data(), text.size()) );
+        close(fd);
+
+        JsonObject obj;
+        obj.ParseFile(path);
+        EXPECT_EQ( 4, obj["primes"].size() );
+        EXPECT_EQ( "bob", obj["name"].AsString() );
+        unlink(path);
+
+        parse_error err;
+        EXPECT_FALSE( obj.TryParseFile(path, err) );
+        EXPECT_EQ( error_code::io_error, err.code );
+        EXPECT_ANY_THROW( obj.ParseFile(path) );
+}
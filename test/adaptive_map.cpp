@@ -0,0 +1,159 @@
+#include "gjson/JsonObject.h"
+#include "gjson/JsonObjectMaker.h"
+#include "gjson/arena_document.h"
+#include "gjson/documents.h"
+#include "gjson/stream.h"
+#include "gjson/tokenizer.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <sstream>
+
+using namespace gjson;
+
+namespace{
+        std::vector<std::string> keys(JsonObject const& obj){
+                std::vector<std::string> out;
+                for(auto iter = obj.begin(), end = obj.end(); iter != end; ++iter)
+                        out.push_back(iter.key().AsString());
+                return out;
+        }
+        std::string make_map(int n, int first = 0){
+                std::string text = "{";
+                for(int i = n; i-- != 0;){
+                        text += "\"k" + std::to_string(first + i) + "\":" + std::to_string(first + i);
+                        if( i )
+                                text += ",";
+                }
+                return text + "}";
+        }
+}
+
+TEST(adaptive_map, small){
+        JsonObject obj;
+        obj.Parse(R"({"c":1,"a":2,"b":3,"a":4})");
+        EXPECT_EQ( std::vector<std::string>({"a", "b", "c"}), keys(obj) );
+        // the first one wins, like it did with std::map
+        EXPECT_EQ( 2, obj["a"].AsInteger() );
+        EXPECT_FALSE( obj.HasKey("d") );
+
+        obj["aa"] = 5;
+        EXPECT_EQ( std::vector<std::string>({"a", "aa", "b", "c"}), keys(obj) );
+        EXPECT_EQ( 5, obj["aa"].AsInteger() );
+
+        // keys of different types are different keys
+        JsonObject mixed;
+        mixed.Parse(R"({1:"int", "1":"string", 1.0:"float", 1:"again"})");
+        EXPECT_EQ( 3, mixed.size() );
+        EXPECT_EQ( "int", mixed[1].AsString() );
+        EXPECT_EQ( "string", mixed["1"].AsString() );
+}
+
+TEST(adaptive_map, large){
+        // past small_size, so through the hash index
+        JsonObject obj;
+        obj.Parse(make_map(1000));
+        ASSERT_EQ( 1000, obj.size() );
+        std::map<std::string, int> expected;
+        for(int i = 0; i != 1000; ++i){
+                EXPECT_EQ( i, obj["k" + std::to_string(i)].AsInteger() );
+                expected["k" + std::to_string(i)] = i;
+        }
+        std::vector<std::string> sorted;
+        for(auto const& p : expected)
+                sorted.push_back(p.first);
+        EXPECT_EQ( sorted, keys(obj) );
+        EXPECT_FALSE( obj.HasKey("k1000") );
+
+        // into the middle, and then on the end
+        obj["k5x"] = -1;
+        obj["zz"] = -2;
+        EXPECT_EQ( 1002, obj.size() );
+        EXPECT_EQ( -1, obj["k5x"].AsInteger() );
+        EXPECT_EQ( -2, obj["zz"].AsInteger() );
+        EXPECT_EQ( 999, obj["k999"].AsInteger() );
+        EXPECT_EQ( "zz", keys(obj).back() );
+
+        JsonObject copy = obj;
+        EXPECT_EQ( -1, copy["k5x"].AsInteger() );
+        EXPECT_EQ( obj.ToString(), copy.ToString() );
+}
+
+TEST(adaptive_map, duplicates){
+        std::string text = make_map(100);
+        text.back() = ',';
+        text += make_map(100, 50).substr(1);
+        JsonObject obj;
+        obj.Parse(text);
+        EXPECT_EQ( 150, obj.size() );
+        EXPECT_EQ( 99, obj["k99"].AsInteger() );
+
+        JsonObject ordered;
+        ordered.Parse(text, parse_options{}, key_order::insertion);
+        EXPECT_EQ( 150, ordered.size() );
+        EXPECT_EQ( "k99", keys(ordered).front() );
+        EXPECT_EQ( "k149", keys(ordered)[100] );
+        EXPECT_EQ( "k100", keys(ordered).back() );
+}
+
+TEST(adaptive_map, insertion_order){
+        parse_options opts;
+        JsonObject obj;
+        obj.Parse(R"({"c":1,"a":{"z":1,"y":2},"b":3,"c":4})", opts, key_order::insertion);
+        EXPECT_EQ( std::vector<std::string>({"c", "a", "b"}), keys(obj) );
+        EXPECT_EQ( std::vector<std::string>({"z", "y"}), keys(obj["a"]) );
+        EXPECT_EQ( 1, obj["c"].AsInteger() );
+        obj["0"] = 1;
+        EXPECT_EQ( "0", keys(obj).back() );
+
+        JsonObject big;
+        big.Parse(make_map(40), opts, key_order::insertion);
+        EXPECT_EQ( "k39", keys(big).front() );
+        EXPECT_EQ( "k0", keys(big).back() );
+        EXPECT_EQ( 17, big["k17"].AsInteger() );
+
+        JsonObject made(JsonObject::Tag_Map{}, key_order::insertion);
+        made["b"] = 1;
+        made["a"] = 2;
+        EXPECT_EQ( std::vector<std::string>({"b", "a"}), keys(made) );
+}
+
+TEST(adaptive_map, insertion_order_streamed){
+        // it's the maker's, so it doesn't matter what's driving it
+        std::string text = R"({"c":1,"a":{"z":1,"y":2},"b":3,"k":)" + make_map(40) + "}";
+        std::vector<std::string> expected({"c", "a", "b", "k"});
+
+        std::istringstream istr(text);
+        JsonObjectMaker m(key_order::insertion);
+        parse_error err;
+        ASSERT_TRUE( parse_stream(m, istr, err, 8) );
+        JsonObject obj = m.make();
+        EXPECT_EQ( expected, keys(obj) );
+        EXPECT_EQ( "k39", keys(obj["k"]).front() );
+
+        std::istringstream twice(text + text);
+        istream_source source(twice);
+        basic_document_reader<JsonObjectMaker, istream_source> reader(source, 16, parse_options{},
+                                                                       JsonObjectMaker(key_order::insertion));
+        int n = 0;
+        for(JsonObject const& doc : reader){
+                EXPECT_EQ( expected, keys(doc) );
+                ++n;
+        }
+        EXPECT_EQ( 2, n );
+
+        arena_document in_arena(arena::default_block_size, key_order::insertion);
+        in_arena.parse(text);
+        EXPECT_EQ( expected, keys(in_arena.root()) );
+}
+
+TEST(adaptive_map, hash){
+        JsonObject::KeyHash h;
+        JsonObject::KeyEqual eq;
+        EXPECT_TRUE( eq(JsonObject(0.0), JsonObject(-0.0)) );
+        EXPECT_EQ( h(JsonObject(0.0), 1), h(JsonObject(-0.0), 1) );
+        EXPECT_FALSE( eq(JsonObject(1), JsonObject(1.0)) );
+        EXPECT_NE( h(JsonObject(std::string("ab")), 1), h(JsonObject(std::string("ab")), 2) );
+        EXPECT_NE( h(JsonObject(std::string("ab")), 1), h(JsonObject(std::string("ba")), 1) );
+}
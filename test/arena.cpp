@@ -0,0 +1,145 @@
+#include "gjson/arena_document.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+
+using namespace gjson;
+
+namespace{
+        // every operator new in the tests, so we can see a parse makes none
+        std::atomic<std::size_t> news{0};
+}
+void* operator new(std::size_t n){
+        ++news;
+        if( void* p = std::malloc(n ? n : 1) )
+                return p;
+        throw std::bad_alloc{};
+}
+void operator delete(void* p)noexcept{
+        std::free(p);
+}
+void operator delete(void* p, std::size_t)noexcept{
+        std::free(p);
+}
+
+TEST(arena, allocate){
+        arena a(64);
+        auto* p = static_cast<char*>(a.allocate(3, 1));
+        auto* q = a.allocate(8, 8);
+        EXPECT_EQ( 0, reinterpret_cast<std::uintptr_t>(q) % 8 );
+        EXPECT_GE( static_cast<char*>(q), p + 3 );
+        // bigger than a block
+        a.allocate(1000, 1);
+        EXPECT_GE( a.used(), 1011 );
+
+        a.reset();
+        EXPECT_EQ( 0, a.used() );
+        EXPECT_EQ( p, a.allocate(3, 1) );
+
+        char buf[64];
+        arena fixed(buf, sizeof(buf));
+        EXPECT_TRUE( fixed.fixed() );
+        EXPECT_EQ( buf, fixed.allocate(40, 1) );
+        EXPECT_THROW( fixed.allocate(40, 1), std::bad_alloc );
+        fixed.reset();
+        EXPECT_EQ( buf, fixed.allocate(40, 1) );
+}
+
+TEST(arena, document){
+        std::string text = R"({"name":"a string too long for sso","list":[1,2.5,"12",true,null,{"k":"v"}],"n":7})";
+        arena_document doc;
+        EXPECT_TRUE( doc.empty() );
+        doc.parse(text);
+        ASSERT_FALSE( doc.empty() );
+
+        JsonObject heap;
+        heap.Parse(text);
+        EXPECT_EQ( heap.ToString(), doc.root().ToString() );
+        EXPECT_EQ( "a string too long for sso", doc.root()["name"].AsString() );
+        EXPECT_EQ( 12, doc.root()["list"][2].AsInteger() );
+        EXPECT_EQ( "v", doc.root()["list"][5]["k"].AsString() );
+        EXPECT_EQ( 7, doc.root()["n"].AsInteger() );
+        EXPECT_GT( doc.bytes_used(), 0 );
+
+        // a copy is on the heap, so it outlives what's in the arena
+        JsonObject copy = doc.root()["list"];
+        auto used = doc.bytes_used();
+        doc.parse(R"({"other":"xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"})");
+        EXPECT_EQ( "v", copy[5]["k"].AsString() );
+        EXPECT_LT( doc.bytes_used(), used );
+        doc.parse(text);
+        EXPECT_EQ( used, doc.bytes_used() );
+
+        parse_error err;
+        EXPECT_FALSE( doc.parse(R"({"a":[1,2})", err) );
+        EXPECT_EQ( error_code::expected_right_br, err.code );
+        EXPECT_TRUE( doc.empty() );
+        EXPECT_THROW( doc.root(), std::domain_error );
+        EXPECT_THROW( doc.parse(std::string("[")), parse_exception );
+}
+
+TEST(arena, fixed_capacity){
+        std::string text = "[";
+        for(int i=0;i!=100;++i)
+                text += "{\"key\":\"a longer string value " + std::to_string(i) + "\"},";
+        text += "0]";
+
+        static char big[1 << 16];
+        arena_document doc(big, sizeof(big));
+        parse_options opts;
+        opts.size_hints = true;
+        parse_error err;
+        ASSERT_TRUE( doc.parse(text, err, opts) );
+        EXPECT_EQ( 101, doc.root().size() );
+        EXPECT_EQ( "a longer string value 99", doc.root()[99]["key"].AsString() );
+
+        char small[1024];
+        arena_document tight(small, sizeof(small));
+        EXPECT_FALSE( tight.parse(text, err) );
+        EXPECT_EQ( error_code::out_of_memory, err.code );
+        EXPECT_TRUE( tight.empty() );
+        EXPECT_THROW( tight.parse(text), parse_exception );
+        // and it's still usable
+        EXPECT_TRUE( tight.parse(std::string("[1,2]"), err) );
+        EXPECT_EQ( 2, tight.root().size() );
+}
+
+TEST(arena, no_malloc_once_warm){
+        // indexed, escaped strings, a map big enough to be sorted and hashed, and nesting
+        std::string text = "{";
+        for(int i=40;i!=0;--i)
+                text += "\"key " + std::to_string(i) + "\":[" + std::to_string(i) + ",{\"s\":\"a \\\"longer\\\" escaped string\"}],";
+        text += "\"key 7\":0,\"deep\":[[[[[[\"x\"]]]]]]}";
+
+        static char big[1 << 20];
+        arena_document doc(big, sizeof(big));
+        // the first time there's the index and so on to make
+        std::size_t before = news;
+        parse_error err;
+        ASSERT_TRUE( doc.parse(text, err) );
+        EXPECT_NE( before, news );
+
+        parse_options hints;
+        hints.size_hints = true;
+        for(parse_options const& opts : {parse_options{}, hints}){
+                ASSERT_TRUE( doc.parse(text, err, opts) );
+                before = news;
+                bool ok = doc.parse(text, err, opts);
+                std::size_t made = news - before;
+                ASSERT_TRUE( ok );
+                EXPECT_EQ( 0, made );
+                EXPECT_EQ( 41, doc.root().size() );
+                EXPECT_EQ( "a \"longer\" escaped string", doc.root()["key 3"][1]["s"].AsString() );
+                EXPECT_EQ( 7, doc.root()["key 7"][0].AsInteger() );
+
+                // something smaller is fine too
+                std::string smaller = text.substr(0, text.find("\"key 30\"")) + "\"x\":1}";
+                before = news;
+                ok = doc.parse(smaller, err, opts);
+                made = news - before;
+                ASSERT_TRUE( ok );
+                EXPECT_EQ( 0, made );
+                EXPECT_EQ( 11, doc.root().size() );
+        }
+}
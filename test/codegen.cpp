@@ -0,0 +1,125 @@
+// test_messages.h is made from messages.json by gjson_codegen when building
+#include "test_messages.h"
+#include "gjson/JsonObject.h"
+
+#include <gtest/gtest.h>
+#include <limits>
+
+using namespace gjson;
+
+TEST(codegen, parse){
+        std::string text = R"({
+                "id" : 17, "symbol" : "AB\nC", "price" : 12, "live" : true,
+                "legs" : [ { "qty" : 1 }, { "venue" : "X", "qty" : -2, "unknown" : [ { "x" : "]" } ] } ],
+                "grid" : [ [1, 2], [], [3] ],
+                "class" : "c", "a \"quoted\"\nkey" : 5,
+                "extra" : { "ignored" : [ 1, 2, 3 ] }
+        })";
+        test_messages::order o;
+        codegen::parse(text, o);
+        EXPECT_EQ( 17, o.id );
+        EXPECT_EQ( "AB\nC", o.symbol );
+        EXPECT_EQ( 12.0, o.price );
+        EXPECT_TRUE( o.live );
+        ASSERT_EQ( 2, o.legs.size() );
+        EXPECT_EQ( 1, o.legs[0].qty );
+        EXPECT_EQ( "", o.legs[0].venue );
+        EXPECT_EQ( -2, o.legs[1].qty );
+        EXPECT_EQ( "X", o.legs[1].venue );
+        EXPECT_EQ( std::vector<std::vector<std::int64_t> >({{1, 2}, {}, {3}}), o.grid );
+        EXPECT_EQ( "c", o.class_ );
+        EXPECT_EQ( 5, o.odd );
+
+        test_messages::tree t;
+        codegen::parse(R"({"value":1,"children":[{"value":2},{"value":3,"children":[{"value":4}]}]})", t);
+        ASSERT_EQ( 2, t.children.size() );
+        ASSERT_EQ( 1, t.children[1].children.size() );
+        EXPECT_EQ( 4, t.children[1].children[0].value );
+}
+
+TEST(codegen, round_trip){
+        test_messages::order o;
+        o.id = 1;
+        o.symbol = "a\"b";
+        o.price = 0.1;
+        o.legs.resize(2);
+        o.legs[1].qty = 3;
+        o.legs[1].venue = "v";
+        o.odd = -7;
+        auto text = codegen::to_json(o);
+
+        // it's json, and the same as what we started with
+        JsonObject obj;
+        obj.Parse(text);
+        EXPECT_EQ( "a\"b", obj["symbol"].AsString() );
+        EXPECT_EQ( -7, obj["a \"quoted\"\nkey"].AsInteger() );
+
+        test_messages::order back;
+        codegen::parse(text, back);
+        EXPECT_EQ( text, codegen::to_json(back) );
+        EXPECT_EQ( 0.1, back.price );
+}
+
+TEST(codegen, errors){
+        auto error = [](std::string const& text){
+                test_messages::leg l;
+                parse_error err;
+                EXPECT_FALSE( codegen::parse(text, l, err) ) << text;
+                return err;
+        };
+        EXPECT_EQ( error_code::missing_field, error(R"({"venue":"x"})").code );
+        EXPECT_EQ( error_code::unexpected_type, error(R"({"qty":"1"})").code );
+        EXPECT_EQ( 7, error(R"({"qty":[1]})").offset );
+        EXPECT_EQ( error_code::unexpected_type, error(R"({"qty":1.5})").code );
+        EXPECT_EQ( error_code::unexpected_type, error(R"([])").code );
+        EXPECT_EQ( error_code::expected_value, error(R"({"qty":})").code );
+        EXPECT_EQ( error_code::expected_value, error(R"({"qty":1,})").code );
+        EXPECT_EQ( error_code::expected_right_curl, error(R"({"qty":1 "venue":"x"})").code );
+        EXPECT_EQ( error_code::expected_right_br, error(R"({"qty":1,"x":[1})").code );
+        EXPECT_EQ( error_code::trailing_input, error(R"({"qty":1} 2)").code );
+        EXPECT_EQ( error_code::unterminated_string, error(R"({"qty":1,"venue":"x)").code );
+
+        // strict json, and null is only for optional fields
+        EXPECT_EQ( error_code::unexpected_type, error(R"({"qty":null})").code );
+        EXPECT_NE( error_code::none, error(R"({"qty":1,"venue":bare})").code );
+        EXPECT_NE( error_code::none, error(R"({"qty":1,"venue":'x'})").code );
+        test_messages::leg l;
+        l.venue = "x";
+        codegen::parse(R"({"qty":1,"venue":null})", l);
+        EXPECT_EQ( "x", l.venue );
+
+        test_messages::order o;
+        EXPECT_THROW( codegen::parse(R"({"id":1})", o), parse_exception );
+}
+
+TEST(codegen, max_depth){
+        std::string text = R"({"value":1})";
+        for(int i=0;i!=10;++i)
+                text = R"({"value":1,"children":[)" + text + "]}";
+        test_messages::tree t;
+        parse_error err;
+        parse_options opts;
+        opts.max_depth = 21;
+        EXPECT_TRUE( codegen::parse(text, t, err, opts) );
+        opts.max_depth = 20;
+        EXPECT_FALSE( codegen::parse(text, t, err, opts) );
+        EXPECT_EQ( error_code::too_deep, err.code );
+        EXPECT_EQ( text.find("{\"value\":1}"), err.offset );
+}
+
+TEST(codegen, not_finite){
+        test_messages::order o;
+        o.price = std::numeric_limits<double>::quiet_NaN();
+        auto text = codegen::to_json(o);
+        EXPECT_NE( std::string::npos, text.find(R"("price":null)") ) << text;
+        o.price = -std::numeric_limits<double>::infinity();
+        EXPECT_EQ( text, codegen::to_json(o) );
+
+        // still json, but price isn't optional
+        JsonObject obj;
+        obj.Parse(text);
+        test_messages::order back;
+        parse_error err;
+        EXPECT_FALSE( codegen::parse(text, back, err) );
+        EXPECT_EQ( error_code::unexpected_type, err.code );
+}
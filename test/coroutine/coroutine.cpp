@@ -0,0 +1,137 @@
+// built as gjson_coroutine_tests with GJSON_COROUTINES=ON, it needs C++20
+#include "gjson/coroutine.h"
+#include "gjson/JsonObject.h"
+#include "gjson/JsonObjectMaker.h"
+
+#include <gtest/gtest.h>
+
+using namespace gjson;
+
+namespace{
+        // what an event loop would be, the reads waiting for data
+        struct loop{
+                void post(std::coroutine_handle<> h){ ready.push_back(h); }
+                void run(){
+                        while( ! ready.empty() ){
+                                auto h = ready.front();
+                                ready.pop_front();
+                                h.resume();
+                        }
+                }
+                std::deque<std::coroutine_handle<> > ready;
+        };
+
+        // a connection which has n bytes at a time, and never has them straight away
+        struct connection{
+                connection(loop& l, std::string s, std::size_t n)
+                        : loop_(l), s_(std::move(s)), n_(n)
+                {}
+                struct read_awaiter{
+                        bool await_ready()noexcept{ return false; }
+                        void await_suspend(std::coroutine_handle<> h){ self->loop_.post(h); }
+                        std::ptrdiff_t await_resume(){
+                                if( self->fail_at_ != 0 && self->pos_ >= self->fail_at_ )
+                                        return -1;
+                                n = std::min(std::min(n, self->n_), self->s_.size() - self->pos_);
+                                std::copy(self->s_.data() + self->pos_, self->s_.data() + self->pos_ + n, buf);
+                                self->pos_ += n;
+                                return static_cast<std::ptrdiff_t>(n);
+                        }
+                        connection* self;
+                        char* buf;
+                        std::size_t n;
+                };
+                read_awaiter read(char* buf, std::size_t n){ return read_awaiter{this, buf, n}; }
+
+                loop& loop_;
+                std::string s_;
+                std::size_t n_;
+                std::size_t pos_{0};
+                std::size_t fail_at_{0};
+        };
+
+        // a coroutine nobody waits for
+        struct detached{
+                struct promise_type{
+                        detached get_return_object(){ return {}; }
+                        std::suspend_never initial_suspend()noexcept{ return {}; }
+                        std::suspend_never final_suspend()noexcept{ return {}; }
+                        void return_void(){}
+                        void unhandled_exception(){ std::terminate(); }
+                };
+        };
+
+        detached collect(connection& conn, std::vector<std::int64_t>& ids, std::string& error){
+                auto docs = async_documents<JsonObjectMaker>(conn, 3);
+                try{
+                        while( auto* obj = co_await docs.next() )
+                                ids.push_back( (*obj)["id"].AsInteger() );
+                } catch(parse_exception const& e){
+                        error = to_string(e.error().code);
+                }
+        }
+        detached collect_events(connection& conn, std::vector<event_type>& out){
+                auto events = async_events<strict_dialect>(conn, 4);
+                while( auto* e = co_await events.next() )
+                        out.push_back(e->type);
+        }
+}
+
+TEST(coroutine, interleaved){
+        loop l;
+        std::vector<std::unique_ptr<connection> > conns;
+        std::vector<std::vector<std::int64_t> > ids(3);
+        std::vector<std::string> errors(3, "none");
+        for(std::size_t i=0;i!=3;++i){
+                std::string text;
+                for(std::size_t j=0;j!=20;++j)
+                        text += "{\"id\":" + std::to_string(i * 100 + j) + ",\"pad\":\"some text\"}\n";
+                conns.emplace_back(new connection(l, text, i + 1));
+                collect(*conns.back(), ids[i], errors[i]);
+        }
+        // nothing's there until the loop runs
+        EXPECT_TRUE( ids[0].empty() );
+        l.run();
+        for(std::size_t i=0;i!=3;++i){
+                EXPECT_EQ( "none", errors[i] );
+                ASSERT_EQ( 20, ids[i].size() );
+                for(std::size_t j=0;j!=20;++j)
+                        EXPECT_EQ( static_cast<std::int64_t>(i * 100 + j), ids[i][j] );
+        }
+}
+
+TEST(coroutine, events){
+        loop l;
+        connection conn(l, R"({"a":[1,2.5,"x"]} [true,null])", 5);
+        std::vector<event_type> out;
+        collect_events(conn, out);
+        l.run();
+        std::vector<event_type> expected = {
+                event_type::begin_map, event_type::string_, event_type::begin_array, event_type::int_,
+                event_type::float_, event_type::string_, event_type::end_array, event_type::end_map,
+                event_type::end_document,
+                event_type::begin_array, event_type::true_, event_type::null_, event_type::end_array,
+                event_type::end_document,
+        };
+        EXPECT_EQ( expected, out );
+}
+
+TEST(coroutine, errors){
+        loop l;
+        std::vector<std::int64_t> ids;
+        std::string error = "none";
+        connection bad(l, R"({"id":1}{"id":2}{"id":]})", 4);
+        collect(bad, ids, error);
+        l.run();
+        EXPECT_EQ( std::vector<std::int64_t>({1, 2}), ids );
+        EXPECT_EQ( "expected_right_curl", error );
+
+        ids.clear();
+        error = "none";
+        connection broken(l, R"({"id":1}{"id":2})", 4);
+        broken.fail_at_ = 10;
+        collect(broken, ids, error);
+        l.run();
+        EXPECT_EQ( std::vector<std::int64_t>({1}), ids );
+        EXPECT_EQ( "io_error", error );
+}
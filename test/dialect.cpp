@@ -0,0 +1,102 @@
+#include "gjson/basic_parser.h"
+#include "gjson/push_parser.h"
+#include "gjson/variant.h"
+#include "gjson/JsonObject.h"
+#include "gjson/JsonObjectMaker.h"
+
+#include <gtest/gtest.h>
+
+using namespace gjson;
+
+namespace{
+        template<class Dialect>
+        parse_error parse_with(std::string const& text){
+                variant::maker m;
+                basic_parser<variant::maker, char const*, Dialect> p(m, text.data(), text.data() + text.size());
+                parse_error err;
+                p.parse(err);
+                return err;
+        }
+        template<class Dialect>
+        parse_error push_with(std::string const& text){
+                variant::maker m;
+                basic_push_parser<variant::maker, Dialect> p(m);
+                p.feed(text) && p.finish();
+                return p.error();
+        }
+}
+
+TEST(dialect, strict_accepts){
+        std::vector<std::string> good = {
+                R"({"a":[1,-2,0.5,-0.5e-3,1E10,-0,0e1,true,false,null,"x\ty"]})",
+                R"( 12 )",
+                R"("abc")",
+                R"(null)",
+                R"( [ ] )",
+                R"({ "a" : { "b" : [ {} ] } })",
+        };
+        for( auto const& s : good ){
+                EXPECT_FALSE( parse_with<strict_dialect>(s) ) << s;
+                EXPECT_FALSE( push_with<strict_dialect>(s) ) << s;
+        }
+}
+
+TEST(dialect, strict_rejects){
+        std::vector<std::pair<std::string, error_code> > bad = {
+                { R"(['a'])"     , error_code::unexpected_character },
+                { R"([abc])"     , error_code::unexpected_character },
+                { R"([nul])"     , error_code::unexpected_character },
+                { R"([+1])"      , error_code::unexpected_character },
+                { R"([.5])"      , error_code::unexpected_character },
+                { R"([-.5])"     , error_code::invalid_number },
+                { R"([5.])"      , error_code::invalid_number },
+                { R"([5.e3])"    , error_code::invalid_number },
+                { R"([01])"      , error_code::invalid_number },
+                { R"([-01])"     , error_code::invalid_number },
+                { R"([1e2.3])"   , error_code::invalid_number },
+                { R"([1e,2])"    , error_code::invalid_number },
+                { R"({1:2})"     , error_code::expected_right_curl },
+                { R"({"a":1,2:3})", error_code::expected_value },
+                { "[\"a\tb\"]"   , error_code::unexpected_character },
+                { R"(12 13)"     , error_code::trailing_input },
+                { R"()"          , error_code::expected_value },
+        };
+        for( auto const& c : bad ){
+                auto err = parse_with<strict_dialect>(c.first);
+                EXPECT_EQ( c.second, err.code ) << c.first;
+                auto push_err = push_with<strict_dialect>(c.first);
+                EXPECT_EQ( c.second, push_err.code ) << c.first;
+                EXPECT_EQ( err.offset, push_err.offset ) << c.first;
+        }
+}
+
+TEST(dialect, relaxed_is_unchanged){
+        std::vector<std::string> good = {
+                R"(['a'])",
+                R"([abc])",
+                R"([+1])",
+                R"([.5])",
+                R"([5.])",
+                R"([01])",
+                R"({1:2})",
+                "[\"a\tb\"]",
+        };
+        for( auto const& s : good ){
+                EXPECT_FALSE( parse_with<relaxed_dialect>(s) ) << s;
+                EXPECT_FALSE( push_with<relaxed_dialect>(s) ) << s;
+        }
+        EXPECT_EQ( error_code::expected_map_or_array, parse_with<relaxed_dialect>("12").code );
+        EXPECT_EQ( error_code::invalid_number, parse_with<relaxed_dialect>("[1e2.3]").code );
+}
+
+TEST(dialect, strict_null){
+        std::string text = R"([ null, "null" ])";
+        JsonObjectMaker m;
+        basic_parser<JsonObjectMaker, char const*, strict_dialect> p(m, text.data(), text.data() + text.size());
+        p.parse();
+        JsonObject obj = m.make();
+        ASSERT_EQ( 2, obj.size() );
+        EXPECT_EQ( Type_Nil, obj[0].GetType() );
+        EXPECT_EQ( Type_String, obj[1].GetType() );
+        EXPECT_EQ( R"([null, "null"])", obj.ToString() );
+}
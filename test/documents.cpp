@@ -0,0 +1,114 @@
+#include "gjson/documents.h"
+#include "gjson/variant.h"
+#include "gjson/JsonObject.h"
+#include "gjson/JsonObjectMaker.h"
+
+#include <gtest/gtest.h>
+#include <sstream>
+
+using namespace gjson;
+
+namespace{
+        // reads at most n bytes at a time, to split documents between reads
+        struct trickle_source{
+                trickle_source(std::string const& s, std::size_t n)
+                        : s_(s), n_(n)
+                {}
+                std::ptrdiff_t read(char* buf, std::size_t n){
+                        n = std::min(std::min(n, n_), s_.size() - pos_);
+                        std::copy(s_.data() + pos_, s_.data() + pos_ + n, buf);
+                        pos_ += n;
+                        return static_cast<std::ptrdiff_t>(n);
+                }
+        private:
+                std::string s_;
+                std::size_t n_;
+                std::size_t pos_{0};
+        };
+}
+
+TEST(documents, buffer){
+        std::string text = R"({"a":1}{"a":2}  [3,4]
+                              {"a":{"b":[]}})";
+        document_stream<JsonObjectMaker> docs(text);
+        std::vector<std::string> out;
+        for(auto& obj : docs)
+                out.push_back(obj.ToString());
+        EXPECT_FALSE( docs.error() );
+        ASSERT_EQ( 4, out.size() );
+        EXPECT_EQ( R"({"a":1})", out[0] );
+        EXPECT_EQ( R"({"a":2})", out[1] );
+        EXPECT_EQ( R"([3, 4])", out[2] );
+        EXPECT_EQ( R"({"a":{"b":[]}})", out[3] );
+
+        document_stream<JsonObjectMaker> empty("  ");
+        EXPECT_TRUE( empty.begin() == empty.end() );
+        EXPECT_FALSE( empty.error() );
+}
+
+TEST(documents, strict_scalars){
+        std::string text = R"(1 "two" [3] null)";
+        document_stream<variant::maker, strict_dialect> docs(text);
+        std::vector<std::string> out;
+        for(auto& n : docs)
+                out.push_back(variant::to_string(n));
+        EXPECT_FALSE( docs.error() );
+        EXPECT_EQ( 4, out.size() );
+}
+
+TEST(documents, buffer_error){
+        std::string text = R"({"a":1}{"a":2][3])";
+        document_stream<JsonObjectMaker> docs(text);
+        std::size_t n = 0;
+        for(auto& obj : docs){
+                EXPECT_EQ( 1, obj["a"].AsInteger() );
+                ++n;
+        }
+        EXPECT_EQ( 1, n );
+        EXPECT_EQ( error_code::expected_right_curl, docs.error().code );
+        EXPECT_EQ( 13, docs.error().offset );
+}
+
+TEST(documents, reader){
+        std::string text;
+        for(unsigned i=0;i!=50;++i)
+                text += "{\"id\":" + std::to_string(i) + ",\"s\":\"x y\"}" + ( i % 3 ? "" : "\n" ) + "[" + std::to_string(i) + "]";
+        for(std::size_t n : {1, 2, 7, 64, 4096}){
+                trickle_source source(text, n);
+                basic_document_reader<JsonObjectMaker, trickle_source> docs(source, n);
+                std::size_t count = 0;
+                for(auto& obj : docs){
+                        if( count % 2 == 0 )
+                                EXPECT_EQ( static_cast<std::int64_t>(count / 2), obj["id"].AsInteger() ) << n;
+                        else
+                                EXPECT_EQ( static_cast<std::int64_t>(count / 2), obj[0].AsInteger() ) << n;
+                        ++count;
+                }
+                EXPECT_FALSE( docs.error() ) << n;
+                EXPECT_EQ( 100, count ) << n;
+        }
+}
+
+TEST(documents, reader_errors){
+        // a strict scalar can run up to the end of a read
+        std::istringstream istr("12 34 [5] 67");
+        istream_source source(istr);
+        basic_document_reader<variant::maker, istream_source, strict_dialect> docs(source, 1);
+        std::vector<std::string> out;
+        for(auto& n : docs)
+                out.push_back(variant::to_string(n));
+        EXPECT_FALSE( docs.error() );
+        EXPECT_EQ( std::vector<std::string>({"12", "34", "[5]", "67"}), out );
+
+        // the documents before the bad one still come out
+        std::istringstream bad(R"({"a":1} {"a":2} {"a")");
+        istream_source bad_source(bad);
+        basic_document_reader<JsonObjectMaker, istream_source> bad_docs(bad_source);
+        std::size_t n = 0;
+        for(auto& obj : bad_docs){
+                (void)obj;
+                ++n;
+        }
+        EXPECT_EQ( 2, n );
+        EXPECT_EQ( error_code::expected_right_curl, bad_docs.error().code );
+}
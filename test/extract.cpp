@@ -0,0 +1,75 @@
+#include "gjson/extract.h"
+#include "gjson/variant.h"
+
+#include <gtest/gtest.h>
+
+using namespace gjson;
+
+namespace{
+        std::string const text = R"({
+                "user" : { "id" : 42, "name" : "bob", "tags" : [ "a", "b" ] },
+                "items" : [
+                        { "price" : 1.5, "qty" : 2 },
+                        { "qty" : 1, "notes" : { "price" : "not this one" } },
+                        { "price" : 3, "extra" : [ [ { "price" : 99 } ] ] }
+                ],
+                "a/b" : { "c~d" : true },
+                "7" : [ 10, 11, 12 ]
+        })";
+
+        std::vector<std::pair<std::size_t, std::string> > run(path_set const& paths){
+                std::vector<std::pair<std::size_t, std::string> > out;
+                extract(text, paths, [&](std::size_t path, JsonObject& value){
+                        out.emplace_back(path, value.ToString());
+                });
+                return out;
+        }
+        using result = std::vector<std::pair<std::size_t, std::string> >;
+}
+
+TEST(extract, paths){
+        EXPECT_EQ( result({ {0, "42"}, {1, "1.5"}, {1, "3"} }), run({"/user/id", "/items/*/price"}) );
+        EXPECT_EQ( result({ {0, "2"}, {0, "1"} }), run({"/items/*/qty"}) );
+        EXPECT_EQ( result({ {0, "\"b\""} }), run({"/user/tags/1"}) );
+        EXPECT_EQ( result({ {0, "true"} }), run({"/a~1b/c~0d"}) );
+        // a key which is a number is also an index
+        EXPECT_EQ( result({ {0, "12"} }), run({"/7/2"}) );
+        EXPECT_EQ( result({ {0, R"({"price":99})"} }), run({"/items/2/extra/0/0"}) );
+        EXPECT_EQ( result(), run({"/nope", "/user/id/x", "/items/3", "/user/tags/01"}) );
+        EXPECT_EQ( 1, run({""}).size() );
+        EXPECT_THROW( run({"user"}), std::domain_error );
+}
+
+TEST(extract, nested_matches){
+        // the outer value is built, and the inner one on it's own
+        auto out = run({"/user", "/user/id", "/user/*"});
+        ASSERT_EQ( 5, out.size() );
+        EXPECT_EQ( result::value_type(1, "42"), out[0] );
+        EXPECT_EQ( result::value_type(2, "42"), out[1] );
+        EXPECT_EQ( result::value_type(2, "\"bob\""), out[2] );
+        EXPECT_EQ( 2, out[3].first );
+        EXPECT_EQ( 0, out[4].first );
+        JsonObject user;
+        user.Parse(out[4].second);
+        EXPECT_EQ( 42, user["id"].AsInteger() );
+}
+
+TEST(extract, other_makers){
+        std::vector<std::string> out;
+        extract<variant::maker>(text, {"/items/*/qty", "/user"}, [&](std::size_t, variant::node const& n){
+                out.push_back(variant::to_string(n));
+        });
+        ASSERT_EQ( 3, out.size() );
+        EXPECT_EQ( "2", out[1] );
+        EXPECT_EQ( "1", out[2] );
+}
+
+TEST(extract, errors){
+        // still checked where we skip
+        parse_error err;
+        std::size_t n = 0;
+        EXPECT_FALSE( extract(R"({"a":1,"b":[1,2}})", {"/a"}, [&](std::size_t, JsonObject&){ ++n; }, err) );
+        EXPECT_EQ( 1, n );
+        EXPECT_EQ( error_code::expected_right_br, err.code );
+        EXPECT_THROW( extract(R"({"a":1 "b"})", {"/a"}, [](std::size_t, JsonObject&){}), parse_exception );
+}
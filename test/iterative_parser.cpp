@@ -0,0 +1,114 @@
+#include "gjson/iterative_parser.h"
+#include "gjson/basic_parser.h"
+#include "gjson/push_parser.h"
+
+#include <gtest/gtest.h>
+#include <sstream>
+
+using namespace gjson;
+
+namespace{
+        struct recording_maker{
+                void begin_map(){ out << "{"; }
+                void end_map(){ out << "}"; }
+                void begin_array(){ out << "["; }
+                void end_array(){ out << "]"; }
+                void make_string(std::string const& value){ out << "s(" << value << ")"; }
+                void make_int(std::int64_t value){ out << "i(" << value << ")"; }
+                void make_float(double value){ out << "f(" << value << ")"; }
+                void make_null(){ out << "n"; }
+                void make_true(){ out << "t"; }
+                void make_false(){ out << "f"; }
+                std::stringstream out;
+        };
+
+        template<class Dialect = relaxed_dialect>
+        std::pair<std::string, parse_error> recursive(std::string const& text, parse_options const& opts = parse_options{}){
+                recording_maker m;
+                basic_parser<recording_maker, char const*, Dialect> p(m, text.data(), text.data() + text.size(), opts);
+                parse_error err;
+                p.parse(err);
+                return std::make_pair(m.out.str(), err);
+        }
+        template<class Dialect = relaxed_dialect>
+        std::pair<std::string, parse_error> iterative(std::string const& text, parse_options const& opts = parse_options{}){
+                recording_maker m;
+                basic_iterative_parser<recording_maker, char const*, Dialect> p(m, text.data(), text.data() + text.size(), opts);
+                parse_error err;
+                p.parse(err);
+                return std::make_pair(m.out.str(), err);
+        }
+}
+
+TEST(iterative_parser, same_as_recursive){
+        std::vector<std::string> texts = {
+                R"( { "name" : "bob", "ids" : [ 1, -2, 3.5, 1e300 ], 'x' : [ [], {}, [ [ true, false ] ] ], 7 : null } )",
+                R"([])",
+                R"({})",
+                // and bad ones
+                "",
+                "{",
+                "[[]",
+                "[][",
+                "{} 4",
+                "23",
+                "[1,]",
+                "[1 2]",
+                R"( [ 23a ] )",
+                R"( [ "abc )",
+                R"( [ 1e2.3 ] )",
+                R"( { "a" : 1 "b" } )",
+                R"( { "a" : 1 , "b" } )",
+                R"( { "a" : } )",
+                R"( [ @ ] )",
+        };
+        for(auto const& text : texts){
+                auto expected = recursive(text);
+                auto result = iterative(text);
+                EXPECT_EQ( expected.first, result.first ) << text;
+                EXPECT_EQ( expected.second.code, result.second.code ) << text;
+                EXPECT_EQ( expected.second.offset, result.second.offset ) << text;
+        }
+
+        for(std::string text : { "12", "[1,2] 3", "\"a\"", "[01]" }){
+                auto expected = recursive<strict_dialect>(text);
+                auto result = iterative<strict_dialect>(text);
+                EXPECT_EQ( expected.first, result.first ) << text;
+                EXPECT_EQ( expected.second.code, result.second.code ) << text;
+                EXPECT_EQ( expected.second.offset, result.second.offset ) << text;
+        }
+}
+
+TEST(iterative_parser, deep){
+        std::size_t n = 200000;
+        std::string text = std::string(n, '[') + std::string(n, ']');
+        auto result = iterative(text);
+        EXPECT_FALSE( result.second );
+        EXPECT_EQ( text, result.first );
+}
+
+TEST(iterative_parser, max_depth){
+        parse_options opts;
+        opts.max_depth = 3;
+
+        std::string ok = R"({"a":[{"b":1}],"c":[[2]]})";
+        EXPECT_FALSE( recursive(ok, opts).second );
+        EXPECT_FALSE( iterative(ok, opts).second );
+
+        std::string bad = R"({"a":[{"b":[1]}]})";
+        for(auto const& err : { recursive(bad, opts).second, iterative(bad, opts).second }){
+                EXPECT_EQ( error_code::too_deep, err.code );
+                EXPECT_EQ( bad.find("[1"), err.offset );
+        }
+        recording_maker m;
+        basic_push_parser<recording_maker> p(m, opts);
+        EXPECT_FALSE( p.feed(bad) );
+        EXPECT_EQ( error_code::too_deep, p.error().code );
+        EXPECT_EQ( bad.find("[1"), p.error().offset );
+
+        // and it's what stops the deep document
+        opts.max_depth = 1000;
+        std::string deep = std::string(5000, '[') + std::string(5000, ']');
+        EXPECT_EQ( error_code::too_deep, iterative(deep, opts).second.code );
+        EXPECT_EQ( error_code::too_deep, recursive(deep, opts).second.code );
+}
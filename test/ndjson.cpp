@@ -0,0 +1,128 @@
+#include "gjson/ndjson.h"
+#include "gjson/variant.h"
+#include "gjson/JsonObject.h"
+#include "gjson/JsonObjectMaker.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+
+using namespace gjson;
+
+namespace{
+        std::string make_lines(std::size_t n){
+                std::string s;
+                for(std::size_t i=0;i!=n;++i){
+                        s += "{\"id\":" + std::to_string(i) + ",\"tags\":[\"a\",\"b\"]}";
+                        // blank lines and \r\n now and again
+                        if( i % 7 == 0 )
+                                s += "\r\n  \n";
+                        else
+                                s += "\n";
+                }
+                return s;
+        }
+        ndjson_options small_batches(){
+                ndjson_options opts;
+                opts.threads = 3;
+                opts.batch_lines = 5;
+                return opts;
+        }
+        JsonObjectMaker make_maker(){ return JsonObjectMaker{}; }
+}
+
+TEST(ndjson, in_order){
+        std::string text = make_lines(200);
+        std::vector<std::int64_t> ids;
+        std::vector<std::size_t> lines;
+        std::vector<ndjson_error> errors;
+        EXPECT_TRUE( parse_ndjson<JsonObjectMaker>(text, make_maker, [&](std::size_t line, JsonObject obj){
+                ids.push_back( obj["id"].AsInteger() );
+                lines.push_back(line);
+        }, errors, small_batches()) );
+        EXPECT_TRUE( errors.empty() );
+        ASSERT_EQ( 200, ids.size() );
+        for(std::size_t i=0;i!=ids.size();++i)
+                EXPECT_EQ( static_cast<std::int64_t>(i), ids[i] );
+        // each blank line pushes the rest down one
+        EXPECT_EQ( 1, lines[0] );
+        EXPECT_EQ( 3, lines[1] );
+        EXPECT_EQ( 4, lines[2] );
+}
+
+TEST(ndjson, unordered){
+        std::string text = make_lines(300);
+        auto opts = small_batches();
+        opts.ordered = false;
+        std::vector<std::int64_t> ids;
+        std::vector<ndjson_error> errors;
+        EXPECT_TRUE( parse_ndjson<JsonObjectMaker>(text, make_maker, [&](std::size_t, JsonObject obj){
+                ids.push_back( obj["id"].AsInteger() );
+        }, errors, opts) );
+        std::sort(ids.begin(), ids.end());
+        ASSERT_EQ( 300, ids.size() );
+        for(std::size_t i=0;i!=ids.size();++i)
+                EXPECT_EQ( static_cast<std::int64_t>(i), ids[i] );
+}
+
+TEST(ndjson, variant_maker){
+        std::string text = make_lines(30);
+        std::vector<std::string> docs;
+        std::vector<ndjson_error> errors;
+        EXPECT_TRUE( parse_ndjson<variant::maker>(text, [](){ return variant::maker{}; }, [&](std::size_t, variant::node const& n){
+                docs.push_back( variant::to_string(n) );
+        }, errors, small_batches()) );
+        ASSERT_EQ( 30, docs.size() );
+        EXPECT_EQ( variant::to_string(variant::parse(std::string(R"({"id":29,"tags":["a","b"]})"))), docs.back() );
+}
+
+TEST(ndjson, bad_lines){
+        std::string text =
+                "{\"a\":1}\n"
+                "{\"a\":2}\n"
+                "{\"a\":}\n"
+                "{\"a\":4}\n"
+                "[1,2\n"
+                "{\"a\":6} {}\n"
+                "{\"a\":7}\n";
+
+        // stops at the first one
+        std::vector<std::size_t> seen;
+        std::vector<ndjson_error> errors;
+        EXPECT_FALSE( parse_ndjson<JsonObjectMaker>(text, make_maker, [&](std::size_t line, JsonObject){
+                seen.push_back(line);
+        }, errors, small_batches()) );
+        ASSERT_EQ( 1, errors.size() );
+        EXPECT_EQ( 3, errors[0].line );
+        EXPECT_EQ( error_code::expected_right_curl, errors[0].error.code );
+        EXPECT_EQ( 5, errors[0].error.offset );
+        EXPECT_EQ( std::vector<std::size_t>({1, 2}), seen );
+
+        // or carries on
+        for(std::size_t batch : {1, 2, 100}){
+                auto opts = small_batches();
+                opts.skip_bad = true;
+                opts.batch_lines = batch;
+                seen.clear();
+                errors.clear();
+                EXPECT_FALSE( parse_ndjson<JsonObjectMaker>(text, make_maker, [&](std::size_t line, JsonObject obj){
+                        EXPECT_EQ( static_cast<std::int64_t>(line), obj["a"].AsInteger() );
+                        seen.push_back(line);
+                }, errors, opts) );
+                EXPECT_EQ( std::vector<std::size_t>({1, 2, 4, 7}), seen );
+                ASSERT_EQ( 3, errors.size() );
+                EXPECT_EQ( 3, errors[0].line );
+                EXPECT_EQ( 5, errors[1].line );
+                EXPECT_EQ( error_code::expected_right_br, errors[1].error.code );
+                EXPECT_EQ( 6, errors[2].line );
+                EXPECT_EQ( error_code::trailing_input, errors[2].error.code );
+        }
+}
+
+TEST(ndjson, callback_throws){
+        std::string text = make_lines(50);
+        std::vector<ndjson_error> errors;
+        EXPECT_THROW( parse_ndjson<JsonObjectMaker>(text, make_maker, [&](std::size_t line, JsonObject){
+                if( line > 10 )
+                        throw std::runtime_error("stop");
+        }, errors, small_batches()), std::runtime_error );
+}
@@ -0,0 +1,130 @@
+#include "gjson/on_demand.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace gjson;
+
+TEST(on_demand, lookup){
+        std::string text = R"({
+                "name" : "x\ty", "user" : { "tags" : [1, [2], {"a":3}], "id" : 42, "score" : 1.5, "live" : true },
+                "list" : [ 10, 20, 30 ], "a\"b" : 1
+        })";
+        on_demand_document doc(text);
+        EXPECT_EQ( 42, doc["user"]["id"].get_int64() );
+        EXPECT_EQ( "x\ty", doc["name"].get_string() );
+        EXPECT_EQ( 30, doc["list"][2].get_int64() );
+        EXPECT_EQ( 3, doc["user"]["tags"][2]["a"].get_int64() );
+        EXPECT_EQ( 1, doc["a\"b"].get_int64() );
+
+        // in order and out of order off the same object
+        auto user = doc["user"];
+        EXPECT_TRUE( user["live"].get_bool() );
+        EXPECT_EQ( 1.5, user["score"].get_double() );
+        EXPECT_EQ( 42, user["id"].get_int64() );
+        EXPECT_EQ( 42.0, user["id"].get_double() );
+        EXPECT_EQ( token_type::left_br, user["tags"].type() );
+        EXPECT_TRUE( user["live"].get_bool() );
+}
+
+TEST(on_demand, for_each){
+        std::string text = R"({"a":[1,[2,3],4],"b":{"x":1,"y":{"z":2}}, "c":[], "d":{}})";
+        on_demand_document doc(text);
+        std::vector<std::int64_t> ints;
+        doc["a"].for_each([&](on_demand_document::value v){
+                if( v.type() == token_type::int_ )
+                        ints.push_back(v.get_int64());
+                else
+                        ints.push_back(v[1].get_int64());
+        });
+        EXPECT_EQ( std::vector<std::int64_t>({1, 3, 4}), ints );
+
+        std::vector<std::string> keys;
+        doc["b"].for_each([&](std::string const& key, on_demand_document::value v){
+                keys.push_back(key);
+                // looking inside doesn't upset where for_each is
+                if( key == "y" ){
+                        EXPECT_EQ( 2, v["z"].get_int64() );
+                }
+        });
+        EXPECT_EQ( std::vector<std::string>({"x", "y"}), keys );
+
+        int n = 0;
+        doc["c"].for_each([&](on_demand_document::value){ ++n; });
+        doc["d"].for_each([&](std::string const&, on_demand_document::value){ ++n; });
+        EXPECT_EQ( 0, n );
+}
+
+TEST(on_demand, errors){
+        std::string text = R"({"a":{"b":1},"s":"x","l":[1]})";
+        on_demand_document doc(text);
+        auto code = [](on_demand_document::value v){
+                try{
+                        v.get_int64();
+                } catch(parse_exception const& e){
+                        return e.error().code;
+                }
+                return error_code::none;
+        };
+        // kept until a getter
+        auto missing = doc["x"]["y"][0];
+        EXPECT_FALSE( missing );
+        EXPECT_EQ( error_code::missing_field, code(missing) );
+        EXPECT_EQ( error_code::missing_field, code(doc["l"][1]) );
+        EXPECT_EQ( error_code::unexpected_type, code(doc["s"]) );
+        EXPECT_EQ( error_code::unexpected_type, code(doc["a"]) );
+        EXPECT_EQ( error_code::unexpected_type, code(doc["a"][0]) );
+        EXPECT_EQ( error_code::unexpected_type, code(doc["l"]["b"]) );
+        EXPECT_THROW( doc["s"].get_bool(), parse_exception );
+        EXPECT_THROW( doc["s"].for_each([](on_demand_document::value){}), parse_exception );
+        // still fine afterwards
+        EXPECT_EQ( 1, doc["a"]["b"].get_int64() );
+}
+
+TEST(on_demand, lazy){
+        // only what's walked over is looked at
+        std::string text = R"({"a":1,"b" [1,2],"c":2})";
+        {
+                on_demand_document doc(text);
+                EXPECT_EQ( 1, doc["a"].get_int64() );
+        }
+        {
+                on_demand_document doc(text);
+                auto c = doc["c"];
+                EXPECT_FALSE( c );
+                EXPECT_THROW( c.get_int64(), parse_exception );
+                // and it sticks
+                EXPECT_THROW( doc["a"].get_int64(), parse_exception );
+        }
+        {
+                std::string bad = R"({"a":1 "b":2})";
+                on_demand_document doc(bad);
+                EXPECT_EQ( error_code::expected_right_curl, doc["b"].error().code );
+        }
+        {
+                // skipped over, so the missing value isn't seen
+                std::string bad = R"({"a":[1,,2],"b":2})";
+                on_demand_document doc(bad);
+                EXPECT_EQ( 2, doc["b"].get_int64() );
+        }
+}
+
+TEST(on_demand, long_document){
+        // enough to go through the structural index
+        std::string text = "{\"skip\":[";
+        for(int i=0;i!=200;++i)
+                text += "{\"k\":\"a,]}\\\"b\",\"v\":[" + std::to_string(i) + "]},";
+        text += "0],\"id\":7,\"last\":[";
+        for(int i=0;i!=50;++i)
+                text += std::to_string(i) + ",";
+        text += "50]}";
+        on_demand_document doc(text);
+        EXPECT_EQ( 7, doc["id"].get_int64() );
+        EXPECT_EQ( 199, doc["skip"][199]["v"][0].get_int64() );
+        EXPECT_EQ( "a,]}\"b", doc["skip"][3]["k"].get_string() );
+        EXPECT_EQ( 50, doc["last"][50].get_int64() );
+        std::int64_t sum = 0;
+        doc["last"].for_each([&](on_demand_document::value v){ sum += v.get_int64(); });
+        EXPECT_EQ( 50 * 51 / 2, sum );
+}
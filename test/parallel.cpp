@@ -0,0 +1,122 @@
+#include "gjson/parallel.h"
+#include "gjson/JsonObject.h"
+#include "gjson/JsonObjectMaker.h"
+
+#include <gtest/gtest.h>
+#include <random>
+
+using namespace gjson;
+
+namespace{
+        // records with the sort of strings that fool a naive splitter
+        std::string make_records(unsigned n, unsigned seed){
+                std::vector<std::string> strings = {
+                        R"("plain")", R"("a,b")", R"("[{")", R"("}]")", R"("\"")", R"("\\")",
+                        R"("\\\"],")", R"("don't")", R"("")", R"("A,")",
+                };
+                std::mt19937 gen(seed);
+                auto pick = [&](){ return strings[ std::uniform_int_distribution<std::size_t>(0, strings.size() - 1)(gen) ]; };
+                std::string s = " [ ";
+                for(unsigned i=0;i!=n;++i){
+                        if( i != 0 )
+                                s += i % 3 ? "," : " ,\n ";
+                        switch(i % 4){
+                        case 0:
+                                s += "{\"id\":" + std::to_string(i) + ",\"name\":" + pick() + ",\"tags\":[" + pick() + "," + pick() + "]}";
+                                break;
+                        case 1:
+                                s += pick();
+                                break;
+                        case 2:
+                                s += "[[" + std::to_string(i) + ".5],{" + pick() + ":[]}]";
+                                break;
+                        case 3:
+                                s += "true";
+                                break;
+                        }
+                }
+                s += " ] \n";
+                return s;
+        }
+        parallel_options small_chunks(unsigned threads){
+                parallel_options opts;
+                opts.threads = threads;
+                opts.min_chunk = 16;
+                return opts;
+        }
+}
+
+TEST(parallel, split_points){
+        thread_pool pool(3);
+        for(unsigned seed = 0; seed != 50; ++seed){
+                std::string text = make_records(40, seed);
+                for(std::size_t parts = 2; parts != 12; ++parts){
+                        auto ranges = split_top_level_array(text.data(), text.data() + text.size(), parts, pool);
+                        ASSERT_FALSE( ranges.empty() );
+                        // putting the commas back gives the inside of the array
+                        std::string joined;
+                        for(auto const& r : ranges){
+                                if( ! joined.empty() )
+                                        joined += ",";
+                                joined.append(r.first, r.second);
+                        }
+                        EXPECT_EQ( text.substr(text.find('[') + 1, text.rfind(']') - text.find('[') - 1), joined );
+
+                        // and each piece is whole elements
+                        std::vector<JsonObjectMaker> makers;
+                        EXPECT_TRUE( parse_ranges<JsonObjectMaker>(ranges, [](){ return JsonObjectMaker{}; }, makers, pool) );
+                }
+        }
+}
+
+TEST(parallel, same_as_serial){
+        for(unsigned seed = 0; seed != 20; ++seed){
+                std::string text = make_records(200, seed);
+                JsonObject serial;
+                serial.Parse(text);
+                for(unsigned threads : {1, 2, 3, 8}){
+                        JsonObject obj;
+                        obj.ParseParallel(text, small_chunks(threads));
+                        EXPECT_EQ( serial.ToString(), obj.ToString() ) << seed << " " << threads;
+                        EXPECT_EQ( 200, obj.size() );
+                }
+        }
+}
+
+TEST(parallel, falls_back){
+        // a single quoted string outside of a string, a map, and something tiny
+        std::vector<std::string> texts = {
+                "[ 'a,b', \"c\", ['d]'], 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 ]",
+                R"({ "a" : [1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20] })",
+                "[1]",
+                "[]",
+        };
+        for(auto const& text : texts){
+                JsonObject serial;
+                serial.Parse(text);
+                JsonObject obj;
+                obj.ParseParallel(text, small_chunks(4));
+                EXPECT_EQ( serial.ToString(), obj.ToString() ) << text;
+        }
+}
+
+TEST(parallel, errors){
+        std::vector<std::string> bad = {
+                "[1,2,3,4,5,6,7,8,9,10,11,12,,13,14,15,16,17,18,19,20]",
+                "[1,2,3,4,5,6,7,8,9,10,11,12 13,14,15,16,17,18,19,20]",
+                R"([1,2,3,4,5,6,7,8,9,"10,11,12,13,14,15,16,17,18,19,20])",
+                "[1,2,3,4,5,6,7,8,9,10,11,12],[13,14,15,16,17,18,19,20]",
+                "[1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20]]",
+        };
+        for(auto const& text : bad){
+                parse_error serial_err;
+                EXPECT_FALSE( JsonObject{}.TryParse(text, serial_err) ) << text;
+
+                parse_error err;
+                JsonObject obj;
+                EXPECT_FALSE( obj.TryParseParallel(text, err, small_chunks(4)) ) << text;
+                EXPECT_EQ( serial_err.code, err.code ) << text;
+                EXPECT_EQ( serial_err.offset, err.offset ) << text;
+                EXPECT_THROW( obj.ParseParallel(text, small_chunks(4)), parse_exception );
+        }
+}
@@ -0,0 +1,169 @@
+#include "gjson/push_parser.h"
+#include "gjson/basic_parser.h"
+#include "gjson/JsonObject.h"
+#include "gjson/JsonObjectMaker.h"
+
+#include <gtest/gtest.h>
+#include <random>
+#include <sstream>
+
+using namespace gjson;
+
+namespace{
+        // writes every event down, so we can compare parsers
+        struct recording_maker{
+                void begin_map(){ out << "{"; }
+                void end_map(){ out << "}"; }
+                void begin_array(){ out << "["; }
+                void end_array(){ out << "]"; }
+                void make_string(std::string const& value){ out << "s(" << value << ")"; }
+                void make_int(std::int64_t value){ out << "i(" << value << ")"; }
+                void make_float(double value){ out << "f(" << value << ")"; }
+                void make_null(){ out << "n"; }
+                void make_true(){ out << "t"; }
+                void make_false(){ out << "f"; }
+                std::stringstream out;
+        };
+
+        std::string serial_events(std::string const& text){
+                recording_maker m;
+                basic_parser<recording_maker, char const*> p(m, text.data(), text.data() + text.size());
+                parse_error err;
+                EXPECT_TRUE( p.parse(err) ) << text;
+                return m.out.str();
+        }
+        // feeds text in pieces split at the given offsets
+        parse_error push(std::string const& text, std::vector<std::size_t> const& splits, std::string* events = 0){
+                recording_maker m;
+                basic_push_parser<recording_maker> p(m);
+                std::size_t last = 0;
+                for( auto s : splits ){
+                        if( ! p.feed(text.data() + last, s - last) )
+                                break;
+                        last = s;
+                }
+                if( ! p.failed() && p.feed(text.data() + last, text.size() - last) )
+                        p.finish();
+                if( events )
+                        *events = m.out.str();
+                return p.error();
+        }
+
+        std::vector<std::string> documents = {
+                "{}",
+                "  [ ]   ",
+                R"( [ 23 , -3455 , 23.433 , "hello" , null , true , false ] )",
+                R"({"firstName":"John","age":25,"address":{"city":"New York","postalCode":"10021"},"phone":[{"type":"home"},{"type":"fax"}]})",
+                R"( { "esc" : "a\"b\\c\u00e9\ud83d\ude00" , 'single' : 'it\'s' , bare : ident_1 } )",
+                R"( [ 1e10, -0.000123, 123456789012345678901234, 12345678901234567, .5, +3 ] )",
+                R"({1:{},2:[[[]]],3:[{"a":[1,2,{"b":null}]}]})",
+        };
+}
+
+TEST(push_parser, every_split_point){
+        for( auto const& text : documents ){
+                auto expected = serial_events(text);
+                for( std::size_t i = 0; i <= text.size(); ++i ){
+                        std::string events;
+                        auto err = push(text, {i}, &events);
+                        EXPECT_FALSE( err ) << text << " split at " << i << " " << err.code;
+                        EXPECT_EQ( expected, events ) << text << " split at " << i;
+                }
+        }
+}
+
+TEST(push_parser, one_byte_at_a_time){
+        for( auto const& text : documents ){
+                std::vector<std::size_t> splits;
+                for( std::size_t i = 1; i < text.size(); ++i )
+                        splits.push_back(i);
+                std::string events;
+                EXPECT_FALSE( push(text, splits, &events) ) << text;
+                EXPECT_EQ( serial_events(text), events ) << text;
+        }
+}
+
+TEST(push_parser, random_chunks){
+        // big enough that the chunks get a structural index
+        std::string text = "[";
+        for( unsigned i = 0; i != 2000; ++i ){
+                if( i != 0 )
+                        text += ",";
+                text += R"({"id":)" + std::to_string(i) + R"(,"name":"item \")" + std::to_string(i) +
+                        R"(\"","price":)" + std::to_string(i) + ".25,\"tags\":[true,false,null]}";
+        }
+        text += "]";
+        auto expected = serial_events(text);
+
+        std::mt19937 gen(42);
+        for( unsigned run = 0; run != 20; ++run ){
+                std::uniform_int_distribution<std::size_t> dist(1, 300);
+                std::vector<std::size_t> splits;
+                for( std::size_t s = dist(gen); s < text.size(); s += dist(gen) )
+                        splits.push_back(s);
+                std::string events;
+                EXPECT_FALSE( push(text, splits, &events) );
+                EXPECT_EQ( expected, events );
+        }
+}
+
+TEST(push_parser, errors_match_basic_parser){
+        std::vector<std::string> bad = {
+                "",
+                "{",
+                "[",
+                "[[]",
+                "[][",
+                "{} 4",
+                "23",
+                "[1,]",
+                "[1 2]",
+                R"( [ 23 -3455 ] )",
+                R"( [ 23a ] )",
+                R"( [ "abc )",
+                R"( [ "\q" ] )",
+                R"( [ 1e2.3 ] )",
+                R"( { "a" : 1 "b" } )",
+                R"( { "a" : 1 , "b" } )",
+                R"( { "a" : } )",
+                R"( { "a" } )",
+                R"( { "a" : 1 , "b" : } )",
+                R"( [ @ ] )",
+        };
+        for( auto const& text : bad ){
+                recording_maker m;
+                basic_parser<recording_maker, char const*> p(m, text.data(), text.data() + text.size());
+                parse_error expected;
+                EXPECT_FALSE( p.parse(expected) ) << text;
+                for( std::size_t i = 0; i <= text.size(); ++i ){
+                        auto err = push(text, {i});
+                        EXPECT_EQ( expected.code, err.code ) << text << " split at " << i;
+                        EXPECT_EQ( expected.offset, err.offset ) << text << " split at " << i;
+                }
+        }
+}
+
+TEST(push_parser, JsonObject){
+        std::string text = R"({ "primes" : [2,5,7,11,13], "name" : "bob" })";
+        JsonObjectMaker m;
+        basic_push_parser<JsonObjectMaker> p(m);
+        for( std::size_t i = 0; i < text.size(); i += 4 )
+                EXPECT_TRUE( p.feed(text.data() + i, std::min<std::size_t>(4, text.size() - i)) );
+        EXPECT_TRUE( p.finish() );
+        EXPECT_TRUE( p.done() );
+        JsonObject obj = m.make();
+        EXPECT_EQ( 5, obj["primes"].size() );
+        EXPECT_EQ( 11, obj["primes"][3].AsInteger() );
+        EXPECT_EQ( "bob", obj["name"].AsString() );
+}
+
+TEST(push_parser, events_before_the_end){
+        recording_maker m;
+        basic_push_parser<recording_maker> p(m);
+        EXPECT_TRUE( p.feed(R"({ "a" : [ 1, 2, "thr)") );
+        // "thr is held back until we see the rest of it
+        EXPECT_EQ( "{s(a)[i(1)i(2)", m.out.str() );
+        EXPECT_TRUE( p.feed(R"(ee" ] })") );
+        EXPECT_EQ( "{s(a)[i(1)i(2)s(three)]}", m.out.str() );
+        EXPECT_TRUE( p.finish() );
+}
@@ -0,0 +1,117 @@
+#include "gjson/basic_parser.h"
+#include "gjson/iterative_parser.h"
+#include "gjson/tape.h"
+#include "gjson/JsonObject.h"
+#include "gjson/JsonObjectMaker.h"
+
+#include <gtest/gtest.h>
+#include <sstream>
+
+using namespace gjson;
+
+namespace{
+        struct counting_maker{
+                void begin_map(){ out << "{"; }
+                void begin_map(std::size_t n){ out << "{" << n << " "; }
+                void end_map(){ out << "}"; }
+                void begin_array(){ out << "["; }
+                maker_ctrl begin_array(std::size_t n){
+                        out << "[" << n << " ";
+                        return n == skip ? maker_ctrl::skip : maker_ctrl::keep;
+                }
+                void end_array(){ out << "]"; }
+                void make_string(std::string const&){ out << "s"; }
+                void make_int(std::int64_t){ out << "i"; }
+                void make_float(double){ out << "f"; }
+                void make_null(){ out << "n"; }
+                void make_true(){ out << "t"; }
+                void make_false(){ out << "f"; }
+                std::stringstream out;
+                // skip arrays with this many in
+                std::size_t skip{static_cast<std::size_t>(-1)};
+        };
+
+        template<class Dialect = relaxed_dialect, template<class, class, class> class Parser = basic_parser>
+        std::string events(std::string const& text, bool hints = true, std::size_t skip = static_cast<std::size_t>(-1),
+                           bool indexed = false){
+                counting_maker m;
+                m.skip = skip;
+                parse_options opts;
+                opts.size_hints = hints;
+                opts.use_structural_index = indexed;
+                Parser<counting_maker, char const*, Dialect> p(m, text.data(), text.data() + text.size(), opts);
+                parse_error err;
+                EXPECT_TRUE( p.parse(err) ) << text;
+                return m.out.str();
+        }
+}
+
+TEST(size_hints, counts){
+        EXPECT_EQ( "[0 ]", events("[]") );
+        EXPECT_EQ( "{0 }", events("{ }") );
+        EXPECT_EQ( "[3 iii]", events("[1,2,3]") );
+        EXPECT_EQ( "[1 {2 sisi}]", events(R"([{"a":1,"b":2}])") );
+        EXPECT_EQ( "[2 s[0 ]]", events(R"(["],[{,",[]])") );
+        EXPECT_EQ( "{1 s[2 s[1 i]]}", events(R"({ 'a,' : [ 'x]\',', [1] ] })") );
+        EXPECT_EQ( "[2 s[1 i]]", events<strict_dialect>(R"(["a\"[,", [1]])") );
+
+        // only when asked
+        EXPECT_EQ( "[[]]", events("[[]]", false) );
+}
+
+TEST(size_hints, indexed){
+        // long enough for the structural index
+        std::string text = "[";
+        for(int i=0;i!=100;++i)
+                text += "\"x,]\\\"\",";
+        text += "[1,2], {}, [[]] ]";
+        std::string expected = "[103 " + std::string(100, 's') + "[2 ii]{0 }[1 [0 ]]]";
+        EXPECT_EQ( expected, events(text) );
+        EXPECT_EQ( expected, events<strict_dialect>(text) );
+
+        EXPECT_EQ( expected, events(text, true, static_cast<std::size_t>(-1), true) );
+
+        // skipping an array doesn't upset the counts after it
+        EXPECT_EQ( "[103 " + std::string(100, 's') + "[2 ]{0 }[1 [0 ]]]", events(text, true, 2) );
+        EXPECT_EQ( "[103 " + std::string(100, 's') + "[2 ]{0 }[1 [0 ]]]", events(text, true, 2, true) );
+}
+
+TEST(size_hints, iterative){
+        std::string text = "[";
+        for(int i=0;i!=100;++i)
+                text += "\"x,]\\\"\",";
+        text += "[1,2], {\"a\":[3]}, [[]] ]";
+        for(std::string const& t : {text, std::string(R"({ 'a,' : [ 'x]\',', [1] ] })"), std::string("[]")}){
+                EXPECT_EQ( events(t), (events<relaxed_dialect, basic_iterative_parser>(t)) ) << t;
+                EXPECT_EQ( events(t, true, 2), (events<relaxed_dialect, basic_iterative_parser>(t, true, 2)) ) << t;
+                EXPECT_EQ( events(t, false), (events<relaxed_dialect, basic_iterative_parser>(t, false)) ) << t;
+        }
+        EXPECT_EQ( "[103 " + std::string(100, 's') + "[2 ]{1 s[1 i]}[1 [0 ]]]",
+                   (events<relaxed_dialect, basic_iterative_parser>(text, true, 2)) );
+}
+
+TEST(size_hints, tape){
+        tape t;
+        parse_error err;
+        std::string text = R"([1,{"a":[true,false]},[]])";
+        ASSERT_TRUE( parse_tape(text, t, err) );
+        counting_maker m;
+        walk_tape(t, m);
+        EXPECT_EQ( "[3 i{1 s[2 tf]}[0 ]]", m.out.str() );
+}
+
+TEST(size_hints, JsonObject){
+        std::string text = R"({"a":[1,2,3,[4,5]],"b":[],"c":"[,]"})";
+        parse_options opts;
+        opts.size_hints = true;
+        JsonObject with, without;
+        with.Parse(text, opts);
+        without.Parse(text);
+        EXPECT_EQ( without, with );
+        EXPECT_EQ( 4, with["a"].size() );
+
+        parse_error err;
+        JsonObject bad;
+        EXPECT_FALSE( bad.TryParse("[1,2", err, opts) );
+        EXPECT_EQ( error_code::expected_right_br, err.code );
+}
@@ -0,0 +1,156 @@
+#include "gjson/basic_parser.h"
+#include "gjson/iterative_parser.h"
+#include "gjson/push_parser.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <deque>
+#include <set>
+#include <sstream>
+
+using namespace gjson;
+
+namespace{
+        /*
+                Only keeps the keys it's told about, and never wants
+                what's inside an array
+         */
+        struct picky_maker{
+                explicit picky_maker(std::set<std::string> keys)
+                        : wanted(std::move(keys))
+                {}
+                maker_ctrl begin_map(){
+                        value_();
+                        out << "{";
+                        stack.push_back(frame{true, true});
+                        return maker_ctrl::keep;
+                }
+                void end_map(){
+                        out << "}";
+                        stack.pop_back();
+                }
+                maker_ctrl begin_array(){
+                        value_();
+                        out << "[";
+                        stack.push_back(frame{false, false});
+                        return maker_ctrl::skip;
+                }
+                void end_array(){
+                        out << "]";
+                        stack.pop_back();
+                }
+                maker_ctrl make_string(std::string const& value){
+                        if( ! stack.empty() && stack.back().expect_key ){
+                                if( ! wanted.count(value) )
+                                        return maker_ctrl::skip;
+                                out << value << ":";
+                                stack.back().expect_key = false;
+                                return maker_ctrl::keep;
+                        }
+                        value_();
+                        out << "s(" << value << ")";
+                        return maker_ctrl::keep;
+                }
+                void make_int(std::int64_t value){ value_(); out << value; }
+                void make_float(double value){ value_(); out << value; }
+                void make_null(){ value_(); out << "n"; }
+                void make_true(){ value_(); out << "t"; }
+                void make_false(){ value_(); out << "f"; }
+
+                struct frame{
+                        bool map;
+                        bool expect_key;
+                };
+                void value_(){
+                        if( ! stack.empty() && stack.back().map )
+                                stack.back().expect_key = true;
+                }
+                std::set<std::string> wanted;
+                std::vector<frame> stack;
+                std::stringstream out;
+        };
+
+        template<class Iter>
+        std::string pick(Iter first, Iter last, parse_error& err, parse_options const& opts = parse_options{}){
+                picky_maker m({"user", "id", "name"});
+                basic_parser<picky_maker, Iter> p(m, first, last, opts);
+                p.parse(err);
+                return m.out.str();
+        }
+        std::string pick_iterative(std::string const& text, parse_error& err, parse_options const& opts = parse_options{}){
+                picky_maker m({"user", "id", "name"});
+                basic_iterative_parser<picky_maker, char const*> p(m, text.data(), text.data() + text.size(), opts);
+                p.parse(err);
+                return m.out.str();
+        }
+        // fed chunk bytes at a time
+        std::string pick_push(std::string const& text, std::size_t chunk, parse_error& err){
+                picky_maker m({"user", "id", "name"});
+                basic_push_parser<picky_maker> p(m);
+                for(std::size_t i = 0; i < text.size(); i += chunk)
+                        p.feed(text.data() + i, std::min(chunk, text.size() - i));
+                p.finish();
+                err = p.error();
+                return m.out.str();
+        }
+        std::string pick_all_ways(std::string const& text){
+                parse_error err;
+                std::string result = pick(text.data(), text.data() + text.size(), err);
+                EXPECT_FALSE( err ) << text;
+                std::deque<char> d(text.begin(), text.end());
+                EXPECT_EQ( result, pick(d.cbegin(), d.cend(), err) ) << text;
+                EXPECT_FALSE( err ) << text;
+                EXPECT_EQ( result, pick_iterative(text, err) ) << text;
+                EXPECT_FALSE( err ) << text;
+                // and jumping over the structural index
+                parse_options indexed;
+                indexed.use_structural_index = true;
+                EXPECT_EQ( result, pick(text.data(), text.data() + text.size(), err, indexed) ) << text;
+                EXPECT_FALSE( err ) << text;
+                EXPECT_EQ( result, pick_iterative(text, err, indexed) ) << text;
+                EXPECT_FALSE( err ) << text;
+                for(std::size_t chunk : {std::size_t{1}, std::size_t{7}, text.size()}){
+                        EXPECT_EQ( result, pick_push(text, chunk, err) ) << text << " " << chunk;
+                        EXPECT_FALSE( err ) << text << " " << chunk;
+                }
+                return result;
+        }
+}
+
+TEST(skip, keys_and_arrays){
+        // nothing skipped is converted, so 1e2.3 and \q aren't errors
+        std::string text = R"({"user":{"id":7,"x":"bob \"}]","tags":["a",{"b":1e2.3}]},
+                              "junk":{"x":[1,2,{"y":"\\"}],"z":"\q{"},"items":[1,[2,"]"]],"id":3,
+                              "name":"ok"})";
+        ASSERT_GT( text.size(), 128 );
+        EXPECT_EQ( "{user:{id:7}id:3name:s(ok)}", pick_all_ways(text) );
+
+        // short enough not to be indexed
+        EXPECT_EQ( "{id:1}", pick_all_ways(R"({"a":{"}":"{"},"id":1})") );
+        // single quotes are followed too
+        EXPECT_EQ( "{id:1}", pick_all_ways(R"({"a":{'}':'{\'}'},"id":1})") );
+        EXPECT_EQ( "[]", pick_all_ways(R"([1,[2,"]"],{"a":"["}])") );
+        EXPECT_EQ( "{}", pick_all_ways(R"({"a":[],"b":{},"c":1})") );
+}
+
+TEST(skip, every_parser){
+        EXPECT_EQ( "{id:[]id:1}", pick_all_ways(R"({"id":[1,2,3],"b":1,"id":1})") );
+        EXPECT_EQ( "{user:{id:2}}", pick_all_ways(R"({"user":{"a":[{"b":[]}],"id":2,"c":{}}})") );
+        EXPECT_EQ( "{user:{id:[]}name:[]}", pick_all_ways(R"({"user":{"id":[{"id":1}]},"name":[2, "]"]})") );
+}
+
+TEST(skip, still_finds_errors_outside){
+        parse_error err;
+        std::string text = R"({"a":{"b":[1,2]},"id":})";
+        pick(text.data(), text.data() + text.size(), err);
+        EXPECT_EQ( error_code::expected_value, err.code );
+
+        // no end to what's skipped
+        text = R"({"a":{"b":[1,2]})";
+        pick(text.data(), text.data() + text.size(), err);
+        EXPECT_EQ( error_code::expected_right_curl, err.code );
+        pick_iterative(text, err);
+        EXPECT_EQ( error_code::expected_right_curl, err.code );
+        pick_push(text, 3, err);
+        EXPECT_EQ( error_code::expected_right_curl, err.code );
+}
@@ -0,0 +1,91 @@
+#include "gjson/stream.h"
+#include "gjson/basic_parser.h"
+#include "gjson/JsonObject.h"
+#include "gjson/JsonObjectMaker.h"
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <cstdio>
+
+using namespace gjson;
+
+namespace{
+        std::string make_document(unsigned n){
+                std::string text = "[";
+                for( unsigned i = 0; i != n; ++i ){
+                        if( i != 0 )
+                                text += ",\n";
+                        text += R"({"id":)" + std::to_string(i) + R"(,"name":"item \"é)" +
+                                std::to_string(i) + R"(\"","price":)" + std::to_string(i) + ".5}";
+                }
+                text += "]";
+                return text;
+        }
+}
+
+TEST(stream, istream){
+        auto text = make_document(500);
+        JsonObject expected;
+        expected.Parse(text);
+
+        for( std::size_t window : { 1, 7, 64, 4096, 1 << 16 } ){
+                std::istringstream istr(text);
+                JsonObjectMaker m;
+                parse_error err;
+                EXPECT_TRUE( parse_stream(m, istr, err, window) ) << window << " " << err.code;
+                EXPECT_EQ( expected.ToString(), m.make().ToString() ) << window;
+        }
+}
+
+TEST(stream, JsonObject){
+        std::istringstream istr(R"( { "a" : [ 1, 2, 3 ] } )");
+        JsonObject obj;
+        obj.Parse(istr);
+        EXPECT_EQ( 3, obj["a"].size() );
+
+        std::istringstream bad(R"( { "a" : [ 1, 2, 3 } )");
+        parse_error err;
+        EXPECT_FALSE( obj.TryParse(bad, err) );
+        EXPECT_EQ( error_code::expected_right_br, err.code );
+        EXPECT_EQ( 19, err.offset );
+
+        std::istringstream bad2(R"( { "a" )");
+        EXPECT_ANY_THROW( obj.Parse(bad2) );
+}
+
+TEST(stream, fd){
+        auto text = make_document(100);
+        JsonObject expected;
+        expected.Parse(text);
+
+        FILE* f = std::tmpfile();
+        ASSERT_TRUE( f );
+        std::fwrite(text.data(), 1, text.size(), f);
+        std::fflush(f);
+        std::rewind(f);
+
+        JsonObjectMaker m;
+        parse_error err;
+        EXPECT_TRUE( parse_fd(m, fileno(f), err, 100) );
+        EXPECT_EQ( expected.ToString(), m.make().ToString() );
+        std::fclose(f);
+}
+
+TEST(stream, io_error){
+        struct failing_source{
+                std::ptrdiff_t read(char* buf, std::size_t n){
+                        if( calls_++ == 0 ){
+                                buf[0] = '[';
+                                return 1;
+                        }
+                        return -1;
+                }
+                unsigned calls_{0};
+        };
+        failing_source source;
+        JsonObjectMaker m;
+        parse_error err;
+        EXPECT_FALSE( parse_source(m, source, err) );
+        EXPECT_EQ( error_code::io_error, err.code );
+        EXPECT_EQ( 1, err.offset );
+}
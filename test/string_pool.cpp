@@ -0,0 +1,106 @@
+#include "gjson/string_pool.h"
+#include "gjson/JsonObject.h"
+#include "gjson/JsonObjectMaker.h"
+#include "gjson/documents.h"
+
+#include <gtest/gtest.h>
+
+using namespace gjson;
+
+namespace{
+        std::string records(std::size_t n){
+                std::string s = "[";
+                for(std::size_t i=0;i!=n;++i){
+                        if( i != 0 )
+                                s += ",";
+                        s += "{\"customer_identifier\":" + std::to_string(i) +
+                             ",\"phone\":{\"kind\":\"home\",\"number_with_area_code\":\"" + std::to_string(i) + "\"}" +
+                             ",\"status\":\"waiting_for_approval\"}";
+                }
+                return s + "]";
+        }
+}
+
+TEST(string_pool, intern){
+        string_pool pool(4, 8, 2);
+        auto a = pool.intern("abcd");
+        ASSERT_TRUE( !! a );
+        EXPECT_EQ( "abcd", *a );
+        EXPECT_EQ( a.get(), pool.intern(std::string("abcd")).get() );
+        // too short, too long
+        EXPECT_FALSE( pool.intern("abc") );
+        EXPECT_FALSE( pool.intern("abcdefghi") );
+        EXPECT_TRUE( !! pool.intern("abcde") );
+        // full, but what we have still comes back
+        EXPECT_FALSE( pool.intern("abcdef") );
+        EXPECT_EQ( a.get(), pool.intern("abcd").get() );
+        EXPECT_EQ( 2, pool.size() );
+        pool.clear();
+        EXPECT_EQ( 0, pool.size() );
+        EXPECT_EQ( "abcd", *a );
+}
+
+TEST(string_pool, parse){
+        auto text = records(100);
+        JsonObject plain;
+        plain.Parse(text);
+
+        string_pool pool;
+        JsonObject pooled;
+        pooled.Parse(text, pool);
+        EXPECT_EQ( plain.ToString(), pooled.ToString() );
+        // two keys and a value, the rest are too short
+        EXPECT_EQ( 3, pool.size() );
+
+        EXPECT_EQ( 7, pooled[7]["customer_identifier"].AsInteger() );
+        EXPECT_EQ( "waiting_for_approval", pooled[99]["status"].AsString() );
+        EXPECT_TRUE( pooled[3]["phone"].HasKey("number_with_area_code") );
+
+        // copies share the string, and outlive the pool
+        JsonObject copy;
+        {
+                string_pool scoped;
+                JsonObject tmp;
+                parse_error err;
+                ASSERT_TRUE( tmp.TryParse(text, err, scoped) );
+                copy = tmp[5];
+        }
+        EXPECT_EQ( plain[5].ToString(), copy.ToString() );
+        copy["status"] = "done";
+        EXPECT_EQ( "done", copy["status"].AsString() );
+        EXPECT_EQ( plain[5]["status"], pooled[5]["status"] );
+}
+
+TEST(string_pool, short_and_escaped){
+        auto text = records(10);
+        string_pool pool(1);
+        JsonObject pooled;
+        pooled.Parse(text, pool);
+        // "home", "kind" and the rest are in there too
+        EXPECT_EQ( "home", pooled[4]["phone"]["kind"].AsString() );
+        EXPECT_GT( pool.size(), 3 );
+        auto home = pool.intern("home");
+        EXPECT_EQ( pool.intern(std::string("home")).get(), home.get() );
+
+        // decoded before it's looked up, so it's the same string
+        string_pool other;
+        auto status = other.intern("waiting_for_approval");
+        JsonObject escaped;
+        escaped.Parse(R"({"s":"waiting\u005ffor_approval","t":"waiting_for_approval"})", other);
+        EXPECT_EQ( "waiting_for_approval", escaped["s"].AsString() );
+        EXPECT_EQ( 1, other.size() );
+}
+
+TEST(string_pool, across_documents){
+        string_pool pool;
+        std::string text = records(3) + records(3);
+        basic_document_stream<JsonObjectMaker> stream(text.data(), text.data() + text.size(), parse_options{},
+                                                      JsonObjectMaker(pool));
+        std::size_t n = 0;
+        for(auto& obj : stream){
+                EXPECT_EQ( 3, obj.size() );
+                ++n;
+        }
+        EXPECT_EQ( 2, n );
+        EXPECT_EQ( 3, pool.size() );
+}
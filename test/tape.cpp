@@ -0,0 +1,129 @@
+#include "gjson/tape.h"
+#include "gjson/variant.h"
+#include "gjson/JsonObject.h"
+#include "gjson/JsonObjectMaker.h"
+
+#include <gtest/gtest.h>
+#include <deque>
+#include <sstream>
+
+using namespace gjson;
+
+namespace{
+        struct recording_maker{
+                void begin_map(){ out << "{"; }
+                void end_map(){ out << "}"; }
+                void begin_array(){ out << "["; }
+                void end_array(){ out << "]"; }
+                void make_string(std::string const& value){ out << "s(" << value << ")"; }
+                void make_int(std::int64_t value){ out << "i(" << value << ")"; }
+                void make_float(double value){ out << "f(" << value << ")"; }
+                void make_null(){ out << "n"; }
+                void make_true(){ out << "t"; }
+                void make_false(){ out << "f"; }
+                std::stringstream out;
+        };
+}
+
+TEST(tape, layout){
+        tape t;
+        parse_error err;
+        std::string text = R"([1,{"a":true}])";
+        ASSERT_TRUE( parse_tape(text, t, err) );
+        ASSERT_EQ( 8, t.size() );
+        EXPECT_EQ( tape::begin_array, t.type(0) );
+        EXPECT_EQ( 7, t.matching(0) );
+        EXPECT_EQ( 2, t.count(0) );
+        EXPECT_EQ( tape::int_, t.type(1) );
+        EXPECT_EQ( 1, t.int_value(1) );
+        EXPECT_EQ( tape::begin_map, t.type(3) );
+        EXPECT_EQ( 6, t.matching(3) );
+        EXPECT_EQ( 1, t.count(3) );
+        EXPECT_EQ( "a", t.string_value(4) );
+        EXPECT_EQ( tape::true_, t.type(5) );
+        EXPECT_EQ( tape::end_map, t.type(6) );
+        EXPECT_EQ( 3, t.matching(6) );
+        EXPECT_EQ( tape::end_array, t.type(7) );
+        EXPECT_EQ( 0, t.matching(7) );
+
+        EXPECT_EQ( 3, t.next(1) );
+        EXPECT_EQ( 7, t.next(3) );
+        EXPECT_EQ( 8, t.next(0) );
+}
+
+TEST(tape, replay_matches_parser){
+        std::string text = R"( { "name" : "bob \"the\" builder", "ids" : [ 1, -2, 3.5, 1e300, 123456789012345678901 ],
+                                 'x' : [ [], {}, [ [ true, false ] ] ], 7 : { "deep" : { "er" : [ "" ] } } } )";
+        recording_maker direct;
+        basic_parser<recording_maker, char const*> p(direct, text.data(), text.data() + text.size());
+        p.parse();
+
+        tape t;
+        parse_error err;
+        ASSERT_TRUE( parse_tape(text, t, err) );
+        // more than once
+        for( unsigned i = 0; i != 2; ++i ){
+                recording_maker replay;
+                walk_tape(t, replay);
+                EXPECT_EQ( direct.out.str(), replay.out.str() );
+        }
+
+        JsonObjectMaker m;
+        walk_tape(t, m);
+        JsonObject obj = m.make();
+        EXPECT_EQ( 5, obj["ids"].size() );
+        EXPECT_EQ( "bob \"the\" builder", obj["name"].AsString() );
+}
+
+TEST(tape, subtree){
+        tape t;
+        parse_error err;
+        std::string text = R"({"a":[1,2,3],"b":{"c":"d"}})";
+        ASSERT_TRUE( parse_tape(text, t, err) );
+        // find "b" and replay just its value
+        std::size_t idx = 1;
+        for(; idx < t.matching(0); idx = t.next(t.next(idx)) ){
+                if( t.string_value(idx) == "b" )
+                        break;
+        }
+        ASSERT_EQ( "b", t.string_value(idx) );
+        recording_maker m;
+        walk_tape(t, m, idx + 1, t.next(idx + 1));
+        EXPECT_EQ( "{s(c)s(d)}", m.out.str() );
+}
+
+TEST(tape, strings_in_the_text){
+        tape t;
+        parse_error err;
+        std::string text = R"(["plain","esc\"aped",""])";
+        ASSERT_TRUE( parse_tape(text, t, err) );
+        EXPECT_EQ( "plain", t.string_value(1) );
+        EXPECT_EQ( text.data() + 2, t.string_value(1).data() );
+        EXPECT_EQ( "esc\"aped", t.string_value(2) );
+        EXPECT_FALSE( t.string_value(2).data() >= text.data() && t.string_value(2).data() < text.data() + text.size() );
+        EXPECT_EQ( "", t.string_value(3) );
+
+        // appended from somewhere else, so that's copied
+        std::string more = R"(["other"])";
+        ASSERT_TRUE( parse_tape(more, t, err) );
+        more.assign(more.size(), 'x');
+        EXPECT_EQ( "other", t.string_value(t.size() - 2) );
+        EXPECT_EQ( "plain", t.string_value(1) );
+
+        // no text to look into
+        std::deque<char> d(text.begin(), text.end());
+        tape from_deque;
+        ASSERT_TRUE( parse_tape(d.begin(), d.end(), from_deque, err) );
+        d.clear();
+        recording_maker m;
+        walk_tape(from_deque, m);
+        EXPECT_EQ( "[s(plain)s(esc\"aped)s()]", m.out.str() );
+}
+
+TEST(tape, bad_input){
+        tape t;
+        parse_error err;
+        std::string text = "[1,2";
+        EXPECT_FALSE( parse_tape(text, t, err) );
+        EXPECT_EQ( error_code::expected_right_br, err.code );
+}
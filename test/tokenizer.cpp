@@ -3,6 +3,13 @@
 #include <gtest/gtest.h>
 #include <unordered_map>
 #include <list>
+#include <deque>
+#include <random>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <algorithm>
+#include <cctype>
 
 #include <boost/type_index.hpp>
 #include <boost/optional.hpp>
@@ -62,10 +69,30 @@ TEST(tokenizer, eos){
 TEST(tokenizer, bad){
 }
 
+TEST(tokenizer, token_is_a_view){
+        std::string text = R"( {"key" : [ 12, true ]} )";
+        tokenizer tok(text);
+        EXPECT_EQ( token_type::left_curl, tok.peak().type() );
+        EXPECT_EQ( 1, tok.peak().offset() );
+        EXPECT_EQ( 1, tok.peak().length() );
+        tok.next();
+        EXPECT_EQ( token_type::string_, tok.peak().type() );
+        EXPECT_EQ( 3, tok.peak().offset() );
+        EXPECT_EQ( "key", tok.value(tok.peak()) );
+        token const& ref = tok.peak();
+        tok.next();
+        EXPECT_EQ( token_type::colon, ref.type() );
+        for(; ! tok.eos(); tok.next());
+        EXPECT_EQ( token_type::dummy, tok.peak().type() );
+}
+
 TEST(tokenizer, badtoken){
-        EXPECT_ANY_THROW( [](){
         tokenizer tok(R"( 34a )");
-        for(auto t : tok){} }());
+        EXPECT_NO_THROW( [&](){ for(; ! tok.eos(); tok.next()); }() );
+        EXPECT_TRUE( tok.failed() );
+        EXPECT_EQ( error_code::invalid_token, tok.error().code );
+        EXPECT_EQ( 3, tok.error().offset );
+        EXPECT_TRUE( tok.eos() );
 }
 
 TEST(tokenizer, integers){
@@ -77,7 +104,7 @@ TEST(tokenizer, leading_dot){
         auto iter=tok.token_begin(), end=tok.token_end();
         EXPECT_NE( iter, end);
         EXPECT_EQ(token_type::float_,  iter->type());
-        EXPECT_EQ(".0",  iter->value());
+        EXPECT_EQ(".0",  tok.value(*iter));
         ++iter;
         EXPECT_EQ( iter, end);
 }
@@ -86,7 +113,7 @@ TEST(tokenizer, sci_float){
         auto iter=tok.token_begin(), end=tok.token_end();
         EXPECT_NE( iter, end);
         EXPECT_EQ(token_type::float_,  iter->type());
-        EXPECT_EQ("-1e-45",  iter->value());
+        EXPECT_EQ("-1e-45",  tok.value(*iter));
         ++iter;
         EXPECT_EQ( iter, end);
 }
@@ -140,7 +167,7 @@ TEST(tokenizer, floats){
                 auto iter=tok.token_begin(), end=tok.token_end();
                 EXPECT_NE( iter, end) << lit;
                 EXPECT_EQ(token_type::float_,  iter->type()) << lit;
-                EXPECT_EQ(lit,  iter->value()) << lit;
+                EXPECT_EQ(lit,  tok.value(*iter)) << lit;
                 ++iter;
                 EXPECT_EQ( iter, end) << lit;
         }
@@ -149,3 +176,212 @@ TEST(tokenizer, floats){
 
 
 
+
+template<class Iter>
+static std::vector<std::pair<token_type,std::string> > token_stream(Iter first, Iter last){
+        std::vector<std::pair<token_type,std::string> > ret;
+        basic_tokenizer<Iter> tok(first, last);
+        for(auto const& t : tok)
+                ret.emplace_back(t.type(), tok.value(t));
+        return ret;
+}
+
+TEST(tokenizer, structural_index){
+        std::string text = "[";
+        for(unsigned i=0;i!=20;++i){
+                text += json_sample_text;
+                text += " , \"a\"b , 1.2.3, hello world,\t\"{[:,]}\" ,";
+        }
+        text += "{}]";
+        parse_options opts;
+        opts.use_structural_index = true;
+        tokenizer tok(text, opts);
+        EXPECT_TRUE( tok.indexed() );
+        // only when asked
+        EXPECT_FALSE( tokenizer(text).indexed() );
+
+        std::deque<char> unindexed(text.begin(), text.end());
+        EXPECT_EQ( token_stream(unindexed.cbegin(), unindexed.cend()),
+                   token_stream(text.cbegin(), text.cend()) );
+}
+
+TEST(tokenizer, structural_index_positions){
+        std::string text = R"( { "a" : [ 1 , true ] } )";
+        structural_index index(text.data(), text.data() + text.size());
+        EXPECT_TRUE( index.usable() );
+        std::vector<structural_index::position_type> expected;
+        for(size_t i=0;i!=text.size();++i){
+                if( text[i] != ' ' && ( i == 0 || text[i-1] == ' ' ))
+                        expected.push_back(i);
+        }
+        EXPECT_EQ( expected, index.positions() );
+}
+
+TEST(tokenizer, escaped_strings){
+        std::vector<std::pair<std::string, std::string> > cases = {
+                { R"("plain")"                , "plain" },
+                { R"("a\"b")"                 , "a\"b" },
+                { R"("a\\b")"                 , "a\\b" },
+                { R"("\/\b\f\n\r\t")"         , "/\b\f\n\r\t" },
+                { R"("A\u00e9\u20AC")"        , "A\xc3\xa9\xe2\x82\xac" },
+                { R"("\ud83d\ude00")"         , "\xf0\x9f\x98\x80" },
+                { R"('it\'s')"                , "it's" },
+                { R"("{\"nested\":[1,2]}")"   , R"({"nested":[1,2]})" },
+        };
+        for( auto const& c : cases ){
+                tokenizer tok(c.first);
+                EXPECT_EQ( token_type::string_, tok.peak().type() ) << c.first;
+                EXPECT_EQ( c.second, tok.value(tok.peak()) ) << c.first;
+                tok.next();
+                EXPECT_TRUE( tok.eos() ) << c.first;
+        }
+        std::vector<std::string> bad = {
+                R"("abc)",
+                R"("abc\)",
+                R"("\q")",
+                R"("\u12")",
+                R"("\ud83d")",
+                R"("\ude00")",
+        };
+        for( auto const& s : bad ){
+                tokenizer tok(s);
+                EXPECT_TRUE( tok.failed() ) << s;
+                EXPECT_TRUE( tok.eos() ) << s;
+        }
+        EXPECT_EQ( error_code::unterminated_string   , tokenizer{R"("abc)"}.error().code );
+        EXPECT_EQ( error_code::invalid_escape        , tokenizer{R"("\q")"}.error().code );
+        EXPECT_EQ( error_code::invalid_unicode_escape, tokenizer{R"("\ud83d")"}.error().code );
+}
+
+TEST(tokenizer, long_escaped_string){
+        // long enough to go through the block scan and the structural index
+        std::string body(300, 'x');
+        body[100] = '"';
+        body[200] = '\\';
+        std::string text = "[\"" + escape_string(body) + "\" , \"" + body.substr(0,50) + "\"]";
+        parse_options opts;
+        opts.use_structural_index = true;
+        tokenizer tok(text, opts);
+        EXPECT_TRUE( tok.indexed() );
+        tok.next();
+        EXPECT_EQ( body, tok.value(tok.peak()) );
+        tok.next();
+        tok.next();
+        EXPECT_EQ( body.substr(0,50), tok.value(tok.peak()) );
+}
+
+TEST(tokenizer, number_values){
+        std::vector<std::pair<std::string, std::int64_t> > ints = {
+                { "0", 0 },
+                { "-0", 0 },
+                { "+23", 23 },
+                { "007", 7 },
+                { "1234567890123", 1234567890123 },
+                { "9223372036854775807", std::numeric_limits<std::int64_t>::max() },
+                { "-9223372036854775808", std::numeric_limits<std::int64_t>::min() },
+        };
+        for( auto const& c : ints ){
+                tokenizer tok(c.first);
+                EXPECT_EQ( token_type::int_, tok.peak().type() ) << c.first;
+                EXPECT_EQ( c.second, tok.peak().int_value() ) << c.first;
+        }
+
+        std::vector<std::string> floats = {
+                "0.1", "-0.0", ".5", "+.5", "0.", "1e1", "1E-7", "2.5e+3",
+                "3.141592653589793", "2.2250738585072014e-308", "4.9e-324",
+                "1.7976931348623157e308", "1e400", "1e-400",
+                "9223372036854775808", "123456789012345678901234567890",
+                "0.000000000000000000000000000001234567890123456789",
+                "9007199254740993e0", "2.00000000000000011102230246251565404236316680908203125",
+                "7.3177701707893310e+15", "1448997445238699.0",
+        };
+        std::mt19937_64 gen(42);
+        for(unsigned i=0;i!=2000;++i){
+                std::stringstream sstr;
+                std::uniform_int_distribution<int> exp_dist(-330, 310);
+                sstr << ( gen() % 1000000000000ULL ) << "." << ( gen() % 100000000ULL )
+                     << "e" << exp_dist(gen);
+                floats.push_back(sstr.str());
+                double d;
+                std::uint64_t bits = gen();
+                std::memcpy(&d, &bits, sizeof(d));
+                if( std::isfinite(d) ){
+                        sstr.str("");
+                        sstr << std::scientific << std::setprecision(16) << d;
+                        floats.push_back(sstr.str());
+                }
+        }
+        for( auto const& lit : floats ){
+                tokenizer tok(lit);
+                EXPECT_EQ( token_type::float_, tok.peak().type() ) << lit;
+                EXPECT_TRUE( tok.peak().convertible() ) << lit;
+                double expected = std::strtod(lit.c_str(), 0);
+                double actual   = tok.peak().float_value();
+                EXPECT_EQ( 0, std::memcmp(&expected, &actual, sizeof(double)) )
+                        << lit << " " << std::setprecision(17) << expected << " != " << actual;
+
+                // and without the 8 digits at a time path
+                std::deque<char> unindexed(lit.begin(), lit.end());
+                basic_tokenizer<std::deque<char>::const_iterator> slow(unindexed.cbegin(), unindexed.cend());
+                actual = slow.peak().float_value();
+                EXPECT_EQ( 0, std::memcmp(&expected, &actual, sizeof(double)) ) << lit;
+        }
+
+        for( auto const& lit : { "12e3.4", "1e+," } ){
+                tokenizer tok(lit);
+                EXPECT_EQ( token_type::float_, tok.peak().type() ) << lit;
+                EXPECT_FALSE( tok.peak().convertible() ) << lit;
+        }
+}
+
+TEST(tokenizer, char_class){
+        for(int c = 0; c != 256; ++c){
+                char ch = static_cast<char>(c);
+                EXPECT_EQ( !!std::isspace(c), detail::is_space(ch) ) << c;
+                EXPECT_EQ( !!std::isdigit(c), detail::is_digit(ch) ) << c;
+                EXPECT_EQ( !!std::isalpha(c), detail::is_alpha(ch) ) << c;
+                EXPECT_EQ( !!std::isalnum(c) || c == '_', detail::is_ident(ch) ) << c;
+        }
+        std::mt19937 gen(7);
+        char const alphabet[] = " \t\n\r\v\f0123456789a\x80\xff";
+        for(unsigned i=0;i!=1000;++i){
+                std::string s(gen() % 40, ' ');
+                for(auto& c : s )
+                        c = alphabet[gen() % ( sizeof(alphabet) - 1 )];
+                char const* first = s.data();
+                char const* last  = s.data() + s.size();
+                EXPECT_EQ( std::find_if(first, last, [](char c){ return ! std::isspace(static_cast<unsigned char>(c)); }),
+                           detail::skip_space(first, last) ) << s;
+                EXPECT_EQ( std::find_if(first, last, [](char c){ return ! std::isdigit(static_cast<unsigned char>(c)); }),
+                           detail::skip_digits(first, last) ) << s;
+        }
+}
+
+TEST(tokenizer, unindexed_contiguous){
+        // the single quotes turn off the index, so this is the SWAR path
+        std::string text = "[";
+        for(unsigned i=0;i!=20;++i){
+                text += json_sample_text;
+                text += " , 'single quoted' ,\n                 12345678901234567 , 1.5e3,";
+        }
+        text += "{}]";
+        parse_options opts;
+        opts.use_structural_index = true;
+        tokenizer tok(text, opts);
+        EXPECT_FALSE( tok.indexed() );
+
+        std::deque<char> unindexed(text.begin(), text.end());
+        EXPECT_EQ( token_stream(unindexed.cbegin(), unindexed.cend()),
+                   token_stream(text.cbegin(), text.cend()) );
+}
+
+TEST(tokenizer, error_location){
+        tokenizer tok("[ 1,\n  2,\n  @ ]");
+        for(; ! tok.eos(); tok.next());
+        EXPECT_EQ( error_code::unexpected_character, tok.error().code );
+        EXPECT_EQ( 12, tok.error().offset );
+        auto loc = tok.location();
+        EXPECT_EQ( 3, loc.line );
+        EXPECT_EQ( 3, loc.column );
+        EXPECT_NE( std::string::npos, tok.get_error().find("unexpected_character") );
+}
@@ -0,0 +1,122 @@
+#include "gjson/utf8.h"
+#include "gjson/basic_parser.h"
+#include "gjson/push_parser.h"
+#include "gjson/variant.h"
+
+#include <gtest/gtest.h>
+#include <deque>
+#include <random>
+
+using namespace gjson;
+
+namespace{
+        // the char at a time version, over something that isn't a pointer
+        std::size_t reference(std::string const& s){
+                std::deque<char> d(s.begin(), s.end());
+                return static_cast<std::size_t>(
+                        std::distance(d.begin(), detail::find_invalid_utf8(d.begin(), d.end())));
+        }
+        std::size_t fast(std::string const& s){
+                return static_cast<std::size_t>(
+                        detail::find_invalid_utf8(s.data(), s.data() + s.size()) - s.data());
+        }
+}
+
+TEST(utf8, sequences){
+        std::vector<std::string> good = {
+                "",
+                "hello",
+                "\xC3\xA9",                     // U+00E9
+                "\xE2\x82\xAC",                 // U+20AC
+                "\xED\x9F\xBF",                 // U+D7FF
+                "\xEE\x80\x80",                 // U+E000
+                "\xF0\x9F\x98\x80",             // U+1F600
+                "\xF4\x8F\xBF\xBF",             // U+10FFFF
+        };
+        for( auto const& s : good ){
+                EXPECT_EQ( s.size(), reference(s) );
+                EXPECT_EQ( s.size(), fast(s) );
+        }
+        std::vector<std::string> bad = {
+                "\x80",                         // stray continuation
+                "\xC0\xAF",                     // overlong
+                "\xC1\xBF",                     // overlong
+                "\xE0\x80\xAF",                 // overlong
+                "\xED\xA0\x80",                 // surrogate
+                "\xF0\x80\x80\xAF",             // overlong
+                "\xF4\x90\x80\x80",             // > U+10FFFF
+                "\xF5\x80\x80\x80",
+                "\xFF",
+                "\xC3",                         // cut short
+                "\xE2\x82",
+                "\xF0\x9F\x98",
+                "\xC3\x41",
+        };
+        for( auto const& s : bad ){
+                EXPECT_EQ( 0, reference(s) );
+                EXPECT_EQ( 0, fast(s) );
+        }
+}
+
+TEST(utf8, agrees_with_reference){
+        // mostly valid text with the odd bad byte, at every alignment
+        std::vector<std::string> pieces = {
+                "a", "bc", "0123456789", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80",
+                "\xED\x9F\xBF", "\xF4\x8F\xBF\xBF",
+        };
+        std::vector<std::string> poison = {
+                "\x80", "\xC3", "\xED\xA0\x80", "\xF4\x90", "\xFF", "\xE0\x80\xAF", "\xC3\x41",
+        };
+        std::mt19937 gen(7);
+        for( unsigned run = 0; run != 2000; ++run ){
+                std::string s;
+                std::size_t n = std::uniform_int_distribution<std::size_t>(0, 200)(gen);
+                while( s.size() < n )
+                        s += pieces[ std::uniform_int_distribution<std::size_t>(0, pieces.size() - 1)(gen) ];
+                if( run % 2 ){
+                        auto pos = std::uniform_int_distribution<std::size_t>(0, s.size())(gen);
+                        s.insert(pos, poison[ std::uniform_int_distribution<std::size_t>(0, poison.size() - 1)(gen) ]);
+                }
+                EXPECT_EQ( reference(s), fast(s) ) << run;
+        }
+        // and random bytes
+        for( unsigned run = 0; run != 2000; ++run ){
+                std::string s;
+                std::size_t n = std::uniform_int_distribution<std::size_t>(0, 100)(gen);
+                for( std::size_t i = 0; i != n; ++i )
+                        s += static_cast<char>(std::uniform_int_distribution<int>(0x70, 0xFF)(gen));
+                EXPECT_EQ( reference(s), fast(s) ) << run;
+        }
+}
+
+TEST(utf8, parser){
+        parse_options opts;
+        opts.validate_utf8 = true;
+
+        std::string good = "[ \"caf\xC3\xA9\", \"\xF0\x9F\x98\x80\" ]";
+        std::string bad  = "[ \"caf\xC3\xA9\", \"ab\xED\xA0\x80\" ]";
+
+        variant::maker m;
+        basic_parser<variant::maker, std::string::const_iterator> p0(m, good.begin(), good.end(), opts);
+        parse_error err;
+        EXPECT_TRUE( p0.parse(err) );
+
+        basic_parser<variant::maker, std::string::const_iterator> p1(m, bad.begin(), bad.end(), opts);
+        EXPECT_FALSE( p1.parse(err) );
+        EXPECT_EQ( error_code::invalid_utf8, err.code );
+        EXPECT_EQ( bad.find('\xED'), err.offset );
+
+        // off by default
+        variant::maker m2;
+        basic_parser<variant::maker, std::string::const_iterator> p2(m2, bad.begin(), bad.end());
+        EXPECT_TRUE( p2.parse(err) );
+
+        // and split between chunks
+        for( std::size_t i = 0; i <= bad.size(); ++i ){
+                variant::maker m3;
+                basic_push_parser<variant::maker> p(m3, opts);
+                p.feed(bad.data(), i) && p.feed(bad.data() + i, bad.size() - i) && p.finish();
+                EXPECT_EQ( error_code::invalid_utf8, p.error().code ) << i;
+                EXPECT_EQ( bad.find('\xED'), p.error().offset ) << i;
+        }
+}
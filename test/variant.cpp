@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <unordered_map>
 #include <list>
+#include <unistd.h>
+#include <cstdlib>
 
 #include "gjson/basic_parser.h"
 #include "gjson/variant.h"
@@ -159,6 +161,61 @@ TEST_F( Parser, invalid_strings){
                 EXPECT_ANY_THROW( parse(str) );
         }
 }
+TEST_F( Parser, error_codes){
+        auto code = [](std::string const& s){
+                parse_error err;
+                EXPECT_FALSE( try_parse(s, err) ) << s;
+                return err.code;
+        };
+        EXPECT_EQ( error_code::expected_right_curl  , code("{") );
+        EXPECT_EQ( error_code::expected_right_br    , code(R"( [ 23 -3455 ] )") );
+        EXPECT_EQ( error_code::trailing_input       , code("{} 4") );
+        EXPECT_EQ( error_code::expected_map_or_array, code("23") );
+        EXPECT_EQ( error_code::expected_value       , code("[1,]") );
+        EXPECT_EQ( error_code::invalid_token        , code(R"( [ 23a ] )") );
+
+        parse_error err;
+        try_parse(R"( [ 23 -3455 ] )", err);
+        EXPECT_EQ( 6, err.offset );
+
+        try{
+                parse("{} 4");
+                FAIL();
+        } catch(parse_exception const& e){
+                EXPECT_EQ( error_code::trailing_input, e.error().code );
+                EXPECT_EQ( 3, e.error().offset );
+        }
+}
+TEST_F( Parser, parse_file){
+        char path[] = "/tmp/gjson_test_XXXXXX";
+        int fd = mkstemp(path);
+        ASSERT_GE( fd, 0 );
+        EXPECT_EQ( static_cast<ssize_t>(json_sample_text.size()),
+                   write(fd, json_sample_text.data(), json_sample_text.size()) );
+        close(fd);
+
+        EXPECT_EQ( to_string(parse(json_sample_text)), to_string(parse_file(path)) );
+
+        // empty file
+        truncate(path, 0);
+        parse_error err;
+        EXPECT_FALSE( try_parse_file(path, err) );
+        EXPECT_EQ( error_code::expected_map_or_array, err.code );
+
+        unlink(path);
+        EXPECT_FALSE( try_parse_file(path, err) );
+        EXPECT_EQ( error_code::io_error, err.code );
+        EXPECT_ANY_THROW( parse_file(path) );
+
+        // not a regular file, so its size means nothing
+        for(char const* special : {"/dev/null", "/proc/self/status", "/tmp"}){
+                EXPECT_FALSE( try_parse_file(special, err) ) << special;
+                EXPECT_EQ( error_code::io_error, err.code ) << special;
+        }
+        mapped_file file;
+        EXPECT_FALSE( file.open("/tmp") );
+        EXPECT_EQ( EISDIR, file.last_errno() );
+}
 TEST_F( Parser, to_string ){
         for( auto const& str : valid_strings ){
                 auto s = to_string( parse(str) );
@@ -0,0 +1,366 @@
+/*
+        Makes a header of structs, with a parser and serializer for each,
+        from a json description of them, ie
+                ./gjson_codegen messages.json messages.h
+
+        where messages.json is
+                {
+                        "namespace" : "msg",
+                        "types" : [
+                                { "name" : "leg", "fields" : [
+                                        { "name" : "qty", "type" : "int" },
+                                        { "name" : "venue", "type" : "string", "optional" : true }
+                                ] },
+                                { "name" : "order", "fields" : [
+                                        { "name" : "id", "type" : "int" },
+                                        { "name" : "legs", "type" : "[leg]" }
+                                ] }
+                        ]
+                }
+
+        The types are int, float, bool, string, one of the other types, or
+        [type] for an array of them. A field is the key in the json, and
+        the member unless "member" gives another name. Missing fields are
+        an error unless they're optional, a null is the same as a missing
+        field, and keys we don't know about are skipped. Each struct gets
+                template<class Tok> bool read(Tok& tok, T& out);
+                void write(std::string& out, T const& value);
+        which go through gjson/codegen.h, so it's gjson::codegen::parse and
+        gjson::codegen::to_json which you'd call
+ */
+#include "gjson/JsonObject.h"
+#include "gjson/codegen.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+using namespace gjson;
+
+namespace{
+        struct field_t{
+                std::string key;
+                std::string member;
+                // int, float, bool, string or a type name
+                std::string type;
+                // how many [] it's in
+                std::size_t arrays{0};
+                bool optional{false};
+        };
+        struct type_t{
+                std::string name;
+                std::vector<field_t> fields;
+                // the perfect hash, slot = key_hash(key, seed) & mask
+                std::uint32_t seed{0};
+                std::uint32_t mask{0};
+        };
+
+        void fail(std::string const& msg){
+                throw std::runtime_error(msg);
+        }
+
+        bool is_identifier(std::string const& s){
+                if( s.empty() || std::isdigit(static_cast<unsigned char>(s[0])) )
+                        return false;
+                return std::all_of(s.begin(), s.end(), [](char c){
+                        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+                });
+        }
+        // the ones which could turn up as a key
+        bool is_keyword(std::string const& s){
+                static std::set<std::string> const words = {
+                        "auto", "bool", "break", "case", "catch", "char", "class", "const", "continue",
+                        "default", "delete", "do", "double", "else", "enum", "explicit", "export", "extern",
+                        "false", "float", "for", "friend", "goto", "if", "inline", "int", "long", "namespace",
+                        "new", "operator", "private", "protected", "public", "register", "return", "short",
+                        "signed", "sizeof", "static", "struct", "switch", "template", "this", "throw", "true",
+                        "try", "typedef", "typename", "union", "unsigned", "using", "virtual", "void",
+                        "volatile", "while",
+                };
+                return words.count(s) != 0;
+        }
+        bool is_builtin(std::string const& type){
+                return type == "int" || type == "float" || type == "bool" || type == "string";
+        }
+
+        // a C++ string literal which is s, octal escapes can't run on like \x can
+        std::string literal(std::string const& s){
+                std::string out = "\"";
+                for(unsigned char c : s){
+                        if( c == '"' || c == '\\' ){
+                                out += '\\';
+                                out += static_cast<char>(c);
+                        } else if( c < 0x20 || c >= 0x7f ){
+                                char buf[8];
+                                std::snprintf(buf, sizeof(buf), "\\%03o", c);
+                                out += buf;
+                        } else {
+                                out += static_cast<char>(c);
+                        }
+                }
+                return out + "\"";
+        }
+
+        std::string cpp_type(field_t const& f){
+                std::string t;
+                if( f.type == "int" )
+                        t = "std::int64_t";
+                else if( f.type == "float" )
+                        t = "double";
+                else if( f.type == "bool" )
+                        t = "bool";
+                else if( f.type == "string" )
+                        t = "std::string";
+                else
+                        t = f.type;
+                for(std::size_t i=0;i!=f.arrays;++i)
+                        t = "std::vector<" + t + ">";
+                return t;
+        }
+
+        std::vector<type_t> read_schema(JsonObject const& schema){
+                std::vector<type_t> types;
+                std::set<std::string> names;
+                for(auto const& t : schema["types"]){
+                        type_t type;
+                        type.name = t["name"].AsString();
+                        if( ! is_identifier(type.name) || is_keyword(type.name) || is_builtin(type.name) )
+                                fail("bad type name " + type.name);
+                        if( ! names.insert(type.name).second )
+                                fail("two types called " + type.name);
+
+                        std::set<std::string> keys, members;
+                        for(auto const& f : t["fields"]){
+                                field_t field;
+                                field.key = f["name"].AsString();
+                                field.member = f.HasKey("member") ? f["member"].AsString() : field.key;
+                                field.optional = f.HasKey("optional") && f["optional"].AsBool();
+                                field.type = f["type"].AsString();
+                                while( field.type.size() > 2 && field.type.front() == '[' && field.type.back() == ']' ){
+                                        field.type = field.type.substr(1, field.type.size() - 2);
+                                        ++field.arrays;
+                                }
+                                if( ! is_identifier(field.member) || is_keyword(field.member) )
+                                        fail(type.name + "." + field.key + " isn't a C++ name, give it a member");
+                                if( ! keys.insert(field.key).second || ! members.insert(field.member).second )
+                                        fail("two fields called " + type.name + "." + field.key);
+                                type.fields.push_back(field);
+                        }
+                        if( type.fields.size() > 64 )
+                                fail(type.name + " has more than 64 fields");
+                        types.push_back(type);
+                }
+                for(auto const& type : types){
+                        for(auto const& f : type.fields){
+                                if( ! is_builtin(f.type) && ! names.count(f.type) )
+                                        fail(type.name + "." + f.key + " has unknown type " + f.type);
+                        }
+                }
+                return types;
+        }
+
+        /*
+                So each struct comes after the ones it holds. An array of
+                something not defined yet is fine, that's how a type can
+                hold itself, but holding it directly isn't
+         */
+        void sort_types(std::vector<type_t>& types){
+                std::map<std::string, type_t const*> by_name;
+                for(auto const& t : types)
+                        by_name[t.name] = &t;
+                std::vector<type_t> out;
+                std::set<std::string> done, doing;
+                std::function<void(type_t const&)> visit = [&](type_t const& t){
+                        if( done.count(t.name) )
+                                return;
+                        doing.insert(t.name);
+                        for(auto const& f : t.fields){
+                                if( is_builtin(f.type) )
+                                        continue;
+                                if( doing.count(f.type) ){
+                                        if( f.arrays == 0 )
+                                                fail(t.name + " holds itself through " + t.name + "." + f.key);
+                                        continue;
+                                }
+                                visit(*by_name[f.type]);
+                        }
+                        doing.erase(t.name);
+                        done.insert(t.name);
+                        out.push_back(t);
+                };
+                for(auto const& t : types)
+                        visit(t);
+                types = out;
+        }
+
+        // the smallest power of 2 table, then the first seed, with no two keys in a slot
+        void find_hash(type_t& type){
+                std::size_t size = 1;
+                while( size < type.fields.size() )
+                        size *= 2;
+                for(;; size *= 2){
+                        for(std::uint32_t seed = 0; seed != 100000; ++seed){
+                                std::vector<bool> used(size);
+                                bool ok = true;
+                                for(auto const& f : type.fields){
+                                        auto slot = codegen::key_hash(f.key, seed) & ( size - 1 );
+                                        if( used[slot] ){
+                                                ok = false;
+                                                break;
+                                        }
+                                        used[slot] = true;
+                                }
+                                if( ok ){
+                                        type.seed = seed;
+                                        type.mask = static_cast<std::uint32_t>(size - 1);
+                                        return;
+                                }
+                        }
+                }
+        }
+
+        void write_struct(std::ostream& ostr, type_t const& type){
+                ostr << "        struct " << type.name << "{\n";
+                for(auto const& f : type.fields){
+                        ostr << "                " << cpp_type(f) << " " << f.member;
+                        if( f.arrays == 0 && ( f.type == "int" || f.type == "float" || f.type == "bool" ) )
+                                ostr << "{}";
+                        ostr << ";\n";
+                }
+                ostr << "        };\n";
+        }
+
+        void write_read(std::ostream& ostr, type_t const& type){
+                std::uint64_t required = 0;
+                for(std::size_t i=0;i!=type.fields.size();++i){
+                        if( ! type.fields[i].optional )
+                                required |= std::uint64_t{1} << i;
+                }
+                std::map<std::uint32_t, std::size_t> slots;
+                for(std::size_t i=0;i!=type.fields.size();++i)
+                        slots[codegen::key_hash(type.fields[i].key, type.seed) & type.mask] = i;
+
+                ostr << "        template<class Tok>\n"
+                     << "        bool read(Tok& tok, " << type.name << "& out){\n"
+                     << "                std::uint64_t seen = 0;\n"
+                     << "                bool ok = gjson::codegen::read_map(tok, [&](std::string const& key){\n"
+                     << "                        switch( gjson::codegen::key_hash(key, " << type.seed << "u) & " << type.mask << "u ){\n";
+                for(auto const& s : slots){
+                        auto const& f = type.fields[s.second];
+                        ostr << "                        case " << s.first << ":\n"
+                             << "                                if( key == " << literal(f.key) << " ){\n";
+                        if( f.optional )
+                                ostr << "                                        if( gjson::codegen::read_null(tok) )\n"
+                                     << "                                                return true;\n";
+                        ostr << "                                        seen |= std::uint64_t{1} << " << s.second << ";\n";
+                        if( is_builtin(f.type) || f.arrays != 0 )
+                                ostr << "                                        return gjson::codegen::read(tok, out." << f.member << ");\n";
+                        else
+                                ostr << "                                        return read(tok, out." << f.member << ");\n";
+                        ostr << "                                }\n"
+                             << "                                break;\n";
+                }
+                ostr << "                        }\n"
+                     << "                        return gjson::codegen::skip(tok);\n"
+                     << "                });\n"
+                     << "                if( ok && ( seen & " << required << "ull ) != " << required << "ull ){\n"
+                     << "                        tok.fail(gjson::error_code::missing_field);\n"
+                     << "                        return false;\n"
+                     << "                }\n"
+                     << "                return ok;\n"
+                     << "        }\n";
+        }
+
+        void write_write(std::ostream& ostr, type_t const& type){
+                ostr << "        inline void write(std::string& out, " << type.name << " const& value){\n";
+                if( type.fields.empty() )
+                        ostr << "                out += \"{\";\n";
+                for(std::size_t i=0;i!=type.fields.size();++i){
+                        auto const& f = type.fields[i];
+                        std::string key = ( i == 0 ? "{" : "," ) + std::string("\"") + escape_string(f.key) + "\":";
+                        ostr << "                out += " << literal(key) << ";\n";
+                        if( is_builtin(f.type) || f.arrays != 0 )
+                                ostr << "                gjson::codegen::write(out, value." << f.member << ");\n";
+                        else
+                                ostr << "                write(out, value." << f.member << ");\n";
+                }
+                ostr << "                out += '}';\n"
+                     << "        }\n";
+        }
+
+        void write_header(std::ostream& ostr, std::string const& from, std::string const& ns, std::vector<type_t> const& types){
+                std::string guard = "GJSON_GENERATED_";
+                for(char c : ns + "_H")
+                        guard += std::isalnum(static_cast<unsigned char>(c)) ? static_cast<char>(std::toupper(c)) : '_';
+
+                ostr << "// made by gjson_codegen from " << from << ", don't edit\n"
+                     << "#ifndef " << guard << "\n"
+                     << "#define " << guard << "\n"
+                     << "\n"
+                     << "#include <cstdint>\n"
+                     << "#include <string>\n"
+                     << "#include <vector>\n"
+                     << "\n"
+                     << "#include \"gjson/codegen.h\"\n"
+                     << "\n"
+                     << "namespace " << ns << "{\n"
+                     << "\n";
+                for(auto const& t : types)
+                        ostr << "        struct " << t.name << ";\n";
+                for(auto const& t : types)
+                        ostr << "        template<class Tok> bool read(Tok& tok, " << t.name << "& out);\n";
+                for(auto const& t : types)
+                        ostr << "        inline void write(std::string& out, " << t.name << " const& value);\n";
+                for(auto const& t : types){
+                        ostr << "\n";
+                        write_struct(ostr, t);
+                }
+                for(auto const& t : types){
+                        ostr << "\n";
+                        write_read(ostr, t);
+                        ostr << "\n";
+                        write_write(ostr, t);
+                }
+                ostr << "\n"
+                     << "} // " << ns << "\n"
+                     << "#endif // " << guard << "\n";
+        }
+}
+
+int main(int argc, char** argv){
+        if( argc != 3 ){
+                std::cerr << "usage: " << argv[0] << " <schema.json> <out.h>\n";
+                return 1;
+        }
+        try{
+                std::ifstream in(argv[1]);
+                if( ! in )
+                        fail(std::string("can't open ") + argv[1]);
+                JsonObject schema;
+                schema.Parse(in);
+
+                auto ns = schema["namespace"].AsString();
+                if( ! is_identifier(ns) )
+                        fail("bad namespace " + ns);
+                auto types = read_schema(schema);
+                sort_types(types);
+                for(auto& t : types)
+                        find_hash(t);
+
+                std::ofstream out(argv[2]);
+                std::string from = argv[1];
+                write_header(out, from.substr(from.find_last_of('/') + 1), ns, types);
+                if( ! out )
+                        fail(std::string("can't write ") + argv[2]);
+        } catch(std::exception const& e){
+                std::cerr << argv[1] << ": " << e.what() << "\n";
+                return 1;
+        }
+        return 0;
+}